@@ -0,0 +1,21 @@
+# Native benchmark harness.  Build with 'make gild_bench', then run
+# './gild_bench --output results.json' from the build directory.
+set (HERE ${CMAKE_CURRENT_LIST_DIR})
+
+option(
+    ENABLE_BENCH
+    "Build the gild_bench native benchmark harness?"
+    ON
+)
+message(STATUS "option ENABLE_BENCH=" ${ENABLE_BENCH})
+
+if(${ENABLE_BENCH})
+    add_executable(${PROJECT_NAME}_bench
+        "${HERE}/gild_bench.cpp"
+        "${CMAKE_SOURCE_DIR}/count.cpp"
+        "${CMAKE_SOURCE_DIR}/count.h"
+        )
+    target_link_libraries(${PROJECT_NAME}_bench
+        PRIVATE ${PROJECT_NAME}_worker pybind11::embed)
+    AddClangFormat(${PROJECT_NAME}_bench)
+endif(${ENABLE_BENCH})
@@ -0,0 +1,67 @@
+"""
+Compare Executor.POOL (one shared queue) with Executor.STEALING
+(per-thread work-stealing deques) on no-op Count Jobs.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_executor.py [job_count ...]
+
+The default job counts are 10000 and 100000.  Each row is one
+executor at one thread count, from 1 up to the number of cores.
+"""
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import set_executor
+from gild import set_worker_count
+
+import multiprocessing
+import sys
+import timeit
+
+
+def thread_counts():
+    cores = multiprocessing.cpu_count()
+    result = []
+    count = 1
+    while count < cores:
+        result.append(count)
+        count *= 2
+    result.append(cores)
+    return result
+
+
+def bench(executor, workers, job_count):
+    set_executor(executor)
+    set_worker_count(workers)
+    input = Count(1, 1, 0)
+    start_time = timeit.default_timer()
+    jobs = [launch(input) for i in range(job_count)]
+    for job in jobs:
+        job.wait_for_result()
+    return timeit.default_timer() - start_time
+
+
+def main():
+    job_counts = [int(arg) for arg in sys.argv[1:]] or [10000, 100000]
+    old_executor = get_executor()
+    old_workers = get_worker_count()
+    print('{:<10} {:>8} {:>8} {:>12} {:>12}'.format(
+        'executor', 'threads', 'jobs', 'seconds', 'jobs/sec'))
+    try:
+        for job_count in job_counts:
+            for workers in thread_counts():
+                for executor in (Executor.POOL, Executor.STEALING):
+                    elapsed = bench(executor, workers, job_count)
+                    print('{:<10} {:>8} {:>8} {:>12.3f} {:>12.0f}'.format(
+                        executor.name, workers, job_count, elapsed,
+                        job_count / elapsed))
+    finally:
+        set_executor(old_executor)
+        set_worker_count(old_workers)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,77 @@
+"""
+Compare FileScan with counting lines through Python file I/O.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_file_scan.py [path] [chunk_size]
+
+Without a path, a 512 MB file of random-length lines is written to a
+temporary directory first.  Each case runs twice and the second
+(warm page cache) time is reported:
+
+  python        read the file in chunk_size blocks and count b'\\n'
+  lines         FileScan with ScanMode.LINES
+  bytes         FileScan with ScanMode.BYTES
+"""
+from gild import FileScan
+from gild import launch
+from gild import ScanMode
+
+import os
+import random
+import sys
+import tempfile
+import timeit
+
+
+def python_lines(path, chunk_size):
+    total = 0
+    with open(path, 'rb') as file:
+        while True:
+            block = file.read(chunk_size)
+            if not block:
+                return total
+            total += block.count(b'\n')
+
+
+def scan(path, mode, chunk_size):
+    job = launch(FileScan(path, mode, chunk_size))
+    if not job.wait_for_result(600):
+        raise RuntimeError('FileScan did not finish')
+    return job.output.total
+
+
+def write_file(path, size):
+    random.seed(1)
+    lines = b'\n'.join(b'x' * random.randrange(200) for i in range(100000))
+    with open(path, 'wb') as file:
+        for i in range(size // len(lines)):
+            file.write(lines)
+
+
+def main():
+    chunk_size = int(sys.argv[2]) if 2 < len(sys.argv) else 4 << 20
+    with tempfile.TemporaryDirectory() as directory:
+        path = sys.argv[1] if 1 < len(sys.argv) else None
+        if path is None:
+            path = os.path.join(directory, 'data')
+            write_file(path, 512 << 20)
+        size = os.path.getsize(path)
+        cases = [
+            ('python', lambda: python_lines(path, chunk_size)),
+            ('lines', lambda: scan(path, ScanMode.LINES, chunk_size)),
+            ('bytes', lambda: scan(path, ScanMode.BYTES, chunk_size)),
+        ]
+        print('{:<8} {:>12} {:>10} {:>8}'.format(
+            'mode', 'total', 'time (s)', 'MB/s'))
+        for name, run in cases:
+            run()
+            start_time = timeit.default_timer()
+            total = run()
+            elapsed = timeit.default_timer() - start_time
+            print('{:<8} {:>12} {:>10.3f} {:>8.0f}'.format(
+                name, total, elapsed, size / elapsed / 1e6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,73 @@
+"""
+Measure launch() throughput for each Executor, and launch_many()
+throughput on the default Executor.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_launch.py [job_count]
+
+Each Job counts from 1 to 1 with no delay, so the time is spent
+launching and running Jobs rather than doing work.
+"""
+from gild import Count
+from gild import Executor
+from gild import launch
+from gild import launch_many
+from gild import set_executor
+
+import sys
+import timeit
+
+
+def os_thread_count():
+    with open('/proc/self/status') as status:
+        for line in status:
+            if line.startswith('Threads:'):
+                return int(line.split()[1])
+    return 0
+
+
+def bench(executor, job_count):
+    set_executor(executor)
+    input = Count(1, 1, 0)
+    jobs = []
+    peak_threads = 0
+    start_time = timeit.default_timer()
+    for i in range(job_count):
+        jobs.append(launch(input))
+        if 0 == i % 100:
+            peak_threads = max(peak_threads, os_thread_count())
+    launched = timeit.default_timer() - start_time
+    for job in jobs:
+        job.wait_for_result()
+    finished = timeit.default_timer() - start_time
+    return launched, finished, peak_threads
+
+
+def bench_many(job_count):
+    set_executor(Executor.POOL)
+    inputs = [Count(1, 1, 0)] * job_count
+    start_time = timeit.default_timer()
+    group = launch_many(inputs)
+    launched = timeit.default_timer() - start_time
+    group.wait_for_result()
+    finished = timeit.default_timer() - start_time
+    return launched, finished, os_thread_count()
+
+
+def main():
+    job_count = int(sys.argv[1]) if 1 < len(sys.argv) else 1000
+    print('{:<10} {:>8} {:>14} {:>12} {:>8}'.format(
+        'executor', 'jobs', 'launches/sec', 'total (s)', 'threads'))
+    for executor in (Executor.THREAD, Executor.POOL):
+        launched, finished, threads = bench(executor, job_count)
+        print('{:<10} {:>8} {:>14.0f} {:>12.3f} {:>8}'.format(
+            executor.name, job_count, job_count / launched, finished,
+            threads))
+    launched, finished, threads = bench_many(job_count)
+    print('{:<10} {:>8} {:>14.0f} {:>12.3f} {:>8}'.format(
+        'MANY', job_count, job_count / launched, finished, threads))
+
+
+if __name__ == '__main__':
+    main()
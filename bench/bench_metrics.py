@@ -0,0 +1,52 @@
+"""
+Measure what the metrics counters cost a no-op Count Job.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_metrics.py [job_count]
+
+Reports nanoseconds per counter update (timed in C++), how many
+updates each Job makes, and what that adds up to next to the time
+a no-op Job takes end to end.
+"""
+from gild import Count
+from gild import _time_add_metric
+from gild import launch_many
+from gild import metrics
+
+import sys
+import timeit
+
+
+def main():
+    job_count = int(sys.argv[1]) if 1 < len(sys.argv) else 100000
+
+    per_update = min(_time_add_metric(10000000) for i in range(5))
+
+    before = metrics()
+    start_time = timeit.default_timer()
+    group = launch_many(Count(1, 1, 0) for i in range(job_count))
+    group.wait_for_result()
+    del group
+    per_job = (timeit.default_timer() - start_time) / job_count
+    after = metrics()
+
+    counters = [name for name in after if name.endswith(
+        ('created', 'launched', 'dequeued', 'completed', 'incomplete',
+         'aborted', 'destroyed'))]
+    updates = sum(after[name] - before[name] for name in counters)
+    updates_per_job = updates / job_count
+
+    print('{:<28} {:>12.2f}'.format('ns per counter update',
+                                    per_update * 1e9))
+    print('{:<28} {:>12.2f}'.format('counter updates per Job',
+                                    updates_per_job))
+    print('{:<28} {:>12.2f}'.format('ns of metrics per Job',
+                                    per_update * updates_per_job * 1e9))
+    print('{:<28} {:>12.0f}'.format('ns per no-op Job', per_job * 1e9))
+    print('{:<28} {:>11.3f}%'.format(
+        'metrics share', 100 * per_update * updates_per_job / per_job))
+
+
+if __name__ == '__main__':
+    main()
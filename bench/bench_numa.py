@@ -0,0 +1,94 @@
+"""
+Show the cost of running a memory-bound Job away from its memory.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_numa.py [megabytes] [repeats]
+
+For each NUMA node, a buffer of float64s is first written by the main
+thread pinned to that node, so the kernel puts its pages there.  A
+Reduce Job (which does little but stream the buffer through the CPUs)
+then sums it with every worker:
+
+  node N        Affinity.NODE, and the Job's numa_node set to N
+  any           Affinity.NONE, wherever the OS runs the threads
+  cpu           Affinity.CPU, one thread pinned to each CPU
+
+The best of 'repeats' runs is reported, in GB/s.  On a machine with a
+single NUMA node, only the local case exists; the rest show what
+pinning alone costs or saves.
+"""
+from gild import Affinity
+from gild import Executor
+from gild import launch
+from gild import numa_node_count
+from gild import numa_node_cpus
+from gild import Reduce
+from gild import set_affinity
+from gild import set_executor
+from gild import set_worker_count
+
+import array
+import os
+import sys
+import timeit
+
+
+def make_buffer(node, size):
+    """
+    Return a buffer whose pages were first touched on 'node'.
+    """
+    allowed = os.sched_getaffinity(0)
+    os.sched_setaffinity(0, numa_node_cpus(node))
+    try:
+        # bytes() comes from calloc, untouched; copying it in touches
+        # every page from this thread.
+        return array.array('d', bytes(size))
+    finally:
+        os.sched_setaffinity(0, allowed)
+
+
+def best_rate(data, repeats, node=None):
+    best = None
+    for i in range(repeats):
+        job_input = Reduce(data)
+        job_input.numa_node = node
+        start_time = timeit.default_timer()
+        job = launch(job_input)
+        if not job.wait_for_result(600):
+            raise RuntimeError('Reduce did not finish')
+        elapsed = timeit.default_timer() - start_time
+        best = elapsed if best is None else min(best, elapsed)
+    return len(data) * data.itemsize / best / 1e9
+
+
+def main():
+    size = (int(sys.argv[1]) if 1 < len(sys.argv) else 1024) << 20
+    repeats = int(sys.argv[2]) if 2 < len(sys.argv) else 5
+    nodes = numa_node_count()
+    set_executor(Executor.POOL)
+    set_worker_count(len(numa_node_cpus()))
+    if 1 == nodes:
+        print('One NUMA node: every run is local.')
+
+    print('{:<12} {:<10} {:>8}'.format('memory on', 'run on', 'GB/s'))
+    for memory_node in range(nodes):
+        data = make_buffer(memory_node, size)
+        set_affinity(Affinity.NODE)
+        for run_node in range(nodes):
+            rate = best_rate(data, repeats, run_node)
+            print('{:<12} {:<10} {:>8.2f}{}'.format(
+                'node {}'.format(memory_node), 'node {}'.format(run_node),
+                rate, '' if run_node == memory_node else '  (remote)'))
+        for name, affinity in (('any', Affinity.NONE),
+                               ('cpu', Affinity.CPU)):
+            set_affinity(affinity)
+            print('{:<12} {:<10} {:>8.2f}'.format(
+                'node {}'.format(memory_node), name,
+                best_rate(data, repeats)))
+        del data
+    set_affinity(Affinity.NONE)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,115 @@
+"""
+Compare PythonJob with plain threading.Thread running the same
+Python work.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_python_job.py [iterations] [job_count]
+
+Each Job (or thread) adds up 'iterations' numbers in Python:
+
+  threading     a threading.Thread running the loop
+  on_working    a PythonJob running the loop in on_working(), holding
+                the GIL for the whole Job
+  chunk=N       a PythonJob taking one step per on_step() call, N
+                steps for each acquisition of the GIL
+
+Alongside, the main thread counts how many times it can take the GIL
+(by sleeping for 0 s) while the work runs, to show how much smaller
+chunks share it.
+"""
+from gild import launch
+from gild import PythonJob
+
+import sys
+import threading
+import time
+import timeit
+
+
+def add_up(iterations):
+    total = 0
+    for i in range(iterations):
+        total += i
+    return total
+
+
+class LoopJob(PythonJob):
+
+    def __init__(self, iterations):
+        super().__init__()
+        self.iterations = iterations
+        self.total = 0
+
+    def on_working(self, token):
+        self.total = add_up(self.iterations)
+        return True
+
+
+class StepJob(PythonJob):
+
+    def __init__(self, iterations, chunk_size):
+        super().__init__()
+        self.chunk_size = chunk_size
+        self.remaining = iterations
+        self.total = 0
+
+    def on_step(self):
+        self.remaining -= 1
+        self.total += self.remaining
+        return 0 < self.remaining
+
+
+def run_threads(iterations, job_count):
+    threads = [threading.Thread(target=add_up, args=(iterations,))
+               for i in range(job_count)]
+    for thread in threads:
+        thread.start()
+    return lambda: any(thread.is_alive() for thread in threads)
+
+
+def run_jobs(make_job, job_count):
+    jobs = [launch(make_job()) for i in range(job_count)]
+    return lambda: not all(job.finished for job in jobs)
+
+
+def measure(start, job_count):
+    """
+    Return the seconds taken and the times the main thread got the
+    GIL per second.
+    """
+    start_time = timeit.default_timer()
+    busy = start()
+    turns = 0
+    while busy():
+        time.sleep(0)
+        turns += 1
+    elapsed = timeit.default_timer() - start_time
+    return elapsed, turns / elapsed
+
+
+def main():
+    iterations = int(sys.argv[1]) if 1 < len(sys.argv) else 100000
+    job_count = int(sys.argv[2]) if 2 < len(sys.argv) else 4
+    cases = [
+        ('threading', lambda: run_threads(iterations, job_count)),
+        ('on_working',
+         lambda: run_jobs(lambda: LoopJob(iterations), job_count)),
+    ]
+    for chunk_size in (1, 16, 256, 4096):
+        cases.append((
+            'chunk={}'.format(chunk_size),
+            lambda chunk_size=chunk_size: run_jobs(
+                lambda: StepJob(iterations, chunk_size), job_count)))
+
+    print('{:<12} {:>8} {:>12} {:>16} {:>16}'.format(
+        'mode', 'jobs', 'total (s)', 'iterations/sec', 'main turns/sec'))
+    for name, start in cases:
+        elapsed, turns = measure(start, job_count)
+        print('{:<12} {:>8} {:>12.3f} {:>16.0f} {:>16.0f}'.format(
+            name, job_count, elapsed, iterations * job_count / elapsed,
+            turns))
+
+
+if __name__ == '__main__':
+    main()
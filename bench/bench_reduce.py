@@ -0,0 +1,84 @@
+"""
+Measure Reduce throughput at each SimdLevel, and against NumPy when it
+is installed.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_reduce.py [items] [repeats]
+
+Each case reduces the same buffer of 'items' numbers, 'repeats' times,
+and reports the best time:
+
+  stats         count, sum, min and max
+  hist          the above plus a 100-bin histogram over a given range
+
+NumPy's figures (sum + min + max, and numpy.histogram) are single
+threaded; Reduce uses every worker.
+"""
+from gild import launch
+from gild import Reduce
+from gild import set_simd_level
+from gild import SimdLevel
+from gild import supported_simd_level
+
+import array
+import sys
+import timeit
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+def best_time(function, repeats):
+    best = None
+    for i in range(repeats):
+        start_time = timeit.default_timer()
+        function()
+        elapsed = timeit.default_timer() - start_time
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def run_reduce(data, **kwargs):
+    job = launch(Reduce(data, **kwargs))
+    if not job.wait_for_result(60):
+        raise RuntimeError('Reduce did not finish')
+
+
+def main():
+    items = int(sys.argv[1]) if 1 < len(sys.argv) else 10000000
+    repeats = int(sys.argv[2]) if 2 < len(sys.argv) else 5
+    print('{:<10} {:<8} {:<10} {:>12} {:>14}'.format(
+        'type', 'case', 'kernels', 'best (ms)', 'Mitems/sec'))
+
+    def report(typecode, case, kernels, elapsed):
+        print('{:<10} {:<8} {:<10} {:>12.2f} {:>14.0f}'.format(
+            typecode, case, kernels, elapsed * 1000, items / elapsed / 1e6))
+
+    levels = [level for level in
+              (SimdLevel.SCALAR, SimdLevel.AVX2, SimdLevel.AVX512)
+              if int(level) <= int(supported_simd_level())]
+    for typecode in ('d', 'f', 'i', 'q'):
+        data = array.array(typecode, (i % 1000 for i in range(items)))
+        for level in levels:
+            set_simd_level(level)
+            name = str(level).split('.')[-1]
+            report(typecode, 'stats', name,
+                   best_time(lambda: run_reduce(data), repeats))
+            report(typecode, 'hist', name,
+                   best_time(lambda: run_reduce(data, bins=100,
+                                                range=(0, 1000)),
+                             repeats))
+        if numpy is not None:
+            values = numpy.frombuffer(data, dtype=data.typecode)
+            report(typecode, 'stats', 'numpy', best_time(
+                lambda: (values.sum(), values.min(), values.max()), repeats))
+            report(typecode, 'hist', 'numpy', best_time(
+                lambda: numpy.histogram(values, 100, (0, 1000)), repeats))
+    set_simd_level(supported_simd_level())
+
+
+if __name__ == '__main__':
+    main()
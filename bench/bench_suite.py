@@ -0,0 +1,216 @@
+"""
+Benchmark suite for the gild module, with JSON output.
+
+Run from the build directory (where the gild module is):
+
+    python3 ../bench/bench_suite.py [--quick] [--output results.json]
+
+Measures, from Python:
+
+  launch_throughput  Jobs per second through launch() and launch_many()
+                     for each Executor, from 1 thread up to the cores
+  launch_latency     Time for launch() to return (the Job is in SETUP)
+  abort_latency      Time for abort() on a WORKING Job
+  wait_latency       Time from a Job finishing to wait_all() returning
+  gil_contention     How fast a pure-Python thread runs while the main
+                     thread launches Jobs, waits on them, or holds the
+                     GIL in C++
+
+Latencies are in seconds.  The native harness (gild_bench) measures
+the same things without the Python layer; compare the two to see what
+Python costs.
+"""
+from gild import block_for_one_second
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import set_executor
+from gild import set_worker_count
+from gild import State
+from gild import wait_all
+
+import argparse
+import json
+import multiprocessing
+import platform
+import threading
+import timeit
+
+
+def thread_counts():
+    cores = multiprocessing.cpu_count()
+    result = []
+    count = 1
+    while count < cores:
+        result.append(count)
+        count *= 2
+    result.append(cores)
+    return result
+
+
+def summarize(samples):
+    samples = sorted(samples)
+
+    def at(fraction):
+        return samples[min(len(samples) - 1, int(fraction * len(samples)))]
+
+    return {'count': len(samples), 'p50': at(0.5), 'p90': at(0.9),
+            'p99': at(0.99), 'max': samples[-1]}
+
+
+def bench_launch_throughput(job_count):
+    results = []
+    input = Count(1, 1, 0)
+    for executor in (Executor.POOL, Executor.STEALING):
+        set_executor(executor)
+        for workers in thread_counts():
+            set_worker_count(workers)
+
+            start_time = timeit.default_timer()
+            jobs = [launch(input) for i in range(job_count)]
+            wait_all(jobs)
+            launch_seconds = timeit.default_timer() - start_time
+            del jobs
+
+            start_time = timeit.default_timer()
+            group = launch_many(Count(1, 1, 0) for i in range(job_count))
+            group.wait_for_result()
+            many_seconds = timeit.default_timer() - start_time
+            del group
+
+            results.append({
+                'executor': executor.name,
+                'threads': workers,
+                'jobs': job_count,
+                'launch_jobs_per_second': job_count / launch_seconds,
+                'launch_many_jobs_per_second': job_count / many_seconds,
+            })
+    return results
+
+
+def bench_launch_latency(samples):
+    input = Count(1, 1, 0)
+    latencies = []
+    for i in range(samples):
+        start_time = timeit.default_timer()
+        job = launch(input)
+        latencies.append(timeit.default_timer() - start_time)
+        job.wait_for_result()
+    return summarize(latencies)
+
+
+def bench_abort_latency(samples):
+    latencies = []
+    for i in range(samples):
+        job = launch(Count(1, 100, 1000))
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        job.abort()
+        latencies.append(timeit.default_timer() - start_time)
+    return summarize(latencies)
+
+
+def bench_wait_latency(samples):
+    latencies = []
+    for i in range(samples):
+        start_time = timeit.default_timer()
+        job = launch(Count(1, 1, 1))
+        wait_all([job])
+        elapsed = timeit.default_timer() - start_time
+        # timings.total runs from launch until the Job finished, so
+        # the rest is (mostly) the time wait_all() took to notice.
+        latencies.append(max(0.0, elapsed - job.timings.total.total_seconds()))
+    return summarize(latencies)
+
+
+def bench_gil_contention(seconds):
+    """
+    Count how many loop iterations a pure-Python thread manages per
+    second while the main thread does different things.
+    """
+    def spin(stop, result):
+        count = 0
+        while not stop.is_set():
+            count += 1
+        result.append(count)
+
+    def measure(main_thread_work):
+        stop = threading.Event()
+        result = []
+        thread = threading.Thread(target=spin, args=(stop, result))
+        start_time = timeit.default_timer()
+        thread.start()
+        main_thread_work(start_time + seconds)
+        stop.set()
+        thread.join()
+        return result[0] / (timeit.default_timer() - start_time)
+
+    def idle(deadline):
+        while timeit.default_timer() < deadline:
+            threading.Event().wait(0.01)
+
+    def launching(deadline):
+        input = Count(1, 1, 0)
+        while timeit.default_timer() < deadline:
+            launch(input).wait_for_result()
+
+    def waiting(deadline):
+        job = launch(Count(1, 1, int(seconds * 1000) // 3))
+        job.wait_for_result()
+
+    def holding_gil(deadline):
+        block_for_one_second()
+
+    baseline = measure(idle)
+    results = {'idle_iterations_per_second': baseline}
+    for name, work in (('launching', launching), ('waiting', waiting),
+                       ('holding_gil', holding_gil)):
+        rate = measure(work)
+        results[name + '_iterations_per_second'] = rate
+        results[name + '_relative'] = rate / baseline
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('--quick', action='store_true',
+                        help='fewer samples, for a smoke test')
+    parser.add_argument('--output', help='write JSON here (default: stdout)')
+    args = parser.parse_args()
+    scale = 1 if args.quick else 10
+
+    old_executor = get_executor()
+    old_workers = get_worker_count()
+    results = {
+        'harness': 'bench_suite.py',
+        'python': platform.python_version(),
+        'cpu_count': multiprocessing.cpu_count(),
+        'quick': args.quick,
+        'units': 'seconds',
+    }
+    try:
+        results['launch_throughput'] = bench_launch_throughput(1000 * scale)
+        set_executor(old_executor)
+        set_worker_count(old_workers)
+        results['launch_latency'] = bench_launch_latency(100 * scale)
+        results['abort_latency'] = bench_abort_latency(10 * scale)
+        results['wait_latency'] = bench_wait_latency(50 * scale)
+        results['gil_contention'] = bench_gil_contention(1.0)
+    finally:
+        set_executor(old_executor)
+        set_worker_count(old_workers)
+
+    text = json.dumps(results, indent=2)
+    if args.output:
+        with open(args.output, 'w') as output:
+            output.write(text + '\n')
+    else:
+        print(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,362 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+//
+// Native benchmark harness for the worker library.
+//
+// Runs Jobs through the same launch() path the Python module uses,
+// in an embedded interpreter, and writes the results as JSON:
+//
+//     ./gild_bench [--quick] [--output results.json]
+//
+// bench/bench_suite.py measures the Python-side view (including GIL
+// contention) and writes the same kind of JSON.
+//
+#include "count.h"
+#include "worker/executor.h"
+#include "worker/init_worker.h"
+#include "worker/job.h"
+#include "worker/launch.h"
+
+#include "pybind11/include/pybind11/embed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+PYBIND11_EMBEDDED_MODULE(gild, module)
+{
+    worker::init_worker(module);
+    count::input::bind(module);
+    count::output::bind(module);
+}
+
+namespace
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    double seconds_since(clock_t::time_point start)
+    {
+        return std::chrono::duration<double>(clock_t::now() - start).count();
+    }
+
+    std::vector<std::size_t> thread_counts()
+    {
+        const auto cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::size_t> result;
+        for (std::size_t count = 1; count < cores; count *= 2)
+        {
+            result.push_back(count);
+        }
+        result.push_back(cores);
+        return result;
+    }
+
+    const char *executor_name(worker::executor_kind kind)
+    {
+        switch (kind)
+        {
+        case worker::executor_kind::thread:
+            return "THREAD";
+        case worker::executor_kind::stealing:
+            return "STEALING";
+        case worker::executor_kind::pool:
+            break;
+        }
+        return "POOL";
+    }
+
+    ///
+    /// \brief Percentiles of a set of samples, as a JSON object.
+    ///
+    std::string summarize(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        auto at = [&samples](double fraction) {
+            if (samples.empty())
+            {
+                return 0.0;
+            }
+            const auto index = std::min(
+                samples.size() - 1,
+                static_cast<std::size_t>(fraction * samples.size()));
+            return samples[index];
+        };
+        std::ostringstream out;
+        out << "{\"count\": " << samples.size() << ", \"p50\": " << at(0.5)
+            << ", \"p90\": " << at(0.9) << ", \"p99\": " << at(0.99)
+            << ", \"max\": " << (samples.empty() ? 0.0 : samples.back())
+            << "}";
+        return out.str();
+    }
+
+    worker::job &as_job(const pybind11::object &object)
+    {
+        return object.cast<worker::job &>();
+    }
+
+    // Like the bindings, these block only without the GIL: a Job (or
+    // a retiring worker) may need it to finish.
+
+    void resize_workers(std::size_t count)
+    {
+        pybind11::gil_scoped_release release;
+        worker::set_worker_count(count);
+    }
+
+    void wait_for(worker::job &job)
+    {
+        pybind11::gil_scoped_release release;
+        job.wait_for_result(-1);
+    }
+
+    /**
+     * @brief Jobs per second through launch() (and launch_many()),
+     *        for each executor and thread count.
+     */
+    std::string bench_throughput(std::size_t job_count)
+    {
+        count::input input(1, 1, 0);
+        std::ostringstream out;
+        out << "[";
+        auto first = true;
+        for (auto kind :
+             {worker::executor_kind::pool, worker::executor_kind::stealing})
+        {
+            worker::set_executor_kind(kind);
+            for (auto threads : thread_counts())
+            {
+                resize_workers(threads);
+
+                auto start = clock_t::now();
+                std::vector<pybind11::object> jobs;
+                jobs.reserve(job_count);
+                for (std::size_t i = 0; i < job_count; ++i)
+                {
+                    jobs.push_back(worker::launch(&input));
+                }
+                for (auto &job : jobs)
+                {
+                    wait_for(as_job(job));
+                }
+                const auto launch_seconds = seconds_since(start);
+                jobs.clear();
+
+                pybind11::list inputs;
+                for (std::size_t i = 0; i < job_count; ++i)
+                {
+                    inputs.append(pybind11::cast(input));
+                }
+                start = clock_t::now();
+                auto group = worker::launch_many(inputs);
+                group.attr("wait_for_result")();
+                const auto many_seconds = seconds_since(start);
+
+                out << (first ? "" : ",") << "\n    {\"executor\": \""
+                    << executor_name(kind) << "\", \"threads\": " << threads
+                    << ", \"jobs\": " << job_count
+                    << ", \"launch_jobs_per_second\": "
+                    << job_count / launch_seconds
+                    << ", \"launch_many_jobs_per_second\": "
+                    << job_count / many_seconds << "}";
+                first = false;
+            }
+        }
+        out << "\n  ]";
+        return out.str();
+    }
+
+    /**
+     * @brief Seconds per submit-and-run of an empty task, straight
+     *        through each executor, for each thread count.
+     */
+    std::string bench_executor_scaling(std::size_t task_count)
+    {
+        std::ostringstream out;
+        out << "[";
+        auto first = true;
+        for (auto kind :
+             {worker::executor_kind::pool, worker::executor_kind::stealing})
+        {
+            worker::set_executor_kind(kind);
+            for (auto threads : thread_counts())
+            {
+                resize_workers(threads);
+                auto &executor = worker::get_executor();
+                std::vector<worker::executor::task_t> tasks(task_count);
+                std::vector<std::future<void>> futures;
+                futures.reserve(task_count);
+                for (auto &task : tasks)
+                {
+                    task = worker::executor::task_t([] {});
+                    futures.push_back(task.get_future());
+                }
+
+                pybind11::gil_scoped_release release;
+                const auto start = clock_t::now();
+                executor.submit_many(tasks, worker::task_schedule());
+                for (auto &future : futures)
+                {
+                    future.wait();
+                }
+                const auto elapsed = seconds_since(start);
+
+                out << (first ? "" : ",") << "\n    {\"executor\": \""
+                    << executor_name(kind) << "\", \"threads\": " << threads
+                    << ", \"tasks\": " << task_count
+                    << ", \"tasks_per_second\": " << task_count / elapsed
+                    << "}";
+                first = false;
+            }
+        }
+        out << "\n  ]";
+        return out.str();
+    }
+
+    /**
+     * @brief Time for launch() to return, which is once the Job has
+     *        reached SETUP.
+     */
+    std::string bench_launch_latency(std::size_t samples)
+    {
+        count::input input(1, 1, 0);
+        std::vector<double> latencies;
+        for (std::size_t i = 0; i < samples; ++i)
+        {
+            const auto start = clock_t::now();
+            auto job = worker::launch(&input);
+            latencies.push_back(seconds_since(start));
+            wait_for(as_job(job));
+        }
+        return summarize(latencies);
+    }
+
+    /**
+     * @brief Time for abort() to return on a Job that is WORKING.
+     */
+    std::string bench_abort_latency(std::size_t samples)
+    {
+        count::input input(1, 100, 1000);
+        std::vector<double> latencies;
+        for (std::size_t i = 0; i < samples; ++i)
+        {
+            auto object = worker::launch(&input);
+            auto &job = as_job(object);
+            while (worker::state::working != job.get_state())
+            {
+                std::this_thread::yield();
+            }
+            pybind11::gil_scoped_release release;
+            const auto start = clock_t::now();
+            job.abort(-1);
+            latencies.push_back(seconds_since(start));
+        }
+        return summarize(latencies);
+    }
+
+    /**
+     * @brief Time from a Job finishing to wait_for_result() returning.
+     */
+    std::string bench_wait_latency(std::size_t samples)
+    {
+        count::input input(1, 1, 1);
+        std::vector<double> latencies;
+        for (std::size_t i = 0; i < samples; ++i)
+        {
+            auto object = worker::launch(&input);
+            auto &job = as_job(object);
+            wait_for(job);
+            const auto finished =
+                worker::job::clock_t::time_point{job.control->finished};
+            latencies.push_back(
+                std::chrono::duration<double>(clock_t::now() - finished)
+                    .count());
+        }
+        return summarize(latencies);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto quick = false;
+    std::string output_path;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == std::strcmp(argv[i], "--quick"))
+        {
+            quick = true;
+        }
+        else if (0 == std::strcmp(argv[i], "--output") && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--quick] [--output results.json]\n";
+            return 2;
+        }
+    }
+
+    pybind11::scoped_interpreter interpreter;
+    pybind11::module::import("gild");
+
+    const auto old_kind = worker::get_executor_kind();
+    const auto old_count = worker::get_worker_count();
+    const std::size_t scale = quick ? 1 : 10;
+
+    std::ostringstream json;
+    json << "{\n  \"harness\": \"gild_bench\",\n  \"hardware_concurrency\": "
+         << std::thread::hardware_concurrency() << ",\n  \"quick\": "
+         << (quick ? "true" : "false") << ",\n  \"units\": \"seconds\",\n";
+    json << "  \"launch_throughput\": " << bench_throughput(1000 * scale)
+         << ",\n";
+    json << "  \"executor_scaling\": "
+         << bench_executor_scaling(10000 * scale) << ",\n";
+
+    worker::set_executor_kind(old_kind);
+    resize_workers(old_count);
+    json << "  \"launch_latency\": " << bench_launch_latency(100 * scale)
+         << ",\n";
+    json << "  \"abort_latency\": " << bench_abort_latency(10 * scale)
+         << ",\n";
+    json << "  \"wait_latency\": " << bench_wait_latency(50 * scale)
+         << "\n}\n";
+
+    if (output_path.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream(output_path) << json.str();
+    }
+    return 0;
+}
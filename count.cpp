@@ -1,14 +1,36 @@
 #include "count.h"
+#include "worker/dispatcher.h"
 
+#include <algorithm>
 #include <chrono>
 #include <sstream>
+#include <stdexcept>
 #include <thread>
 
 pybind11::module &count::output::bind(pybind11::module &module)
 {
-    pybind11::class_<output, std::shared_ptr<output>> obj(module,
-                                                          "CountOutput");
-    obj.def(pybind11::init<>());
+    pybind11::class_<output, worker::stream_output<int>,
+                     std::shared_ptr<output>>
+        obj(module, "CountOutput", pybind11::buffer_protocol(), R"pbdoc(
+Output of a Count job.
+
+.last is the most recent number counted.  Every number counted is
+also streamed; collect them with .drain().
+
+If the Count was launched with .record set, every number counted is
+also kept, and the output supports the buffer protocol:
+memoryview(output) or numpy.asarray(output) is a read-only view of
+the numbers counted so far, without a copy.  A view taken while the
+Job is WORKING does not grow; take another to see newer numbers.
+)pbdoc");
+    obj.def(pybind11::init<std::size_t, worker::overflow_policy, std::size_t>(),
+            pybind11::arg("stream_capacity") = 1024,
+            pybind11::arg("overflow") = worker::overflow_policy::drop_oldest,
+            pybind11::arg("record_capacity") = 0);
+    obj.def_buffer([](output &arg) { return arg.values.view(); });
+    obj.def_property_readonly(
+        "recorded", [](const output &arg) { return arg.values.size(); },
+        "The number of values recorded so far");
     obj.def_property_readonly(
         "last", [](const output &arg) { return static_cast<int>(arg.last); },
         "The last number counted by the job thread");
@@ -43,27 +65,52 @@ then the job will fail at the end of the respective state.
         )pbdoc");
     obj.def(pybind11::init<int, int, int>(), pybind11::arg("start") = 1,
             pybind11::arg("end") = 100, pybind11::arg("delay_ms") = 1000);
-    obj.def_readwrite("start", &input::start,
+    worker::def_field(obj, "start", &input::start,
                       "The number to start counting from (inclusive)");
-    obj.def_readwrite("end", &input::end,
+    worker::def_field(obj, "end", &input::end,
                       "The final number in the counting sequence(inclusive)");
-    obj.def_readwrite(
-        "delay_ms", &input::delay_ms,
+    worker::def_field(
+        obj, "delay_ms", &input::delay_ms,
         "The sleep time in ms to be used in SETUP, WORKING, and TEARDOWN");
-    obj.def_readwrite(
-        "fail_after", &input::fail_after,
+    worker::def_field(
+        obj, "fail_after", &input::fail_after,
         "If set to SETUP, WORKING, or TEARDOWN, that state will fail.");
+    worker::def_field(obj, "stream_capacity", &input::stream_capacity,
+                      "The most counted numbers held for output.drain()");
+    worker::def_field(
+        obj, "overflow", &input::overflow,
+        "The OverflowPolicy used when output.drain() falls behind");
+    worker::def_field(
+        obj, "record", &input::record,
+        "If True, keep every number counted in the output's buffer");
     return module;
 }
 
 worker::job_data count::input::get_job_data() const
 {
-    auto output_data = std::make_shared<output>();
+    // The job runs from this snapshot, even if Python sets a field
+    // (from another thread) while it is made.
+    const auto fields = worker::copy_fields(*this);
+    if (fields.stream_capacity < 1)
+    {
+        throw std::invalid_argument("stream_capacity must be at least 1");
+    }
+    std::size_t record_capacity = 0;
+    if (fields.record && fields.start <= fields.end)
+    {
+        record_capacity =
+            static_cast<std::size_t>(static_cast<long long>(fields.end) -
+                                     static_cast<long long>(fields.start) + 1);
+    }
+    auto output_data = std::allocate_shared<output>(
+        worker::pool_allocator<output>(),
+        static_cast<std::size_t>(fields.stream_capacity), fields.overflow,
+        record_capacity);
     auto runnable_object =
-        std::make_unique<count::runnable>(*this, output_data);
+        std::make_unique<count::runnable>(fields, output_data);
 
     worker::job_data result = {};
-    result.python_input = pybind11::cast(*this);
+    result.python_input = pybind11::cast(fields);
     result.python_output = pybind11::cast(output_data);
     result.runnable_object = std::move(runnable_object);
     return std::move(result);
@@ -76,38 +123,366 @@ std::string count::input::get_repr() const
 
 std::string count::input::get_str() const
 {
+    const auto fields = worker::copy_fields(*this);
     std::stringstream sstr;
-    sstr << "(start=" << start << ", end=" << end << ", delay_ms=" << delay_ms
-         << ")";
+    sstr << "(start=" << fields.start << ", end=" << fields.end
+         << ", delay_ms=" << fields.delay_ms << ")";
     return std::move(sstr.str());
 }
 
-bool count::runnable::on_setup()
+bool count::runnable::on_setup(const worker::cancellation_token &cancellation)
 {
     // Simulate setup happening.
-    std::this_thread::sleep_for(std::chrono::milliseconds(m_input.delay_ms));
+    if (!cancellation.sleep_for(std::chrono::milliseconds(m_input.delay_ms)))
+    {
+        return false;
+    }
     return m_input.fail_after != worker::state::setup;
 }
 
-bool count::runnable::on_working(std::atomic_flag &keep_working)
+bool count::runnable::on_working(
+    const worker::cancellation_token &cancellation)
 {
     for (auto i = m_input.start; i <= m_input.end; ++i)
     {
         m_output->last = i;
-        if (!keep_working.test_and_set())
+        worker::report_progress(i);
+        m_output->values.append(i);
+        m_output->push(i, [&cancellation] {
+            return !cancellation.stop_requested();
+        });
+        if (!cancellation.sleep_for(
+                std::chrono::milliseconds(m_input.delay_ms)))
         {
             // Told to abort what we were doing and stop!
             return false;
         }
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(m_input.delay_ms));
     }
     return m_input.fail_after != worker::state::working;
 }
 
-bool count::runnable::on_teardown()
+bool count::runnable::on_teardown(
+    const worker::cancellation_token &cancellation)
 {
-    // Simulate teardown happening.
-    std::this_thread::sleep_for(std::chrono::milliseconds(m_input.delay_ms));
+    // Simulate teardown happening, cut short if aborted.
+    cancellation.sleep_for(std::chrono::milliseconds(m_input.delay_ms));
     return m_input.fail_after != worker::state::teardown;
 }
+
+namespace
+{
+    class source_stage : public worker::pipeline_stage<int>
+    {
+    public:
+        explicit source_stage(count::source input_data)
+            : worker::pipeline_stage<int>(), m_input(input_data)
+        {
+        }
+
+        virtual bool
+        on_stage(worker::stage_queue<int> *, worker::stage_queue<int> &output,
+                 const worker::cancellation_token &cancellation) override
+        {
+            // Without a delay, write whole batches.  With one, write
+            // each number as it is counted.
+            const auto batch_size =
+                0 < m_input.delay_ms ? 1 : output.batch_size();
+            std::vector<int> batch;
+            batch.reserve(batch_size);
+            for (auto i = m_input.start; i <= m_input.end; ++i)
+            {
+                batch.push_back(i);
+                if (batch.size() == batch_size || i == m_input.end)
+                {
+                    if (!output.write(batch.data(), batch.size(),
+                                      cancellation))
+                    {
+                        return false;
+                    }
+                    batch.clear();
+                }
+                if (!cancellation.sleep_for(
+                        std::chrono::milliseconds(m_input.delay_ms)))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        count::source m_input;
+    };
+
+    class scale_stage : public worker::batch_stage<int>
+    {
+    public:
+        explicit scale_stage(int factor)
+            : worker::batch_stage<int>(), m_factor(factor)
+        {
+        }
+
+        virtual void on_batch(const int *items, std::size_t count,
+                              std::vector<int> &results) override
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                results.push_back(items[i] * m_factor);
+            }
+        }
+
+    private:
+        int m_factor;
+    };
+
+    class sum_stage : public worker::batch_stage<int>
+    {
+    public:
+        virtual void on_batch(const int *items, std::size_t count,
+                              std::vector<int> &) override
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                m_total += items[i];
+            }
+        }
+
+        virtual void on_end(std::vector<int> &results) override
+        {
+            results.push_back(m_total);
+        }
+
+    private:
+        int m_total = 0;
+    };
+}
+
+pybind11::module &count::source::bind(pybind11::module &module)
+{
+    pybind11::class_<source, worker::stage_input<int>, std::shared_ptr<source>>
+        obj(module, "CountSource", R"pbdoc(
+Pipeline stage that counts from .start to .end (inclusive).
+
+It must be the first stage.  With a .delay_ms, it sleeps that long
+after each number and passes numbers on one at a time; without, it
+passes them on in batches.
+)pbdoc");
+    obj.def(pybind11::init<int, int, int>(), pybind11::arg("start") = 1,
+            pybind11::arg("end") = 100, pybind11::arg("delay_ms") = 0);
+    worker::def_field(obj, "start", &source::start,
+                      "The number to start counting from (inclusive)");
+    worker::def_field(obj, "end", &source::end,
+                      "The final number in the counting sequence (inclusive)");
+    worker::def_field(obj, "delay_ms", &source::delay_ms,
+                      "The sleep time in ms after each number");
+    return module;
+}
+
+std::unique_ptr<worker::pipeline_stage<int>>
+count::source::create_stage() const
+{
+    return std::make_unique<source_stage>(worker::copy_fields(*this));
+}
+
+std::string count::source::get_repr() const
+{
+    const auto fields = worker::copy_fields(*this);
+    std::stringstream sstr;
+    sstr << "CountSource(start=" << fields.start << ", end=" << fields.end
+         << ", delay_ms=" << fields.delay_ms << ")";
+    return sstr.str();
+}
+
+pybind11::module &count::scale::bind(pybind11::module &module)
+{
+    pybind11::class_<scale, worker::stage_input<int>, std::shared_ptr<scale>>
+        obj(module, "CountScale", R"pbdoc(
+Pipeline stage that multiplies every number by .factor.
+)pbdoc");
+    obj.def(pybind11::init<int>(), pybind11::arg("factor"));
+    worker::def_field(obj, "factor", &scale::factor, "The multiplier");
+    return module;
+}
+
+std::unique_ptr<worker::pipeline_stage<int>>
+count::scale::create_stage() const
+{
+    return std::make_unique<scale_stage>(
+        worker::get_field(*this, &scale::factor));
+}
+
+std::string count::scale::get_repr() const
+{
+    return "CountScale(factor=" +
+           std::to_string(worker::get_field(*this, &scale::factor)) + ")";
+}
+
+pybind11::module &count::sum::bind(pybind11::module &module)
+{
+    pybind11::class_<sum, worker::stage_input<int>, std::shared_ptr<sum>> obj(
+        module, "CountSum", R"pbdoc(
+Pipeline stage that adds up every number and passes on only the
+total, once the stage before it has finished.
+)pbdoc");
+    obj.def(pybind11::init<>());
+    return module;
+}
+
+std::unique_ptr<worker::pipeline_stage<int>> count::sum::create_stage() const
+{
+    return std::make_unique<sum_stage>();
+}
+
+std::string count::sum::get_repr() const { return "CountSum()"; }
+
+namespace
+{
+    /// @brief Numbers summed between checks for an abort.
+    const std::int64_t SUM_BLOCK_SIZE = 1 << 16;
+
+    class sum_body : public worker::range_body<std::int64_t>
+    {
+    public:
+        sum_body(int delay_ms, std::shared_ptr<count::parallel_output> output)
+            : worker::range_body<std::int64_t>(), m_delay_ms(delay_ms),
+              m_output(std::move(output))
+        {
+        }
+
+        virtual std::int64_t identity() const override { return 0; }
+
+        virtual std::int64_t
+        on_chunk(std::int64_t begin, std::int64_t end,
+                 const worker::cancellation_token &cancellation) override
+        {
+            m_output->chunks.fetch_add(1, std::memory_order_relaxed);
+            m_output->add_thread();
+            std::int64_t total = 0;
+            auto i = begin;
+            while (i < end && !cancellation.stop_requested())
+            {
+                const auto last = std::min(end, i + SUM_BLOCK_SIZE);
+                for (; i < last; ++i)
+                {
+                    total += i;
+                }
+            }
+            // Simulate slower work, cut short if aborted.
+            cancellation.sleep_for(std::chrono::milliseconds(m_delay_ms));
+            return total;
+        }
+
+        virtual std::int64_t reduce(const std::int64_t &left,
+                                    const std::int64_t &right) const override
+        {
+            return left + right;
+        }
+
+        virtual bool on_result(const std::int64_t &result) override
+        {
+            m_output->total = result;
+            return true;
+        }
+
+    private:
+        const int m_delay_ms;
+        const std::shared_ptr<count::parallel_output> m_output;
+    };
+}
+
+void count::parallel_output::add_thread()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threads.insert(std::this_thread::get_id());
+}
+
+std::size_t count::parallel_output::thread_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_threads.size();
+}
+
+pybind11::module &count::parallel_output::bind(pybind11::module &module)
+{
+    pybind11::class_<parallel_output, std::shared_ptr<parallel_output>> obj(
+        module, "CountParallelOutput");
+    obj.def_property_readonly(
+        "total",
+        [](const parallel_output &arg) {
+            return static_cast<std::int64_t>(arg.total);
+        },
+        "The sum of the range, once the job has completed");
+    obj.def_property_readonly(
+        "chunks",
+        [](const parallel_output &arg) {
+            return static_cast<std::int64_t>(arg.chunks);
+        },
+        "The number of chunks the range was split into so far");
+    obj.def_property_readonly("threads", &parallel_output::thread_count,
+                              "The number of threads that ran chunks");
+    return module;
+}
+
+pybind11::module &count::parallel_input::bind(pybind11::module &module)
+{
+    pybind11::class_<parallel_input, worker::input> obj(
+        module, "CountParallel", R"pbdoc(
+Asynchronous C++ job that adds up the numbers from .start to .end
+(inclusive), split across every worker thread.
+
+The range is claimed in chunks, large at first and shrinking to
+.min_chunk numbers as it runs out, by the Job's thread and by helper
+tasks on the other threads of the Executor.  Each chunk sleeps for
+.delay_ms afterwards, to simulate slower work.  The partial sums are
+added up when the chunks are done, and output.total set.
+
+Progress (see Job.on_progress()) is the count of numbers added so
+far.  Aborting the Job stops every chunk.
+)pbdoc");
+    obj.def(pybind11::init<int, int, int, int>(), pybind11::arg("start") = 1,
+            pybind11::arg("end") = 1000000, pybind11::arg("min_chunk") = 1000,
+            pybind11::arg("delay_ms") = 0);
+    worker::def_field(obj, "start", &parallel_input::start,
+                      "The first number to add (inclusive)");
+    worker::def_field(obj, "end", &parallel_input::end,
+                      "The last number to add (inclusive)");
+    worker::def_field(obj, "min_chunk", &parallel_input::min_chunk,
+                      "The fewest numbers claimed as one chunk");
+    worker::def_field(obj, "delay_ms", &parallel_input::delay_ms,
+                      "The sleep time in ms after each chunk");
+    return module;
+}
+
+worker::job_data count::parallel_input::get_job_data() const
+{
+    const auto fields = worker::copy_fields(*this);
+    if (fields.min_chunk < 1)
+    {
+        throw std::invalid_argument("min_chunk must be at least 1");
+    }
+    auto output_data = std::make_shared<parallel_output>();
+    worker::job_data result = {};
+    result.python_input = pybind11::cast(fields);
+    result.python_output = pybind11::cast(output_data);
+    result.runnable_object =
+        std::make_unique<worker::parallel_range_runnable<std::int64_t>>(
+            fields.start, static_cast<std::int64_t>(fields.end) + 1,
+            std::make_unique<sum_body>(fields.delay_ms, output_data),
+            fields.min_chunk);
+    return result;
+}
+
+std::string count::parallel_input::get_repr() const
+{
+    return std::string("CountParallel") + get_str();
+}
+
+std::string count::parallel_input::get_str() const
+{
+    const auto fields = worker::copy_fields(*this);
+    std::stringstream sstr;
+    sstr << "(start=" << fields.start << ", end=" << fields.end
+         << ", min_chunk=" << fields.min_chunk
+         << ", delay_ms=" << fields.delay_ms << ")";
+    return sstr.str();
+}
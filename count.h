@@ -2,16 +2,33 @@
 #define COUNT_H
 
 #include "worker/input.h"
+#include "worker/parallel_range.h"
+#include "worker/pipeline.h"
+#include "worker/result_buffer.h"
+#include "worker/stream_output.h"
 
 #include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <set>
 #include <thread>
 
 namespace count
 {
 
-    struct output
+    struct output : public worker::stream_output<int>
     {
+        explicit output(std::size_t stream_capacity = 1024,
+                        worker::overflow_policy overflow =
+                            worker::overflow_policy::drop_oldest,
+                        std::size_t record_capacity = 0)
+            : worker::stream_output<int>(stream_capacity, overflow),
+              values(record_capacity)
+        {
+        }
+
         std::atomic<int> last = {0};
+        worker::result_buffer<int> values;
         static pybind11::module &bind(pybind11::module &module);
     };
 
@@ -28,6 +45,102 @@ namespace count
 
         worker::state fail_after = worker::state::incomplete;
 
+        int stream_capacity = 1024;
+        worker::overflow_policy overflow = worker::overflow_policy::drop_oldest;
+        bool record = false;
+
+        virtual worker::job_data get_job_data() const override;
+        virtual std::string get_repr() const override;
+        virtual std::string get_str() const override;
+        static pybind11::module &bind(pybind11::module &module);
+    };
+
+    ///
+    /// \brief Pipeline stage that counts from start to end.
+    ///
+    struct source : public worker::stage_input<int>
+    {
+        source(int start_, int end_, int delay_ms_)
+            : start(start_), end(end_), delay_ms(delay_ms_)
+        {
+        }
+
+        int start;
+        int end;
+        int delay_ms;
+
+        virtual std::unique_ptr<worker::pipeline_stage<int>>
+        create_stage() const override;
+        virtual std::string get_repr() const override;
+        static pybind11::module &bind(pybind11::module &module);
+    };
+
+    ///
+    /// \brief Pipeline stage that multiplies every number by a factor.
+    ///
+    struct scale : public worker::stage_input<int>
+    {
+        explicit scale(int factor_) : factor(factor_) {}
+
+        int factor;
+
+        virtual std::unique_ptr<worker::pipeline_stage<int>>
+        create_stage() const override;
+        virtual std::string get_repr() const override;
+        static pybind11::module &bind(pybind11::module &module);
+    };
+
+    ///
+    /// \brief Pipeline stage that adds up every number, writing only
+    ///        the total.
+    ///
+    struct sum : public worker::stage_input<int>
+    {
+        virtual std::unique_ptr<worker::pipeline_stage<int>>
+        create_stage() const override;
+        virtual std::string get_repr() const override;
+        static pybind11::module &bind(pybind11::module &module);
+    };
+
+    ///
+    /// \brief Output of a job that adds up a range on every worker.
+    ///
+    struct parallel_output
+    {
+        /// @brief The sum, set when the job completes.
+        std::atomic<std::int64_t> total = {0};
+        /// @brief The chunks the range was split into.
+        std::atomic<std::int64_t> chunks = {0};
+
+        /// @brief Record that the calling thread ran a chunk.
+        void add_thread();
+        /// @brief The number of threads that ran chunks.
+        std::size_t thread_count() const;
+
+        static pybind11::module &bind(pybind11::module &module);
+
+    private:
+        mutable std::mutex m_mutex = {};
+        std::set<std::thread::id> m_threads = {};
+    };
+
+    ///
+    /// \brief Input for a job that adds up the numbers from start to
+    ///        end, split across every worker thread.
+    ///
+    struct parallel_input : public worker::input
+    {
+        parallel_input(int start_, int end_, int min_chunk_, int delay_ms_)
+            : start(start_), end(end_), min_chunk(min_chunk_),
+              delay_ms(delay_ms_)
+        {
+        }
+
+        int start;
+        int end;
+        int min_chunk;
+        int delay_ms;
+
         virtual worker::job_data get_job_data() const override;
         virtual std::string get_repr() const override;
         virtual std::string get_str() const override;
@@ -42,9 +155,12 @@ namespace count
         {
         }
 
-        virtual bool on_setup() override;
-        virtual bool on_working(std::atomic_flag &keep_working) override;
-        virtual bool on_teardown() override;
+        virtual bool
+        on_setup(const worker::cancellation_token &cancellation) override;
+        virtual bool
+        on_working(const worker::cancellation_token &cancellation) override;
+        virtual bool
+        on_teardown(const worker::cancellation_token &cancellation) override;
 
     private:
         input m_input;
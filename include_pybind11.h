@@ -6,3 +6,10 @@
 #include "pybind11/include/pybind11/pybind11.h"
 #include "pybind11/include/pybind11/chrono.h"
 #pragma GCC diagnostic pop
+
+// 2.13 is the first pybind11 that is safe to use without the GIL (on
+// free-threaded builds of Python), and has mod_gil_not_used().
+#if PYBIND11_VERSION_MAJOR < 2 ||                                          \
+    (PYBIND11_VERSION_MAJOR == 2 && PYBIND11_VERSION_MINOR < 13)
+#error "pybind11 2.13 or later is needed: git submodule update --remote"
+#endif
@@ -30,7 +30,9 @@ void sleep_for_one_second()
     std::this_thread::sleep_for(std::chrono::seconds(1));
 }
 
-PYBIND11_MODULE(gild, module)
+// Nothing Python threads share relies on the GIL, so a free-threaded
+// interpreter can leave it off when we are imported.
+PYBIND11_MODULE(gild, module, pybind11::mod_gil_not_used())
 {
     module.doc() = R"pbdoc(
 Proof of concept demo for threading with pybind11 and the GIL.
@@ -47,7 +49,9 @@ Proof of concept demo for threading with pybind11 and the GIL.
     module.def("block_for_one_second", &block_for_one_second, R"pbdoc(
 Demonstrate that if the GIL is not released, a C++ function
 will block Python from doing anything else (including other
-C++ methods) until the function is complete.
+C++ methods) until the function is complete.  On a free-threaded
+build of Python there is no GIL to keep, so it blocks only the
+calling thread.
 
 Parameters
 ----------
@@ -75,4 +79,9 @@ None
     worker::init_worker(module);
     count::input::bind(module);
     count::output::bind(module);
+    count::parallel_input::bind(module);
+    count::parallel_output::bind(module);
+    count::source::bind(module);
+    count::scale::bind(module);
+    count::sum::bind(module);
 }
@@ -0,0 +1,59 @@
+from gild import Count
+from gild import launch
+from gild import State
+
+import timeit
+import unittest
+
+
+def percentile(sorted_values, fraction):
+    index = min(len(sorted_values) - 1, int(fraction * len(sorted_values)))
+    return sorted_values[index]
+
+
+class TestAbort(unittest.TestCase):
+
+    def abort_latencies(self, wait_for_state):
+        """
+        Abort Jobs that sleep 1 s per step, once they reach the given
+        state, and return the sorted times abort() took.
+        """
+        latencies = []
+        for i in range(50):
+            job = launch(Count(1, 100, 1000))
+            while job.state != wait_for_state:
+                pass
+            start_time = timeit.default_timer()
+            self.assertEqual(True, job.abort())
+            latencies.append(timeit.default_timer() - start_time)
+            self.assertEqual(job.state, State.INCOMPLETE)
+        latencies.sort()
+        return latencies
+
+    def test_abort_in_setup(self):
+        """
+        Aborting interrupts the setup delay (and skips teardown's).
+        """
+        latencies = self.abort_latencies(State.SETUP)
+        self.assertLess(percentile(latencies, 0.5), 0.001, latencies)
+        self.assertLess(latencies[-1], 0.1, latencies)
+
+    def test_abort_in_working(self):
+        """
+        Aborting used to wait out the current 1 s step.
+        """
+        latencies = self.abort_latencies(State.WORKING)
+        self.assertLess(percentile(latencies, 0.5), 0.001, latencies)
+        self.assertLess(latencies[-1], 0.1, latencies)
+
+    def test_aborted_job_stops_counting(self):
+        job = launch(Count(1, 100, 1000))
+        while job.state != State.WORKING:
+            pass
+        job.abort()
+        self.assertLessEqual(job.output.last, 1)
+        self.assertEqual(False, job.wait_for_result())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,126 @@
+from gild import AdmissionError
+from gild import AdmissionPolicy
+from gild import Count
+from gild import Executor
+from gild import admission
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import metrics
+from gild import set_admission_limit
+from gild import set_executor
+from gild import set_worker_count
+
+import threading
+import time
+import timeit
+import unittest
+
+
+def wait_for_no_jobs_in_flight(timeout=5):
+    """
+    Admission is returned just after a Job's final state is set, so
+    wait_for_result() can beat it by a moment.
+    """
+    end_time = timeit.default_timer() + timeout
+    while admission()['in_flight'] and timeit.default_timer() < end_time:
+        time.sleep(0.001)
+    return 0 == admission()['in_flight']
+
+
+class TestAdmission(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        set_executor(Executor.POOL)
+        set_worker_count(1)
+
+    def tearDown(self):
+        set_admission_limit(0)
+        wait_for_no_jobs_in_flight()
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def test_reject(self):
+        set_admission_limit(2, AdmissionPolicy.REJECT)
+        before = metrics()
+        running = launch(Count(1, 1, 1000))
+        queued = launch(Count(1, 1, 1000))
+        self.assertEqual(2, admission()['in_flight'])
+        with self.assertRaises(AdmissionError):
+            launch(Count(1, 1, 0))
+        self.assertEqual(1, metrics()['jobs_rejected'] -
+                         before['jobs_rejected'])
+        self.assertEqual(2, metrics()['jobs_created'] -
+                         before['jobs_created'])
+
+        running.abort()
+        queued.abort()
+        self.assertTrue(wait_for_no_jobs_in_flight())
+        job = launch(Count(1, 1, 0))
+        self.assertEqual(True, job.wait_for_result(5))
+
+    def test_block_releases_gil(self):
+        """
+        A blocked launch() waits for a slot without holding the GIL.
+        """
+        set_admission_limit(1, AdmissionPolicy.BLOCK)
+        before = metrics()
+        first = launch(Count(1, 1, 50))
+        ticks = []
+        stop = threading.Event()
+
+        def tick():
+            while not stop.is_set():
+                ticks.append(1)
+                stop.wait(0.001)
+
+        ticker = threading.Thread(target=tick)
+        ticker.start()
+        start_time = timeit.default_timer()
+        second = launch(Count(1, 1, 0))
+        elapsed = timeit.default_timer() - start_time
+        stop.set()
+        ticker.join()
+
+        self.assertEqual(True, first.finished)
+        self.assertGreater(elapsed, 0.05)
+        self.assertGreater(len(ticks), 10)
+        self.assertEqual(1, metrics()['launches_throttled'] -
+                         before['launches_throttled'])
+        self.assertEqual(True, second.wait_for_result(5))
+
+    def test_timeout(self):
+        set_admission_limit(1, AdmissionPolicy.TIMEOUT, 0.05)
+        first = launch(Count(1, 1, 1000))
+        start_time = timeit.default_timer()
+        with self.assertRaises(AdmissionError):
+            launch(Count(1, 1, 0))
+        self.assertGreaterEqual(timeit.default_timer() - start_time, 0.04)
+        first.abort()
+
+    def test_timeout_needs_a_timeout(self):
+        with self.assertRaises(ValueError):
+            set_admission_limit(1, AdmissionPolicy.TIMEOUT)
+
+    def test_launch_many_is_admitted_at_once(self):
+        set_admission_limit(3, AdmissionPolicy.REJECT)
+        with self.assertRaises(AdmissionError):
+            launch_many(Count(1, 1, 0) for i in range(4))
+        group = launch_many(Count(1, 1, 0) for i in range(3))
+        self.assertEqual(True, group.wait_for_result(5))
+        self.assertTrue(wait_for_no_jobs_in_flight())
+
+    def test_settings(self):
+        set_admission_limit(5, AdmissionPolicy.TIMEOUT, 2)
+        settings = admission()
+        self.assertEqual(5, settings['max_jobs'])
+        self.assertEqual(AdmissionPolicy.TIMEOUT, settings['policy'])
+        self.assertEqual(2.0, settings['timeout'])
+        self.assertTrue(issubclass(AdmissionError, RuntimeError))
+
+
+if __name__ == '__main__':
+    unittest.main()
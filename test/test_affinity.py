@@ -0,0 +1,136 @@
+from gild import Affinity
+from gild import Count
+from gild import current_numa_node
+from gild import Executor
+from gild import get_affinity
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import numa_node_count
+from gild import numa_node_cpus
+from gild import PythonJob
+from gild import set_affinity
+from gild import set_executor
+from gild import set_worker_count
+from gild import State
+
+import os
+import unittest
+
+
+class WhereAmI(PythonJob):
+    """
+    Records the CPUs and NUMA node of the thread that runs it.
+    """
+
+    def on_working(self, token):
+        self.cpus = os.sched_getaffinity(0)
+        self.node = current_numa_node()
+        return True
+
+
+def run(job_input):
+    job = launch(job_input)
+    job.wait_for_result(10)
+    return job
+
+
+@unittest.skipUnless(hasattr(os, 'sched_getaffinity'),
+                     'needs os.sched_getaffinity()')
+class TestAffinity(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        set_executor(Executor.POOL)
+        set_worker_count(2)
+        self.cpus = numa_node_cpus()
+
+    def tearDown(self):
+        set_affinity(Affinity.NONE)
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def test_topology(self):
+        self.assertLessEqual(1, numa_node_count())
+        self.assertEqual(sorted(os.sched_getaffinity(0)), self.cpus)
+        by_node = [numa_node_cpus(node) for node in range(numa_node_count())]
+        self.assertEqual(self.cpus, sorted(sum(by_node, [])))
+        self.assertIn(current_numa_node(), range(-1, numa_node_count()))
+
+    def test_pin_to_cpu(self):
+        for executor in (Executor.POOL, Executor.STEALING):
+            set_executor(executor)
+            set_affinity(Affinity.CPU, [self.cpus[-1]])
+            self.assertEqual(Affinity.CPU, get_affinity())
+            job = run(WhereAmI())
+            self.assertEqual({self.cpus[-1]}, job.input.cpus)
+
+            # Running workers move back.
+            set_affinity(Affinity.NONE)
+            job = run(WhereAmI())
+            self.assertEqual(set(self.cpus), job.input.cpus)
+
+    def test_pin_to_core(self):
+        set_affinity(Affinity.CORE)
+        job = run(WhereAmI())
+        self.assertLessEqual(job.input.cpus, set(self.cpus))
+        self.assertLessEqual(1, len(job.input.cpus))
+
+    def test_workers_per_node(self):
+        set_affinity(Affinity.NODE)
+        jobs = []
+        for node in range(numa_node_count()):
+            job_input = WhereAmI()
+            job_input.numa_node = node
+            jobs.append((node, run(job_input)))
+        for node, job in jobs:
+            self.assertEqual(State.COMPLETE, job.state)
+            self.assertEqual(set(numa_node_cpus(node)), job.input.cpus)
+            self.assertEqual(node, job.input.node)
+
+    def test_node_without_workers(self):
+        # Runs anyway, on whichever thread is free.
+        set_affinity(Affinity.NODE)
+        job_input = Count(1, 10, 0)
+        job_input.numa_node = numa_node_count() + 10
+        self.assertEqual(State.COMPLETE, run(job_input).state)
+
+    def test_launch_many_by_node(self):
+        set_affinity(Affinity.NODE)
+        inputs = []
+        for i in range(10):
+            inputs.append(Count(1, 10, 0))
+            inputs[-1].numa_node = i % (numa_node_count() + 1)
+        group = launch_many(inputs)
+        self.assertTrue(group.wait_for_result(10))
+
+    def test_thread_executor_node(self):
+        set_executor(Executor.THREAD)
+        job_input = WhereAmI()
+        job_input.numa_node = numa_node_count() - 1
+        job = run(job_input)
+        self.assertEqual(set(numa_node_cpus(numa_node_count() - 1)),
+                         job.input.cpus)
+
+    def test_numa_node_property(self):
+        job_input = Count()
+        self.assertIsNone(job_input.numa_node)
+        job_input.numa_node = 0
+        self.assertEqual(0, job_input.numa_node)
+        job_input.numa_node = None
+        self.assertIsNone(job_input.numa_node)
+        with self.assertRaises(ValueError):
+            job_input.numa_node = -1
+        with self.assertRaises(ValueError):
+            job_input.numa_node = -2
+
+    def test_bad_cpus(self):
+        with self.assertRaises(ValueError):
+            set_affinity(Affinity.CPU, [-1])
+        self.assertEqual(Affinity.NONE, get_affinity())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,58 @@
+from gild import allocation_stats
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import set_executor
+from gild import set_worker_count
+
+import unittest
+
+
+class TestAllocation(unittest.TestCase):
+
+    def setUp(self):
+        # Each thread caches up to a batch of blocks of each size, so
+        # pin the threads: with many, warming up takes longer than
+        # the test runs.
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        set_executor(Executor.POOL)
+        set_worker_count(1)
+
+    def tearDown(self):
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def run_jobs(self, count):
+        input = Count(1, 1, 0)
+        for i in range(count):
+            job = launch(input)
+            job.wait_for_result()
+            del job
+        group = launch_many([input] * count)
+        group.wait_for_result()
+
+    def test_stats(self):
+        """
+        The counters are exposed as a dict.
+        """
+        stats = allocation_stats()
+        for key in ('system_allocations', 'system_bytes',
+                    'oversize_allocations'):
+            self.assertGreaterEqual(stats[key], 0)
+
+    def test_steady_state_recycles(self):
+        """
+        Once the pools are warm, more Jobs take nothing from the system.
+        """
+        self.run_jobs(1000)
+        before = allocation_stats()
+        self.run_jobs(1000)
+        self.assertEqual(before, allocation_stats())
+
+
+if __name__ == '__main__':
+    unittest.main()
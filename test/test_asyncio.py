@@ -0,0 +1,76 @@
+from gild import Count
+from gild import launch
+from gild import State
+
+import asyncio
+import unittest
+
+
+class TestAsyncio(unittest.TestCase):
+
+    def test_await_job(self):
+        """
+        Awaiting a Job gives the same result as wait_for_result().
+        """
+        async def run():
+            job = launch(Count(1, 2, 10))
+            return await job, job.state
+
+        self.assertEqual((True, State.COMPLETE), asyncio.run(run()))
+
+    def test_await_failed_job(self):
+        """
+        A Job that doesn't complete resolves to False.
+        """
+        async def run():
+            input = Count(1, 2, 10)
+            input.fail_after = State.WORKING
+            return await launch(input)
+
+        self.assertEqual(False, asyncio.run(run()))
+
+    def test_await_finished_job(self):
+        """
+        A Job that finished before it was awaited resolves at once.
+        """
+        job = launch(Count(1, 1, 0))
+        job.wait_for_result()
+
+        async def run():
+            return await job
+
+        self.assertEqual(True, asyncio.run(run()))
+
+    def test_await_many_jobs(self):
+        """
+        Many outstanding Jobs, some awaited twice, all resolve.
+        """
+        async def run():
+            jobs = [launch(Count(1, 2, 1)) for i in range(200)]
+            results = await asyncio.gather(*jobs, *jobs[:10])
+            return results, jobs
+
+        results, jobs = asyncio.run(run())
+        self.assertEqual([True] * 210, results)
+
+    def test_loop_keeps_running(self):
+        """
+        The event loop is not blocked while a Job runs.
+        """
+        async def tick(counter):
+            while True:
+                counter.append(1)
+                await asyncio.sleep(0.01)
+
+        async def run():
+            counter = []
+            ticker = asyncio.ensure_future(tick(counter))
+            await launch(Count(1, 2, 100))
+            ticker.cancel()
+            return len(counter)
+
+        self.assertGreater(asyncio.run(run()), 10)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,80 @@
+from gild import Count
+from gild import launch
+
+import time
+import unittest
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+class TestBuffer(unittest.TestCase):
+
+    def launch_recording(self, start, end, delay_ms):
+        input = Count(start, end, delay_ms)
+        input.record = True
+        return launch(input)
+
+    def test_not_recording_by_default(self):
+        """
+        Without .record the buffer is empty.
+        """
+        job = launch(Count(1, 10, 0))
+        self.assertEqual(True, job.wait_for_result())
+        self.assertEqual(job.output.recorded, 0)
+        self.assertEqual(len(memoryview(job.output)), 0)
+
+    def test_records_every_value(self):
+        """
+        Every number counted is in the buffer, in order.
+        """
+        job = self.launch_recording(1, 1000, 0)
+        self.assertEqual(True, job.wait_for_result())
+        view = memoryview(job.output)
+        self.assertEqual(view.format, 'i')
+        self.assertEqual(view.itemsize, 4)
+        self.assertEqual(True, view.readonly)
+        self.assertEqual(view.tolist(), list(range(1, 1001)))
+        self.assertEqual(job.output.recorded, 1000)
+
+    def test_prefix_while_working(self):
+        """
+        Views taken while WORKING are prefixes of the final result.
+        """
+        job = self.launch_recording(1, 20, 5)
+        views = []
+        while not job.finished:
+            views.append(memoryview(job.output).tolist())
+            time.sleep(0.01)
+        self.assertEqual(True, job.wait_for_result())
+        final = memoryview(job.output).tolist()
+        self.assertEqual(final, list(range(1, 21)))
+        for view in views:
+            self.assertEqual(view, final[:len(view)])
+        self.assertEqual(views, sorted(views, key=len))
+
+    def test_view_outlives_job(self):
+        """
+        A view keeps the output (and its storage) alive.
+        """
+        job = self.launch_recording(5, 9, 0)
+        self.assertEqual(True, job.wait_for_result())
+        view = memoryview(job.output)
+        del job
+        self.assertEqual(view.tolist(), [5, 6, 7, 8, 9])
+
+    @unittest.skipIf(numpy is None, "numpy is not installed")
+    def test_numpy_is_zero_copy(self):
+        job = self.launch_recording(1, 100, 0)
+        self.assertEqual(True, job.wait_for_result())
+        first = numpy.asarray(job.output)
+        second = numpy.asarray(job.output)
+        self.assertEqual(first.tolist(), list(range(1, 101)))
+        self.assertEqual(first.ctypes.data, second.ctypes.data)
+        self.assertFalse(first.flags.writeable)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,140 @@
+from gild import Count
+from gild import launch
+from gild import PythonJob
+from gild import report_progress
+from gild import set_callback_rate
+from gild import State
+
+import subprocess
+import sys
+import threading
+import unittest
+
+
+class Progress(PythonJob):
+
+    def __init__(self, steps, start=None):
+        super().__init__()
+        self.steps = steps
+        self.start = start
+
+    def on_working(self, token):
+        if self.start is not None:
+            # Wait for the test to register its callbacks.
+            self.start.wait(5)
+        for i in range(1, self.steps + 1):
+            report_progress(i)
+        return True
+
+
+class TestCallbacks(unittest.TestCase):
+
+    def setUp(self):
+        self.done = threading.Event()
+        self.finished = []
+        self.threads = set()
+
+    def tearDown(self):
+        set_callback_rate(100)
+
+    def on_done(self, job):
+        self.threads.add(threading.get_ident())
+        self.finished.append(job.state)
+        self.done.set()
+
+    def test_on_done(self):
+        job = launch(Count(1, 3, 1))
+        job.on_done(self.on_done)
+        self.assertTrue(self.done.wait(5))
+        self.assertEqual([State.COMPLETE], self.finished)
+        self.assertNotIn(threading.get_ident(), self.threads)
+
+    def test_on_done_after_finishing(self):
+        job = launch(Count(1, 1, 0))
+        job.wait_for_result()
+        job.on_done(self.on_done)
+        self.assertTrue(self.done.wait(5))
+        self.assertEqual([State.COMPLETE], self.finished)
+
+    def test_job_is_kept_alive(self):
+        """
+        Dropping the Job doesn't abort it while a callback waits.
+        """
+        launch(Count(1, 3, 10)).on_done(self.on_done)
+        self.assertTrue(self.done.wait(5))
+        self.assertEqual([State.COMPLETE], self.finished)
+
+    def test_last_reference_dropped_by_dispatcher(self):
+        """
+        The dispatcher can release the last reference to a PythonJob
+        as soon as it finishes, and goes on delivering callbacks.
+        """
+        for i in range(20):
+            self.done.clear()
+            launch(Progress(10)).on_done(self.on_done)
+            self.assertTrue(self.done.wait(5))
+        self.assertEqual([State.COMPLETE] * 20, self.finished)
+
+    def test_progress_is_coalesced(self):
+        set_callback_rate(20)
+        values = []
+        job = launch(Count(1, 200, 1))
+        job.on_progress(lambda job, value: values.append(value))
+        job.on_done(self.on_done)
+        self.assertTrue(self.done.wait(5))
+        # About 200 ms of counting, so a handful of batches.
+        self.assertLess(len(values), 20, values)
+        self.assertEqual(200, values[-1])
+        self.assertEqual(sorted(values), values)
+
+    def test_python_job_progress(self):
+        values = []
+        start = threading.Event()
+        job = launch(Progress(1000, start))
+        job.on_progress(lambda job, value: values.append(value))
+        job.on_done(self.on_done)
+        start.set()
+        self.assertTrue(self.done.wait(5))
+        self.assertEqual(1000, values[-1])
+
+    def test_report_progress_outside_a_job(self):
+        self.assertEqual(False, report_progress(1))
+
+    def test_callback_exception_is_reported(self):
+        raised = []
+        old_hook = sys.unraisablehook
+        sys.unraisablehook = lambda info: raised.append(info.exc_type)
+        try:
+            job = launch(Count(1, 1, 0))
+            job.on_done(lambda job: 1 / 0)
+            job.on_done(self.on_done)
+            self.assertTrue(self.done.wait(5))
+        finally:
+            sys.unraisablehook = old_hook
+        self.assertEqual([ZeroDivisionError], raised)
+        self.assertEqual([State.COMPLETE], self.finished)
+
+    def test_exit_with_callbacks_queued(self):
+        """
+        The interpreter exits cleanly while callbacks are still
+        waiting for the dispatcher.
+        """
+        code = '\n'.join([
+            'from gild import Count, launch, set_callback_rate',
+            'set_callback_rate(0.5)',
+            'jobs = [launch(Count(1, 100, 0)) for _ in range(10)]',
+            'for job in jobs:',
+            '    job.on_progress(lambda job, value: None)',
+            '    job.on_done(lambda job: None)',
+            '    job.wait_for_result()',
+        ])
+        result = subprocess.run([sys.executable, '-c', code], timeout=30)
+        self.assertEqual(0, result.returncode)
+
+    def test_bad_rate(self):
+        with self.assertRaises(ValueError):
+            set_callback_rate(-1)
+
+
+if __name__ == '__main__':
+    unittest.main()
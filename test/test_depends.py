@@ -0,0 +1,78 @@
+from gild import Count
+from gild import launch
+from gild import launch_many
+from gild import State
+
+import unittest
+
+
+class TestDependsOn(unittest.TestCase):
+
+    def test_waits_for_prerequisite(self):
+        """
+        A dependent stays NOT_STARTED until its prerequisite is done.
+        """
+        first = launch(Count(1, 5, 20))
+        second = launch(Count(1, 1, 0), depends_on=first)
+        self.assertEqual(second.state, State.NOT_STARTED)
+        self.assertEqual(True, second.wait_for_result())
+        self.assertEqual(first.state, State.COMPLETE)
+        self.assertGreaterEqual(second.timings.queued.total_seconds(), 0.05)
+
+    def test_diamond(self):
+        """
+        A Job with several prerequisites starts after the last one.
+        """
+        top = launch(Count(1, 2, 10))
+        left = launch(Count(1, 1, 10), depends_on=[top])
+        right = launch(Count(1, 3, 10), depends_on=[top])
+        bottom = launch(Count(1, 1, 0), depends_on=(left, right))
+        self.assertEqual(True, bottom.wait_for_result())
+        for job in (top, left, right):
+            self.assertEqual(job.state, State.COMPLETE)
+
+    def test_accepts_job_group(self):
+        group = launch_many(Count(1, 2, 1) for i in range(10))
+        after = launch(Count(1, 1, 0), depends_on=group)
+        self.assertEqual(True, after.wait_for_result())
+        self.assertEqual(True, group.finished)
+
+    def test_finished_prerequisite(self):
+        first = launch(Count(1, 1, 0))
+        self.assertEqual(True, first.wait_for_result())
+        second = launch(Count(1, 1, 0), depends_on=[first])
+        self.assertEqual(True, second.wait_for_result())
+
+    def test_incomplete_cancels_chain(self):
+        """
+        An INCOMPLETE prerequisite cancels everything downstream.
+        """
+        first = launch(Count(1, 100, 1000))
+        chain = [launch(Count(1, 1, 0), depends_on=first)]
+        for i in range(10):
+            chain.append(launch(Count(1, 1, 0), depends_on=chain[-1]))
+        first.abort()
+        self.assertEqual(False, chain[-1].wait_for_result(5))
+        for job in chain:
+            self.assertEqual(job.state, State.INCOMPLETE)
+            self.assertIsNone(job.timings.setup)
+
+    def test_abort_waiting_job(self):
+        """
+        Aborting a dependent doesn't wait for its prerequisites.
+        """
+        first = launch(Count(1, 100, 1000))
+        second = launch(Count(1, 1, 0), depends_on=[first])
+        self.assertEqual(True, second.abort(1))
+        self.assertEqual(second.state, State.INCOMPLETE)
+        self.assertNotEqual(first.state, State.INCOMPLETE)
+
+    def test_bad_depends_on(self):
+        with self.assertRaises(TypeError):
+            launch(Count(1, 1, 0), depends_on=42)
+        with self.assertRaises((TypeError, RuntimeError)):
+            launch(Count(1, 1, 0), depends_on=[42])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,93 @@
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import set_executor
+from gild import set_worker_count
+from gild import State
+
+import unittest
+
+
+class TestExecutor(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+
+    def tearDown(self):
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def test_defaults(self):
+        """
+        The pool is the default, sized to at least one thread.
+        """
+        self.assertEqual(get_executor(), Executor.POOL)
+        self.assertGreaterEqual(get_worker_count(), 1)
+
+    def test_worker_count_must_be_positive(self):
+        """
+        A pool without threads could never run anything.
+        """
+        with self.assertRaises(ValueError):
+            set_worker_count(0)
+
+    def test_jobs_queue_when_pool_is_busy(self):
+        """
+        With one thread, a second Job waits in NOT_STARTED until
+        the first is finished, and then runs normally.
+        """
+        set_worker_count(1)
+        first = launch(Count(1, 1, 100))
+        self.assertEqual(first.state, State.SETUP)
+        second = launch(Count(1, 1, 100))
+        self.assertEqual(second.state, State.NOT_STARTED)
+        self.assertEqual(second.finished, False)
+        self.assertEqual(True, second.wait_for_result())
+        self.assertEqual(True, first.finished)
+        self.assertEqual(True, first.wait_for_result())
+
+    def test_queued_job_can_be_aborted(self):
+        """
+        Deleting a queued Job never runs it.
+        """
+        set_worker_count(1)
+        first = launch(Count(1, 1, 100))
+        second = launch(Count(1, 1, 100))
+        self.assertEqual(second.state, State.NOT_STARTED)
+        del second
+        self.assertEqual(True, first.wait_for_result())
+
+    def test_stealing_executor(self):
+        """
+        Executor.STEALING runs Jobs, including more Jobs than threads.
+        """
+        set_executor(Executor.STEALING)
+        self.assertEqual(get_executor(), Executor.STEALING)
+        set_worker_count(2)
+        jobs = [launch(Count(1, 2, 10)) for i in range(8)]
+        for job in jobs:
+            self.assertEqual(True, job.wait_for_result())
+
+    def test_worker_count_has_upper_limit(self):
+        """
+        The per-thread deques of Executor.STEALING are preallocated.
+        """
+        with self.assertRaises(ValueError):
+            set_worker_count(100000)
+
+    def test_thread_executor(self):
+        """
+        Executor.THREAD still starts one thread per Job.
+        """
+        set_executor(Executor.THREAD)
+        self.assertEqual(get_executor(), Executor.THREAD)
+        jobs = [launch(Count(1, 2, 10)) for i in range(4)]
+        for job in jobs:
+            self.assertEqual(True, job.wait_for_result())
+
+
+if __name__ == '__main__':
+    unittest.main()
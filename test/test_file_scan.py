@@ -0,0 +1,126 @@
+from gild import Executor
+from gild import FileScan
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import OverflowPolicy
+from gild import ScanMode
+from gild import set_executor
+from gild import set_worker_count
+from gild import State
+
+import collections
+import mmap
+import os
+import pathlib
+import tempfile
+import threading
+import timeit
+import unittest
+
+
+class TestFileScan(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        set_executor(Executor.POOL)
+        set_worker_count(4)
+        self.directory = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.directory.name, 'data')
+        lines = [b'x' * (i % 300) for i in range(20000)]
+        self.content = b'\n'.join(lines) + b'no newline at the end'
+        with open(self.path, 'wb') as file:
+            file.write(self.content)
+
+    def tearDown(self):
+        self.directory.cleanup()
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def scan(self, *args, **kwargs):
+        job = launch(FileScan(self.path, *args, **kwargs))
+        self.assertEqual(True, job.wait_for_result(10))
+        return job.output
+
+    def test_lines(self):
+        output = self.scan(ScanMode.LINES, 1 << 16)
+        self.assertEqual(self.content.count(b'\n'), output.total)
+        self.assertEqual(len(self.content), output.size)
+        self.assertEqual(len(self.content), output.bytes_scanned)
+        self.assertEqual(output.chunk_count, output.chunks_done)
+        self.assertIsNone(output.histogram)
+
+    def test_bytes(self):
+        output = self.scan(ScanMode.BYTES, 1 << 16)
+        self.assertEqual(len(self.content), output.total)
+        counts = collections.Counter(self.content)
+        self.assertEqual([counts[value] for value in range(256)],
+                         output.histogram)
+
+    def test_chunks(self):
+        output = self.scan(ScanMode.LINES, 1000)
+        # Rounded up to whole pages.
+        self.assertEqual(0, output.chunk_size % mmap.PAGESIZE)
+        self.assertLessEqual(1000, output.chunk_size)
+        self.assertEqual(output.chunk_count, output.pushed)
+        indexes = output.drain()
+        self.assertEqual(list(range(output.chunk_count)), sorted(indexes))
+        for index in indexes:
+            offset, length, value = output.chunk(index)
+            self.assertEqual(index * output.chunk_size, offset)
+            self.assertEqual(
+                self.content[offset:offset + length].count(b'\n'), value)
+        with self.assertRaises(IndexError):
+            output.chunk(output.chunk_count)
+
+    def test_path_like(self):
+        job = launch(FileScan(pathlib.Path(self.path)))
+        self.assertEqual(True, job.wait_for_result(10))
+        self.assertEqual(self.content.count(b'\n'), job.output.total)
+
+    def test_empty_file(self):
+        open(self.path, 'wb').close()
+        output = self.scan()
+        self.assertEqual(0, output.size)
+        self.assertEqual(0, output.chunk_count)
+        self.assertEqual(0, output.total)
+
+    def test_errors(self):
+        with self.assertRaises(FileNotFoundError):
+            launch(FileScan(os.path.join(self.directory.name, 'missing')))
+        with self.assertRaises(IsADirectoryError):
+            launch(FileScan(self.directory.name))
+        with self.assertRaises(ValueError):
+            launch(FileScan(self.path, chunk_size=0))
+        with self.assertRaises(ValueError):
+            launch(FileScan(self.path, chunk_size=2 ** 64 - 1))
+
+    def test_progress(self):
+        done = threading.Event()
+        values = []
+        job = launch(FileScan(self.path, chunk_size=1 << 12))
+        job.on_progress(lambda job, value: values.append(value))
+        job.on_done(lambda job: done.set())
+        self.assertTrue(done.wait(10))
+        self.assertEqual(job.output.chunk_count, max(values))
+
+    def test_abort(self):
+        # Nothing drains the stream, so the scan stops part way.
+        with open(self.path, 'wb') as file:
+            file.truncate(64 << 20)
+        scan = FileScan(self.path, ScanMode.BYTES, 1 << 20)
+        scan.overflow = OverflowPolicy.BLOCK
+        scan.stream_capacity = 1
+        job = launch(scan)
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        self.assertEqual(True, job.abort(5))
+        self.assertLess(timeit.default_timer() - start_time, 0.5)
+        self.assertEqual(State.INCOMPLETE, job.state)
+        self.assertLess(job.output.bytes_scanned, 64 << 20)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,195 @@
+from gild import as_completed
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import launch
+from gild import OverflowPolicy
+from gild import PythonJob
+from gild import set_executor
+
+import asyncio
+import os
+import sys
+import threading
+import timeit
+import unittest
+
+
+GIL_ENABLED = getattr(sys, '_is_gil_enabled', lambda: True)()
+
+
+def run_threads(count, target):
+    """
+    Run target(index) on 'count' threads at once, raising the first
+    exception any of them raised.
+    """
+    start = threading.Barrier(count)
+    errors = []
+
+    def run(index):
+        try:
+            start.wait()
+            target(index)
+        except BaseException as error:
+            errors.append(error)
+
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(count)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    if errors:
+        raise errors[0]
+
+
+class Spin(PythonJob):
+    """
+    Pure-Python work, which only runs in parallel without the GIL.
+    """
+
+    def __init__(self, loops):
+        super().__init__()
+        self.loops = loops
+        self.total = 0
+
+    def on_working(self, token):
+        total = 0
+        for i in range(self.loops):
+            total += i * i
+        self.total = total
+        return True
+
+
+class TestFreeThreading(unittest.TestCase):
+    """
+    Jobs, inputs and outputs shared by Python threads.  These run with
+    or without the GIL, but only race without it.
+    """
+
+    def test_set_fields_while_launching(self):
+        """
+        A Job runs from the values its input had when it was launched,
+        even while another thread is setting them.
+        """
+        input = Count(1, 10, 0)
+        input.stream_capacity = 64
+        stop = threading.Event()
+
+        def set_fields():
+            i = 0
+            while not stop.is_set():
+                i += 1
+                input.start = i % 10
+                input.end = i % 10 + 10
+
+        setter = threading.Thread(target=set_fields)
+        setter.start()
+        try:
+            jobs = []
+            run_threads(4, lambda index: jobs.extend(
+                launch(input) for _ in range(100)))
+        finally:
+            stop.set()
+            setter.join()
+
+        self.assertEqual(400, len(jobs))
+        for job in jobs:
+            self.assertEqual(True, job.wait_for_result(10))
+            expected = list(range(job.input.start, job.input.end + 1))
+            self.assertEqual(expected, job.output.drain())
+
+    def test_concurrent_drain(self):
+        """
+        Threads draining one output get every value exactly once.
+        """
+        input = Count(1, 50000, 0)
+        input.stream_capacity = 1024
+        input.overflow = OverflowPolicy.BLOCK
+        job = launch(input)
+        drained = [[] for _ in range(4)]
+
+        def drain(index):
+            while not job.finished or job.output.pending:
+                drained[index].extend(job.output.drain(100))
+
+        run_threads(4, drain)
+        self.assertEqual(True, job.wait_for_result(10))
+        values = sorted(value for part in drained for value in part)
+        self.assertEqual(list(range(1, 50001)), values)
+
+    def test_callbacks_from_many_threads(self):
+        """
+        on_done() callbacks registered from many threads are each
+        called once.
+        """
+        jobs = [launch(Count(1, 5, 2)) for _ in range(10)]
+        calls = []
+        lock = threading.Lock()
+
+        def on_done(job):
+            with lock:
+                calls.append(job)
+
+        run_threads(8, lambda index: [job.on_done(on_done) for job in jobs])
+        for job in jobs:
+            self.assertEqual(True, job.wait_for_result(10))
+        deadline = timeit.default_timer() + 10
+        while len(calls) < 80 and timeit.default_timer() < deadline:
+            threading.Event().wait(0.01)
+        self.assertEqual(80, len(calls))
+        for job in jobs:
+            self.assertEqual(8, sum(1 for call in calls if call is job))
+
+    def test_await_from_many_threads(self):
+        """
+        Event loops on many threads can await the same Jobs.
+        """
+        jobs = [launch(Count(1, 5, 2)) for _ in range(10)]
+        results = []
+
+        def await_jobs(index):
+            async def run():
+                return await asyncio.gather(*jobs)
+            results.append(asyncio.run(run()))
+
+        run_threads(4, await_jobs)
+        self.assertEqual([[True] * 10] * 4, results)
+
+    def test_shared_as_completed(self):
+        """
+        Threads sharing one as_completed() iterator get each Job once.
+        """
+        jobs = [launch(Count(1, i % 5 + 1, 2)) for i in range(40)]
+        completed = as_completed(jobs, 10)
+        seen = [[] for _ in range(4)]
+        run_threads(4, lambda index: seen[index].extend(completed))
+        self.assertEqual(sorted(map(id, jobs)),
+                         sorted(id(job) for part in seen for job in part))
+
+    @unittest.skipIf(GIL_ENABLED, 'needs a free-threaded build of Python')
+    @unittest.skipIf((os.cpu_count() or 1) < 4, 'needs 4 CPUs')
+    def test_python_jobs_run_in_parallel(self):
+        """
+        Without the GIL, PythonJobs doing pure-Python work scale with
+        the threads running them.
+        """
+        executor = get_executor()
+        set_executor(Executor.THREAD)
+        try:
+            def run(count):
+                start_time = timeit.default_timer()
+                jobs = [launch(Spin(2000000)) for _ in range(count)]
+                for job in jobs:
+                    self.assertEqual(True, job.wait_for_result(60))
+                return timeit.default_timer() - start_time
+
+            one = run(1)
+            four = run(4)
+        finally:
+            set_executor(executor)
+        # Four times the work, serialised, would take 4x as long.
+        self.assertLess(four, one * 2.5)
+
+
+if __name__ == '__main__':
+    unittest.main()
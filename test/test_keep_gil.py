@@ -1,11 +1,14 @@
 from gild import block_for_one_second
 
+import sys
 import threading
 import timeit
 import unittest
 
 class TestKeepGIL(unittest.TestCase):
 
+    @unittest.skipUnless(getattr(sys, '_is_gil_enabled', lambda: True)(),
+                         'free-threaded build: there is no GIL to keep')
     def test_block(self):
         """
         Ensure that keeping the GIL blocks other threads.
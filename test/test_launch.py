@@ -0,0 +1,54 @@
+from gild import Count
+from gild import launch
+from gild import State
+
+import timeit
+import unittest
+
+
+def percentile(sorted_values, fraction):
+    index = min(len(sorted_values) - 1, int(fraction * len(sorted_values)))
+    return sorted_values[index]
+
+
+class TestLaunch(unittest.TestCase):
+
+    def test_launch_waits_for_start(self):
+        """
+        launch() returns once the Job has left NOT_STARTED.
+        """
+        job = launch(Count(1, 1, 100))
+        self.assertEqual(job.state, State.SETUP)
+        self.assertEqual(True, job.wait_for_result())
+
+    def test_launch_latency(self):
+        """
+        Launching used to poll for the Job to start in 10 ms steps.
+        Build a histogram of launch latencies and show that nearly
+        all launches now take well under one polling step.
+        """
+        input = Count(1, 1, 0)
+        latencies = []
+        for i in range(200):
+            start_time = timeit.default_timer()
+            job = launch(input)
+            latencies.append(timeit.default_timer() - start_time)
+            job.wait_for_result()
+        latencies.sort()
+
+        # Power-of-two buckets from 16 us up, for the failure message.
+        histogram = {}
+        for latency in latencies:
+            bucket = 16e-6
+            while bucket < latency:
+                bucket *= 2
+            histogram[bucket] = histogram.get(bucket, 0) + 1
+        report = ', '.join('<={:.0f}us: {}'.format(bucket * 1e6, count)
+                           for bucket, count in sorted(histogram.items()))
+
+        self.assertLess(percentile(latencies, 0.5), 0.002, report)
+        self.assertLess(percentile(latencies, 0.9), 0.005, report)
+
+
+if __name__ == '__main__':
+    unittest.main()
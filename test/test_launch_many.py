@@ -0,0 +1,51 @@
+from gild import Count
+from gild import launch_many
+from gild import State
+from gild import wait_all
+
+import timeit
+import unittest
+
+
+class TestLaunchMany(unittest.TestCase):
+
+    def test_group_is_a_sequence(self):
+        """
+        The JobGroup holds one Job per input, in order.
+        """
+        inputs = [Count(i, i, 0) for i in range(1, 11)]
+        group = launch_many(inputs)
+        self.assertEqual(len(group), 10)
+        self.assertEqual(True, group.wait_for_result())
+        self.assertEqual(True, group.finished)
+        self.assertEqual([i for i in range(1, 11)],
+                         [job.output.last for job in group])
+        self.assertEqual(group[-1].input.start, 10)
+        with self.assertRaises(IndexError):
+            group[10]
+
+    def test_accepts_any_iterable(self):
+        """
+        Generators work too, and the Jobs work with wait_all().
+        """
+        group = launch_many(Count(1, 2, 1) for i in range(100))
+        self.assertEqual(len(group), 100)
+        self.assertEqual(True, wait_all(group))
+        for job in group:
+            self.assertEqual(job.state, State.COMPLETE)
+
+    def test_launch_many_does_not_wait(self):
+        """
+        Unlike launch(), launch_many() doesn't wait for Jobs to start.
+        """
+        start_time = timeit.default_timer()
+        group = launch_many([Count(1, 2, 100)] * 4)
+        elapsed = timeit.default_timer() - start_time
+        self.assertLess(elapsed, 0.1)
+        self.assertEqual(True, group.abort())
+        for job in group:
+            self.assertEqual(job.state, State.INCOMPLETE)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,108 @@
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import metrics
+from gild import metrics_prometheus
+from gild import set_executor
+from gild import set_worker_count
+from gild import State
+
+import time
+import unittest
+
+
+class TestMetrics(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+
+    def tearDown(self):
+        set_worker_count(self.worker_count)
+        set_executor(self.executor)
+
+    def delta(self, before, after):
+        return {name: after[name] - before[name] for name in before}
+
+    def test_counts_job_outcomes(self):
+        before = metrics()
+        inputs = [Count(1, 1, 0) for i in range(10)]
+        inputs[0].fail_after = State.WORKING
+        group = launch_many(inputs)
+        self.assertEqual(False, group.wait_for_result())
+        delta = self.delta(before, metrics())
+        self.assertEqual(delta['jobs_created'], 10)
+        self.assertEqual(delta['jobs_launched'], 10)
+        self.assertEqual(delta['jobs_dequeued'], 10)
+        self.assertEqual(delta['jobs_completed'], 9)
+        self.assertEqual(delta['jobs_incomplete'], 1)
+        self.assertEqual(delta['jobs_aborted'], 0)
+        del group
+        delta = self.delta(before, metrics())
+        self.assertEqual(delta['jobs_destroyed'], 10)
+        self.assertEqual(delta['jobs_alive'], 0)
+
+    def test_gauges(self):
+        """
+        Queued and running Jobs show up in the gauges.
+        """
+        set_executor(Executor.POOL)
+        set_worker_count(1)
+        before = metrics()
+        first = launch(Count(1, 1, 1000))
+        second = launch(Count(1, 1, 1000))
+        now = metrics()
+        self.assertEqual(now['jobs_running'] - before['jobs_running'], 1)
+        self.assertEqual(now['jobs_queued'] - before['jobs_queued'], 1)
+        self.assertEqual(now['jobs_alive'] - before['jobs_alive'], 2)
+        second.abort()
+        first.abort()
+        delta = self.delta(before, metrics())
+        self.assertEqual(delta['jobs_aborted'], 2)
+        self.assertEqual(delta['jobs_incomplete'], 2)
+        self.assertEqual(delta['jobs_running'], 0)
+        self.assertEqual(delta['jobs_queued'], 0)
+
+    def wait_for_threads(self, expected):
+        """
+        Threads count themselves once running, so allow a moment.
+        """
+        deadline = time.time() + 5
+        while metrics()['worker_threads'] != expected:
+            self.assertLess(time.time(), deadline, metrics())
+            time.sleep(0.001)
+
+    def test_worker_threads(self):
+        """
+        Growing and shrinking the executor shows in worker_threads.
+        """
+        set_executor(Executor.STEALING)
+        set_worker_count(1)
+        # Let any THREAD executor threads from other tests exit.
+        time.sleep(0.1)
+        # One thread for each executor with threads (POOL, STEALING).
+        executors = metrics()['worker_threads']
+        self.assertIn(executors, (1, 2))
+        set_worker_count(4)
+        self.wait_for_threads(4 * executors)
+        set_worker_count(2)
+        self.wait_for_threads(2 * executors)
+
+    def test_prometheus(self):
+        text = metrics_prometheus()
+        snapshot = metrics()
+        lines = text.splitlines()
+        self.assertIn('# TYPE gild_jobs_launched_total counter', lines)
+        self.assertIn('# TYPE gild_jobs_queued gauge', lines)
+        values = {line.split()[0]: int(line.split()[1])
+                  for line in lines if not line.startswith('#')}
+        self.assertEqual(len(values), len(snapshot))
+        self.assertLessEqual(values['gild_jobs_launched_total'],
+                             snapshot['jobs_launched'])
+
+
+if __name__ == '__main__':
+    unittest.main()
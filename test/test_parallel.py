@@ -0,0 +1,72 @@
+from gild import CountParallel
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import set_executor
+from gild import set_worker_count
+from gild import State
+
+import threading
+import timeit
+import unittest
+
+
+class TestParallel(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        set_executor(Executor.POOL)
+        set_worker_count(4)
+
+    def tearDown(self):
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def test_sum(self):
+        job = launch(CountParallel(1, 1000000))
+        self.assertEqual(True, job.wait_for_result(10))
+        self.assertEqual(500000500000, job.output.total)
+
+    def test_runs_on_every_worker(self):
+        job = launch(CountParallel(1, 100000, 100, 5))
+        self.assertEqual(True, job.wait_for_result(10))
+        self.assertEqual(5000050000, job.output.total)
+        self.assertGreater(job.output.threads, 1)
+        self.assertLessEqual(job.output.threads, 4)
+        # Chunks shrink as the range runs out.
+        self.assertGreater(job.output.chunks, 4)
+        self.assertLess(job.output.chunks, 1000)
+
+    def test_empty_range(self):
+        job = launch(CountParallel(10, 1))
+        self.assertEqual(True, job.wait_for_result(10))
+        self.assertEqual(0, job.output.total)
+
+    def test_abort_stops_every_chunk(self):
+        job = launch(CountParallel(1, 10 ** 9, 1000, 1000))
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        self.assertEqual(True, job.abort(5))
+        self.assertLess(timeit.default_timer() - start_time, 0.5)
+        self.assertEqual(State.INCOMPLETE, job.state)
+        self.assertEqual(0, job.output.total)
+
+    def test_combined_progress(self):
+        done = threading.Event()
+        values = []
+        job = launch(CountParallel(1, 100000, 100, 1))
+        job.on_progress(lambda job, value: values.append(value))
+        job.on_done(lambda job: done.set())
+        self.assertTrue(done.wait(10))
+        self.assertEqual(100000, max(values))
+
+    def test_bad_min_chunk(self):
+        with self.assertRaises(ValueError):
+            launch(CountParallel(1, 10, 0))
+
+
+if __name__ == '__main__':
+    unittest.main()
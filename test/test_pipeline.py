@@ -0,0 +1,86 @@
+from gild import CountScale
+from gild import CountSource
+from gild import CountSum
+from gild import OverflowPolicy
+from gild import Pipeline
+from gild import State
+from gild import launch
+
+import time
+import timeit
+import unittest
+
+
+class TestPipeline(unittest.TestCase):
+
+    def test_source_scale_sum(self):
+        """
+        Items flow through every stage without coming back to Python.
+        """
+        job = launch(Pipeline([CountSource(1, 1000), CountScale(3),
+                               CountSum()]))
+        self.assertEqual(True, job.wait_for_result(5))
+        self.assertEqual([3 * 1000 * 1001 // 2], job.output.drain())
+
+    def test_every_item_arrives_in_order(self):
+        """
+        Small queues and batches make the stages wait on each other.
+        """
+        pipeline = Pipeline([CountSource(1, 5000), CountScale(2)])
+        pipeline.queue_capacity = 4
+        pipeline.batch_size = 3
+        pipeline.stream_capacity = 8192
+        pipeline.overflow = OverflowPolicy.BLOCK
+        job = launch(pipeline)
+        self.assertEqual(True, job.wait_for_result(5))
+        self.assertEqual([2 * i for i in range(1, 5001)], job.output.drain())
+
+    def test_backpressure(self):
+        """
+        A full output stream stops the producer instead of dropping.
+        """
+        pipeline = Pipeline([CountSource(1, 1000), CountScale(1)])
+        pipeline.queue_capacity = 16
+        pipeline.stream_capacity = 16
+        pipeline.overflow = OverflowPolicy.BLOCK
+        job = launch(pipeline)
+        time.sleep(0.1)
+        self.assertEqual(False, job.finished)
+        self.assertEqual(16, job.output.pending)
+        values = []
+        while len(values) < 1000:
+            values += job.output.drain()
+        self.assertEqual(True, job.wait_for_result(5))
+        self.assertEqual(list(range(1, 1001)), values)
+        self.assertEqual(0, job.output.dropped)
+
+    def test_abort_cancels_every_stage(self):
+        pipeline = Pipeline([CountSource(1, 1000000, 1000), CountScale(2),
+                             CountSum()])
+        job = launch(pipeline)
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        self.assertEqual(True, job.abort())
+        self.assertLess(timeit.default_timer() - start_time, 0.1)
+        self.assertEqual(job.state, State.INCOMPLETE)
+        self.assertEqual([], job.output.drain())
+
+    def test_source_must_come_first(self):
+        job = launch(Pipeline([CountScale(2), CountSource(1, 10)]))
+        self.assertEqual(False, job.wait_for_result(5))
+        self.assertEqual(job.state, State.INCOMPLETE)
+
+    def test_needs_a_stage(self):
+        with self.assertRaises(ValueError):
+            launch(Pipeline([]))
+
+    def test_repr(self):
+        self.assertEqual(
+            "Pipeline([CountSource(start=1, end=2, delay_ms=0), "
+            "CountScale(factor=3), CountSum()])",
+            repr(Pipeline([CountSource(1, 2), CountScale(3), CountSum()])))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,85 @@
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import Priority
+from gild import queue_wait_histograms
+from gild import reset_latency_histograms
+from gild import set_executor
+from gild import set_worker_count
+from gild import wait_all
+
+import datetime
+import unittest
+
+
+class TestPriority(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        # One thread, kept busy, so every other Job queues.
+        set_executor(Executor.POOL)
+        set_worker_count(1)
+        self.blocker = launch(Count(1, 1, 100))
+
+    def tearDown(self):
+        self.blocker.abort()
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+
+    def test_high_before_low(self):
+        """
+        Queued HIGH Jobs start before LOW Jobs launched earlier.
+        """
+        low = launch_many((Count(1, 1, 1) for i in range(5)),
+                          priority=Priority.LOW)
+        high = [launch(Count(1, 1, 1), priority=Priority.HIGH)
+                for i in range(5)]
+        self.assertEqual(True, wait_all(list(low) + high, 10))
+        slowest_high = max(job.timings.queued for job in high)
+        fastest_low = min(job.timings.queued for job in low)
+        self.assertLess(slowest_high, fastest_low)
+
+    def test_earliest_deadline_first(self):
+        """
+        Within a Priority, the earliest deadline starts first.
+        """
+        jobs = [launch(Count(1, 1, 5), deadline=60 - i) for i in range(5)]
+        jobs.append(launch(Count(1, 1, 5),
+                           deadline=datetime.timedelta(seconds=30)))
+        self.assertEqual(True, wait_all(jobs, 10))
+        queued = [job.timings.queued for job in jobs]
+        self.assertEqual(queued[-1], min(queued))
+        self.assertEqual(sorted(queued[:-1], reverse=True), queued[:-1])
+
+    def test_low_is_not_starved(self):
+        """
+        A LOW Job starts even while HIGH Jobs keep arriving.
+        """
+        low = launch(Count(1, 1, 1), priority=Priority.LOW)
+        high = launch_many((Count(1, 1, 1) for i in range(60)),
+                           priority=Priority.HIGH)
+        self.assertEqual(True, low.wait_for_result(10))
+        self.assertLess(sum(1 for job in high if job.finished), len(high))
+        self.assertEqual(True, high.wait_for_result(10))
+
+    def test_queue_wait_histograms(self):
+        reset_latency_histograms()
+        jobs = [launch(Count(1, 1, 0), priority=level)
+                for level in (Priority.LOW, Priority.NORMAL,
+                              Priority.HIGH, Priority.HIGH)]
+        self.assertEqual(True, wait_all(jobs, 10))
+        histograms = queue_wait_histograms()
+        self.assertEqual(set(histograms), {'low', 'normal', 'high'})
+        self.assertEqual(histograms['low']['count'], 1)
+        self.assertEqual(histograms['normal']['count'], 1)
+        self.assertEqual(histograms['high']['count'], 2)
+        self.assertLess(histograms['high']['max'],
+                        histograms['low']['max'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,172 @@
+from gild import CancellationToken
+from gild import launch
+from gild import launch_many
+from gild import PythonJob
+from gild import State
+
+import threading
+import timeit
+import unittest
+
+
+class Recorder(PythonJob):
+    """
+    Records the hooks called, and on which thread.
+    """
+
+    def __init__(self, fail_in=None):
+        super().__init__()
+        self.calls = []
+        self.threads = set()
+        self.fail_in = fail_in
+
+    def record(self, name):
+        self.calls.append(name)
+        self.threads.add(threading.get_ident())
+        if self.fail_in == name:
+            raise ValueError(name)
+        return True
+
+    def on_setup(self, token):
+        return self.record('setup')
+
+    def on_working(self, token):
+        return self.record('working')
+
+    def on_teardown(self, token):
+        return self.record('teardown')
+
+
+class Steps(PythonJob):
+
+    def __init__(self, steps, chunk_size=1):
+        super().__init__()
+        self.chunk_size = chunk_size
+        self.steps = steps
+        self.taken = 0
+
+    def on_step(self):
+        self.taken += 1
+        return self.taken < self.steps
+
+
+class Sleeper(PythonJob):
+
+    def on_working(self, token):
+        self.token = token
+        return token.sleep_for(10)
+
+
+class TestPythonJob(unittest.TestCase):
+
+    def test_hooks_run_in_order_on_a_worker_thread(self):
+        recorder = Recorder()
+        job = launch(recorder)
+        self.assertEqual(True, job.wait_for_result(5))
+        self.assertEqual(['setup', 'working', 'teardown'], recorder.calls)
+        self.assertEqual(1, len(recorder.threads))
+        self.assertNotIn(threading.get_ident(), recorder.threads)
+        self.assertIs(recorder, job.input)
+        self.assertIs(recorder, job.output)
+
+    def test_exception_fails_the_job(self):
+        recorder = Recorder('working')
+        job = launch(recorder)
+        self.assertEqual(False, job.wait_for_result(5))
+        self.assertEqual(State.INCOMPLETE, job.state)
+        self.assertEqual(['setup', 'working', 'teardown'], recorder.calls)
+
+    def test_failed_setup_skips_working(self):
+        class FailSetup(Recorder):
+            def on_setup(self, token):
+                self.record('setup')
+                return False
+
+        recorder = FailSetup()
+        self.assertEqual(False, launch(recorder).wait_for_result(5))
+        self.assertEqual(['setup', 'teardown'], recorder.calls)
+
+    def test_steps(self):
+        for chunk_size in (1, 7, 1000):
+            steps = Steps(100, chunk_size)
+            self.assertEqual(True, launch(steps).wait_for_result(5))
+            self.assertEqual(100, steps.taken, chunk_size)
+
+    def test_steps_are_required(self):
+        """
+        Without on_working() or on_step(), there is nothing to do.
+        """
+        class Nothing(PythonJob):
+            pass
+
+        self.assertEqual(False, launch(Nothing()).wait_for_result(5))
+
+    def test_bad_chunk_size(self):
+        steps = Steps(1, 0)
+        with self.assertRaises(ValueError):
+            launch(steps)
+
+    def test_abort_interrupts_steps(self):
+        steps = Steps(10 ** 12, 100)
+        job = launch(steps)
+        while 0 == steps.taken:
+            pass
+        self.assertEqual(True, job.abort(5))
+        self.assertEqual(State.INCOMPLETE, job.state)
+        self.assertLess(steps.taken, 10 ** 12)
+
+    def test_abort_interrupts_sleep(self):
+        sleeper = Sleeper()
+        job = launch(sleeper)
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        self.assertEqual(True, job.abort(5))
+        self.assertLess(timeit.default_timer() - start_time, 1)
+        self.assertEqual(False, job.wait_for_result())
+        # The token outlives the Job.
+        self.assertIsInstance(sleeper.token, CancellationToken)
+        self.assertEqual(True, sleeper.token.stop_requested)
+        self.assertEqual(False, sleeper.token.keep_working)
+
+    def test_steps_share_the_gil(self):
+        """
+        Other Python threads run while Jobs take small chunks of steps.
+        """
+        group = launch_many(Steps(200000, 10) for i in range(2))
+        turns = 0
+        while not group.finished:
+            turns += 1
+        self.assertEqual(True, group.wait_for_result(30))
+        self.assertGreater(turns, 0)
+
+    def test_poll_finished(self):
+        """
+        Polling .finished doesn't keep the Job from finishing.
+        """
+        for i in range(20):
+            job = launch(Steps(1000))
+            while not job.finished:
+                pass
+            self.assertEqual(State.COMPLETE, job.state)
+
+    def test_drop_running_job(self):
+        """
+        Dropping an unfinished PythonJob aborts it, even though its
+        steps need the GIL to notice.
+        """
+        steps = Steps(10 ** 9)
+        job = launch(steps)
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        del job
+        self.assertLess(timeit.default_timer() - start_time, 5)
+        self.assertLess(steps.taken, 10 ** 9)
+
+    def test_repr(self):
+        self.assertEqual('Steps(chunk_size=3)', repr(Steps(1, 3)))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,180 @@
+from gild import Executor
+from gild import get_executor
+from gild import get_simd_level
+from gild import get_worker_count
+from gild import launch
+from gild import Reduce
+from gild import set_executor
+from gild import set_simd_level
+from gild import set_worker_count
+from gild import SimdLevel
+from gild import State
+from gild import supported_simd_level
+
+import array
+import threading
+import timeit
+import unittest
+
+
+class TestReduce(unittest.TestCase):
+
+    def setUp(self):
+        self.executor = get_executor()
+        self.worker_count = get_worker_count()
+        self.simd_level = get_simd_level()
+        set_executor(Executor.POOL)
+        set_worker_count(4)
+
+    def tearDown(self):
+        set_executor(self.executor)
+        set_worker_count(self.worker_count)
+        set_simd_level(self.simd_level)
+
+    def reduce(self, data, **kwargs):
+        job = launch(Reduce(data, **kwargs))
+        self.assertEqual(True, job.wait_for_result(10))
+        return job.output
+
+    def test_floats(self):
+        values = [(i * 7919) % 1000 / 8.0 - 40 for i in range(100003)]
+        for typecode in ('d', 'f'):
+            output = self.reduce(array.array(typecode, values),
+                                 min_chunk=1000)
+            self.assertEqual(len(values), output.count)
+            self.assertIsInstance(output.sum, float)
+            self.assertAlmostEqual(sum(values), output.sum, delta=1e-3)
+            self.assertEqual(min(values), output.min)
+            self.assertEqual(max(values), output.max)
+            self.assertAlmostEqual(sum(values) / len(values), output.mean)
+            self.assertEqual(len(values), output.processed)
+
+    def test_integers(self):
+        values = [(i * 7919) % 100000 - 30000 for i in range(100003)]
+        for typecode in ('i', 'q'):
+            output = self.reduce(array.array(typecode, values),
+                                 min_chunk=1000)
+            self.assertEqual(len(values), output.count)
+            self.assertIsInstance(output.sum, int)
+            self.assertEqual(sum(values), output.sum)
+            self.assertEqual(min(values), output.min)
+            self.assertEqual(max(values), output.max)
+
+    def test_every_simd_level(self):
+        values = array.array('d', [(i % 97) - 48.5 for i in range(10007)])
+        expected = self.reduce(values, bins=7)
+        for level in (SimdLevel.SCALAR, SimdLevel.AVX2, SimdLevel.AVX512):
+            self.assertLessEqual(set_simd_level(level),
+                                 supported_simd_level())
+            output = self.reduce(values, bins=7)
+            self.assertEqual(get_simd_level(), output.simd)
+            self.assertEqual(expected.sum, output.sum)
+            self.assertEqual(expected.min, output.min)
+            self.assertEqual(expected.max, output.max)
+            self.assertEqual(expected.histogram, output.histogram)
+
+    def test_histogram_with_range(self):
+        values = array.array('d', [0, 0.5, 1, 2.5, 3.99, 4, 5, -1])
+        output = self.reduce(values, bins=4, range=(0, 4))
+        # Like numpy.histogram, the last bin includes the top edge.
+        self.assertEqual([2, 1, 1, 2], output.histogram)
+        self.assertEqual((0.0, 4.0), output.range)
+        self.assertEqual(len(values), output.processed)
+
+    def test_histogram_without_range(self):
+        values = array.array('i', list(range(100)))
+        output = self.reduce(values, bins=10)
+        self.assertEqual([10] * 10, output.histogram)
+        self.assertEqual((0.0, 99.0), output.range)
+        # The items' min and max come from a first pass.
+        self.assertEqual(2 * len(values), output.processed)
+
+    def test_equal_items(self):
+        output = self.reduce(array.array('d', [3] * 10), bins=2)
+        self.assertEqual((2.5, 3.5), output.range)
+        self.assertEqual([0, 10], output.histogram)
+
+    def test_empty(self):
+        output = self.reduce(array.array('d'), bins=2)
+        self.assertEqual(0, output.count)
+        self.assertEqual(0.0, output.sum)
+        self.assertIsNone(output.min)
+        self.assertIsNone(output.mean)
+        self.assertEqual([0, 0], output.histogram)
+
+    def test_multidimensional(self):
+        data = memoryview(array.array('q', range(12))).cast('B').cast(
+            'q', (3, 4))
+        output = self.reduce(data)
+        self.assertEqual(12, output.count)
+        self.assertEqual(66, output.sum)
+
+    def test_bad_buffers(self):
+        with self.assertRaises(TypeError):
+            launch(Reduce(b'bytes'))
+        with self.assertRaises(TypeError):
+            launch(Reduce(array.array('h', [1, 2])))
+        with self.assertRaises(ValueError):
+            launch(Reduce(memoryview(array.array('d', range(10)))[::2]))
+        with self.assertRaises(ValueError):
+            launch(Reduce(array.array('d'), bins=2, range=(1, 1)))
+        with self.assertRaises(ValueError):
+            launch(Reduce(array.array('d'), min_chunk=0))
+
+    def test_abort(self):
+        # Slow enough to abort part way: one thread, scalar kernels.
+        set_worker_count(1)
+        set_simd_level(SimdLevel.SCALAR)
+        data = array.array('d', bytes(8 * 10 ** 7))
+        job = launch(Reduce(data, bins=1000))
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        self.assertEqual(True, job.abort(5))
+        self.assertLess(timeit.default_timer() - start_time, 0.5)
+        self.assertEqual(State.INCOMPLETE, job.state)
+        self.assertIsNone(job.output.sum)
+        self.assertLess(job.output.processed, 2 * len(data))
+
+    def test_progress(self):
+        done = threading.Event()
+        values = []
+        data = array.array('f', bytes(4 * 10 ** 6))
+        job = launch(Reduce(data, bins=4))
+        job.on_progress(lambda job, value: values.append(value))
+        job.on_done(lambda job: done.set())
+        self.assertTrue(done.wait(10))
+        self.assertEqual(State.COMPLETE, job.state)
+        self.assertEqual(2 * len(data), max(values))
+
+    def test_poll_finished(self):
+        """
+        Polling .finished doesn't keep the Job from finishing.
+        """
+        data = array.array('d', range(1000))
+        for i in range(20):
+            job = launch(Reduce(data, bins=10))
+            while not job.finished:
+                pass
+            self.assertEqual(State.COMPLETE, job.state)
+            self.assertEqual(999, job.output.max)
+
+    def test_drop_running_job(self):
+        """
+        Dropping an unfinished Job aborts it, and lets go of the buffer.
+        """
+        set_worker_count(1)
+        set_simd_level(SimdLevel.SCALAR)
+        data = array.array('d', bytes(8 * 10 ** 7))
+        job = launch(Reduce(data, bins=1000))
+        while job.state != State.WORKING:
+            pass
+        start_time = timeit.default_timer()
+        del job
+        self.assertLess(timeit.default_timer() - start_time, 5)
+        # Resizing fails while a buffer is exported.
+        data.append(0)
+
+
+if __name__ == '__main__':
+    unittest.main()
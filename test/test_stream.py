@@ -0,0 +1,108 @@
+from gild import Count
+from gild import launch
+from gild import OverflowPolicy
+from gild import State
+
+import time
+import unittest
+
+
+class TestStream(unittest.TestCase):
+
+    def test_drain_returns_every_value(self):
+        """
+        Every number counted can be drained, oldest first.
+        """
+        job = launch(Count(1, 1000, 0))
+        self.assertEqual(True, job.wait_for_result())
+        self.assertEqual(job.output.pushed, 1000)
+        self.assertEqual(job.output.pending, 1000)
+        self.assertEqual(job.output.drain(10), list(range(1, 11)))
+        self.assertEqual(job.output.drain(), list(range(11, 1001)))
+        self.assertEqual(job.output.drain(), [])
+        self.assertEqual(job.output.drained, 1000)
+        self.assertEqual(job.output.dropped, 0)
+
+    def test_drain_while_working(self):
+        """
+        Values can be drained while the Job is still producing them.
+        """
+        job = launch(Count(1, 20, 5))
+        values = []
+        while not job.finished:
+            values.extend(job.output.drain())
+            time.sleep(0.01)
+        values.extend(job.output.drain())
+        self.assertEqual(values, list(range(1, 21)))
+
+    def test_drop_oldest(self):
+        """
+        A full DROP_OLDEST stream keeps the newest values.
+        """
+        input = Count(1, 100, 0)
+        input.stream_capacity = 16
+        input.overflow = OverflowPolicy.DROP_OLDEST
+        job = launch(input)
+        self.assertEqual(True, job.wait_for_result())
+        self.assertEqual(job.output.capacity, 16)
+        self.assertEqual(job.output.dropped, 84)
+        self.assertEqual(job.output.drain(), list(range(85, 101)))
+
+    def test_drop_newest(self):
+        """
+        A full DROP_NEWEST stream keeps the oldest values.
+        """
+        input = Count(1, 100, 0)
+        input.stream_capacity = 10
+        input.overflow = OverflowPolicy.DROP_NEWEST
+        job = launch(input)
+        self.assertEqual(True, job.wait_for_result())
+        # Capacity is rounded up to a power of two.
+        self.assertEqual(job.output.capacity, 16)
+        self.assertEqual(job.output.pushed, 16)
+        self.assertEqual(job.output.dropped, 84)
+        self.assertEqual(job.output.drain(), list(range(1, 17)))
+        self.assertEqual(job.output.last, 100)
+
+    def test_block_waits_for_drain(self):
+        """
+        A full BLOCK stream holds the Job in WORKING until drained.
+        """
+        input = Count(1, 64, 0)
+        input.stream_capacity = 16
+        input.overflow = OverflowPolicy.BLOCK
+        job = launch(input)
+        values = []
+        while job.output.pushed < 16:
+            time.sleep(0.001)
+        time.sleep(0.05)
+        self.assertEqual(job.state, State.WORKING)
+        while len(values) < 64:
+            values.extend(job.output.drain())
+        self.assertEqual(True, job.wait_for_result())
+        self.assertEqual(values, list(range(1, 65)))
+        self.assertEqual(job.output.dropped, 0)
+
+    def test_abort_while_blocked(self):
+        """
+        A Job blocked on a full stream can still be aborted.
+        """
+        input = Count(1, 64, 0)
+        input.stream_capacity = 4
+        input.overflow = OverflowPolicy.BLOCK
+        job = launch(input)
+        while job.output.pushed < 4:
+            time.sleep(0.001)
+        job.abort()
+        self.assertEqual(False, job.wait_for_result())
+        self.assertEqual(job.output.pushed, 4)
+
+    def test_invalid_capacity(self):
+        input = Count(1, 10, 0)
+        input.stream_capacity = 0
+        with self.assertRaises(ValueError):
+            launch(input)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,102 @@
+from gild import Count
+from gild import Executor
+from gild import get_executor
+from gild import get_worker_count
+from gild import latency_histograms
+from gild import launch
+from gild import launch_many
+from gild import reset_latency_histograms
+from gild import set_executor
+from gild import set_worker_count
+
+import datetime
+import unittest
+
+
+class TestTimings(unittest.TestCase):
+
+    def test_phases_of_a_finished_job(self):
+        """
+        Every phase is timed, and they add up to the total.
+        """
+        job = launch(Count(1, 2, 50))
+        self.assertEqual(True, job.wait_for_result())
+        timings = job.timings
+        self.assertGreaterEqual(timings.setup.total_seconds(), 0.05)
+        self.assertGreaterEqual(timings.working.total_seconds(), 0.1)
+        self.assertGreaterEqual(timings.teardown.total_seconds(), 0.05)
+        self.assertEqual(job.elapsed, timings.working)
+        phases = (timings.queued + timings.setup + timings.working +
+                  timings.teardown)
+        self.assertLessEqual(abs(timings.total - phases),
+                             datetime.timedelta(microseconds=4))
+
+    def test_phases_in_progress(self):
+        """
+        Phases not yet entered are None; the current one counts up.
+        """
+        job = launch(Count(1, 1, 1000))
+        timings = job.timings
+        self.assertIsNotNone(timings.queued)
+        self.assertIsNotNone(timings.setup)
+        self.assertIsNone(timings.working)
+        self.assertIsNone(timings.teardown)
+        self.assertLess(job.timings.setup, datetime.timedelta(seconds=1))
+        job.abort()
+
+    def test_queued_time(self):
+        """
+        A Job waiting for a busy pool shows its queued time.
+        """
+        executor, count = get_executor(), get_worker_count()
+        try:
+            set_executor(Executor.POOL)
+            set_worker_count(1)
+            group = launch_many([Count(1, 1, 50), Count(1, 1, 0)])
+            self.assertEqual(True, group.wait_for_result())
+            self.assertGreaterEqual(group[1].timings.queued.total_seconds(),
+                                    0.1)
+        finally:
+            set_worker_count(count)
+            set_executor(executor)
+
+    def test_aborted_while_queued(self):
+        executor, count = get_executor(), get_worker_count()
+        try:
+            set_executor(Executor.POOL)
+            set_worker_count(1)
+            group = launch_many([Count(1, 1, 100), Count(1, 1, 0)])
+            group[1].abort(0)
+            self.assertEqual(False, group.wait_for_result())
+            timings = group[1].timings
+            self.assertIsNotNone(timings.queued)
+            self.assertIsNone(timings.setup)
+            self.assertIsNone(timings.working)
+            self.assertEqual(timings.queued, timings.total)
+        finally:
+            set_worker_count(count)
+            set_executor(executor)
+
+    def test_histograms(self):
+        """
+        Module-wide histograms count every phase of every Job.
+        """
+        reset_latency_histograms()
+        group = launch_many(Count(1, 1, 1) for i in range(100))
+        self.assertEqual(True, group.wait_for_result())
+        histograms = latency_histograms()
+        self.assertEqual(set(histograms),
+                         {'queued', 'setup', 'working', 'teardown', 'total'})
+        for name, summary in histograms.items():
+            self.assertEqual(summary['count'], 100, name)
+            self.assertLessEqual(summary['p50'], summary['p90'])
+            self.assertLessEqual(summary['p90'], summary['p99'])
+            self.assertLessEqual(summary['p99'], summary['max'])
+        self.assertGreaterEqual(histograms['setup']['p50'],
+                                datetime.timedelta(milliseconds=1))
+        self.assertGreaterEqual(histograms['total']['p50'],
+                                datetime.timedelta(milliseconds=3))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,88 @@
+from gild import Count
+from gild import launch
+from gild import launch_many
+from gild import trace
+from gild import wait_all
+
+import json
+import os
+import tempfile
+import unittest
+
+
+class TestTrace(unittest.TestCase):
+
+    def setUp(self):
+        trace.stop()
+        trace.clear()
+        handle, self.path = tempfile.mkstemp(suffix='.json')
+        os.close(handle)
+
+    def tearDown(self):
+        trace.stop()
+        trace.clear()
+        os.remove(self.path)
+
+    def load(self):
+        count = trace.dump(self.path)
+        with open(self.path) as file:
+            events = json.load(file)['traceEvents']
+        self.assertEqual(count, len(events))
+        return events
+
+    def named(self, events, phase, name):
+        return [event for event in events
+                if event['ph'] == phase and event['name'] == name]
+
+    def test_off_by_default(self):
+        self.assertEqual(False, trace.enabled())
+        job = launch(Count(1, 1, 0))
+        job.wait_for_result()
+        self.assertEqual(self.load(), [])
+
+    def test_records_job_lifecycles(self):
+        trace.start()
+        self.assertEqual(True, trace.enabled())
+        group = launch_many(Count(1, 2, 1) for i in range(10))
+        wait_all(group)
+        trace.stop()
+        del group
+
+        events = self.load()
+        for name in ('setup', 'working', 'teardown'):
+            phases = self.named(events, 'X', name)
+            self.assertEqual(len(phases), 10, name)
+            for phase in phases:
+                self.assertGreaterEqual(phase['dur'], 0)
+        self.assertEqual(len(self.named(events, 'b', 'job')), 10)
+        self.assertEqual(len(self.named(events, 'e', 'job')), 10)
+        self.assertEqual(len(self.named(events, 'b', 'queued')), 10)
+        self.assertGreaterEqual(len(self.named(events, 'X', 'wait')), 1)
+
+        # Every event is on a named thread.
+        threads = {event['tid'] for event in
+                   self.named(events, 'M', 'thread_name')}
+        for event in events:
+            self.assertIn(event['tid'], threads)
+
+    def test_records_aborts(self):
+        trace.start()
+        job = launch(Count(1, 100, 1000))
+        job.abort()
+        trace.stop()
+        events = self.load()
+        self.assertEqual(len(self.named(events, 'i', 'abort')), 1)
+        ends = self.named(events, 'e', 'job')
+        self.assertEqual(ends[0]['args']['state'], 'incomplete')
+
+    def test_clear(self):
+        trace.start()
+        launch(Count(1, 1, 0)).wait_for_result()
+        trace.stop()
+        self.assertNotEqual(self.load(), [])
+        trace.clear()
+        self.assertEqual(self.load(), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,110 @@
+from gild import as_completed
+from gild import Count
+from gild import get_worker_count
+from gild import launch
+from gild import launch_many
+from gild import set_worker_count
+from gild import wait_all
+from gild import wait_any
+
+import datetime
+import threading
+import timeit
+import unittest
+
+
+class TestWait(unittest.TestCase):
+
+    def setUp(self):
+        # Slow and fast Jobs need to run side by side.
+        self.worker_count = get_worker_count()
+        set_worker_count(max(2, self.worker_count))
+
+    def tearDown(self):
+        set_worker_count(self.worker_count)
+
+    def test_wait_all(self):
+        """
+        wait_all() returns True once every Job is finished.
+        """
+        jobs = [launch(Count(1, 2, 10)) for i in range(10)]
+        self.assertEqual(True, wait_all(jobs))
+        for job in jobs:
+            self.assertEqual(True, job.finished)
+
+    def test_wait_all_can_timeout(self):
+        """
+        Timeouts can be fractional seconds or timedeltas.
+        """
+        jobs = [launch(Count(1, 2, 200))]
+        start_time = timeit.default_timer()
+        self.assertEqual(False, wait_all(jobs, 0.1))
+        self.assertEqual(False, wait_all(
+            jobs, datetime.timedelta(milliseconds=100)))
+        elapsed = timeit.default_timer() - start_time
+        self.assertGreaterEqual(elapsed, 0.2)
+        self.assertLess(elapsed, 0.5)
+        self.assertEqual(True, wait_all(jobs, datetime.timedelta(seconds=5)))
+
+    def test_huge_timeouts_wait_forever(self):
+        """
+        Timeouts too long for the clocks (or infinite) wait forever.
+        """
+        for timeout in (float('inf'), 1e300, datetime.timedelta.max):
+            job = launch(Count(1, 2, 10))
+            self.assertEqual(True, job.wait_for_result(timeout))
+            group = launch_many([Count(1, 2, 10)])
+            self.assertEqual(True, group.wait_for_result(timeout))
+            self.assertEqual(True, wait_all([job, group[0]], timeout))
+            self.assertEqual(True, job.abort(timeout))
+
+    def test_wait_any(self):
+        """
+        wait_any() returns the first Job to finish, or None.
+        """
+        slow = launch(Count(1, 2, 300))
+        fast = launch(Count(1, 1, 10))
+        self.assertIs(wait_any([slow, fast]), fast)
+        self.assertIsNone(wait_any([slow], 0.01))
+
+    def test_as_completed(self):
+        """
+        as_completed() yields Jobs in the order they finish.
+        """
+        slow = launch(Count(1, 2, 100))
+        fast = launch(Count(1, 1, 10))
+        self.assertEqual([fast, slow], list(as_completed([slow, fast])))
+
+    def test_as_completed_can_timeout(self):
+        """
+        as_completed() raises TimeoutError like concurrent.futures.
+        """
+        job = launch(Count(1, 2, 200))
+        with self.assertRaises(TimeoutError):
+            for finished in as_completed([job], timeout=0.05):
+                pass
+
+    def test_waits_release_gil(self):
+        """
+        Another Python thread keeps running while we wait.
+        """
+        ticks = []
+        stop = threading.Event()
+
+        def tick():
+            while not stop.is_set():
+                ticks.append(1)
+                stop.wait(0.01)
+
+        thread = threading.Thread(target=tick)
+        thread.start()
+        job = launch(Count(1, 1, 100))
+        ticks.clear()
+        self.assertEqual(True, job.wait_for_result(timeout_in_seconds=2.5))
+        stop.set()
+        thread.join()
+        self.assertGreater(len(ticks), 5)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,279 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "admission.h"
+#include "metrics.h"
+#include "wait.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+namespace
+{
+    struct admission_state
+    {
+        std::mutex mutex = {};
+        std::condition_variable freed = {};
+
+        /// @brief Zero for no limit.  Read without the mutex, so an
+        ///        unlimited launch() never takes it.
+        std::atomic<std::size_t> max_jobs = {0};
+        worker::admission_policy policy = worker::admission_policy::block;
+        double timeout_in_seconds = 0;
+
+        /// @brief Slots held by tickets and jobs.
+        std::size_t in_flight = 0;
+    };
+
+    admission_state &get_state()
+    {
+        // Leaked, like the executors: jobs may finish during exit.
+        static auto result = new admission_state();
+        return *result;
+    }
+
+    void give_back(std::size_t slots)
+    {
+        if (0 == slots)
+        {
+            return;
+        }
+        auto &admission = get_state();
+        {
+            std::lock_guard<std::mutex> lock(admission.mutex);
+            admission.in_flight -= slots;
+        }
+        admission.freed.notify_all();
+    }
+
+    void count_rejected(std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            worker::add_metric(worker::metric::jobs_rejected);
+        }
+    }
+
+    /**
+     * @brief Take 'count' slots, waiting or throwing per the policy.
+     * @return The slots taken (zero if there is no limit).
+     */
+    std::size_t admit(std::size_t count)
+    {
+        auto &admission = get_state();
+        if (0 == count || 0 == admission.max_jobs.load())
+        {
+            return 0;
+        }
+
+        // First try without giving up the GIL.
+        auto policy = worker::admission_policy::block;
+        auto timeout_in_seconds = 0.0;
+        {
+            std::lock_guard<std::mutex> lock(admission.mutex);
+            const auto max_jobs = admission.max_jobs.load();
+            if (0 == max_jobs)
+            {
+                return 0;
+            }
+            if (max_jobs < count)
+            {
+                count_rejected(count);
+                throw worker::admission_error(
+                    "Can't launch " + std::to_string(count) +
+                    " Jobs at once with an admission limit of " +
+                    std::to_string(max_jobs));
+            }
+            if (admission.in_flight + count <= max_jobs)
+            {
+                admission.in_flight += count;
+                return count;
+            }
+            policy = admission.policy;
+            timeout_in_seconds = admission.timeout_in_seconds;
+        }
+
+        if (worker::admission_policy::reject == policy)
+        {
+            count_rejected(count);
+            throw worker::admission_error("Too many Jobs in flight");
+        }
+
+        worker::add_metric(worker::metric::launches_throttled);
+        auto admitted = false;
+        auto unlimited = false;
+        {
+            // Declared in this order so the mutex is unlocked before
+            // the GIL is taken back.
+            pybind11::gil_scoped_release release;
+            std::unique_lock<std::mutex> lock(admission.mutex);
+            auto fits = [&] {
+                const auto max_jobs = admission.max_jobs.load();
+                unlimited = 0 == max_jobs;
+                return unlimited || admission.in_flight + count <= max_jobs;
+            };
+            if (worker::admission_policy::block == policy)
+            {
+                admission.freed.wait(lock, fits);
+                admitted = true;
+            }
+            else
+            {
+                admitted = admission.freed.wait_for(
+                    lock, std::chrono::duration<double>(timeout_in_seconds),
+                    fits);
+            }
+            if (admitted && !unlimited)
+            {
+                admission.in_flight += count;
+            }
+        }
+
+        if (!admitted)
+        {
+            count_rejected(count);
+            throw worker::admission_error(
+                "Timed out waiting for Jobs in flight to finish");
+        }
+        return unlimited ? 0 : count;
+    }
+}
+
+void worker::set_admission_limit(std::size_t max_jobs,
+                                 admission_policy policy,
+                                 double timeout_in_seconds)
+{
+    auto &admission = get_state();
+    {
+        std::lock_guard<std::mutex> lock(admission.mutex);
+        admission.max_jobs = max_jobs;
+        admission.policy = policy;
+        admission.timeout_in_seconds = timeout_in_seconds;
+    }
+    // Waiters recheck against the new limit.
+    admission.freed.notify_all();
+}
+
+worker::admission_ticket::admission_ticket(std::size_t count)
+    : m_slots(admit(count))
+{
+}
+
+worker::admission_ticket::~admission_ticket() { give_back(m_slots); }
+
+void worker::admission_ticket::assign(job::control_t &control)
+{
+    if (0 < m_slots)
+    {
+        control.admitted = true;
+        --m_slots;
+    }
+}
+
+void worker::release_admission(job::control_t &control)
+{
+    if (control.admitted)
+    {
+        give_back(1);
+    }
+}
+
+pybind11::module &worker::bind_worker_admission(pybind11::module &module)
+{
+    pybind11::enum_<admission_policy>(module, "AdmissionPolicy", R"pbdoc(
+What launch() does when the admission limit is reached.
+)pbdoc")
+        .value("BLOCK", admission_policy::block,
+               "Wait, with the GIL released, until enough Jobs finish")
+        .value("REJECT", admission_policy::reject,
+               "Raise AdmissionError at once")
+        .value("TIMEOUT", admission_policy::timeout,
+               "Wait up to the timeout, then raise AdmissionError");
+
+    pybind11::register_exception<admission_error>(module, "AdmissionError",
+                                                  PyExc_RuntimeError);
+
+    module.def(
+        "set_admission_limit",
+        [](std::size_t max_jobs, admission_policy policy,
+           pybind11::object timeout) {
+            const auto timeout_in_seconds = to_timeout_in_seconds(timeout);
+            if (admission_policy::timeout == policy && 0 > timeout_in_seconds)
+            {
+                throw std::invalid_argument(
+                    "AdmissionPolicy.TIMEOUT needs a timeout");
+            }
+            set_admission_limit(max_jobs, policy, timeout_in_seconds);
+        },
+        R"pbdoc(
+Limit the number of Jobs that are launched but not yet finished.
+
+Without a limit (the default), every launch() is accepted at once.
+With Executor.THREAD, that means a thread for every Job.
+
+Parameters
+----------
+max_jobs: The most Jobs queued or running at once, or 0 for no
+  limit.  launch_many() counts every Job it launches.
+policy: The AdmissionPolicy for a launch that would exceed the limit.
+timeout: For AdmissionPolicy.TIMEOUT, the most time to wait, as a
+  number of seconds (fractions allowed) or a datetime.timedelta.
+
+Jobs launched while there was no limit never count against one.
+Refused launches raise AdmissionError, and are counted in metrics()
+as 'jobs_rejected'.  Launches that had to wait are counted as
+'launches_throttled'.
+)pbdoc",
+        pybind11::arg("max_jobs"),
+        pybind11::arg("policy") = admission_policy::block,
+        pybind11::arg("timeout") = pybind11::none());
+
+    module.def(
+        "admission",
+        [] {
+            auto &admission = get_state();
+            std::lock_guard<std::mutex> lock(admission.mutex);
+            pybind11::dict result;
+            result["max_jobs"] = admission.max_jobs.load();
+            result["policy"] = admission.policy;
+            result["timeout"] =
+                0 > admission.timeout_in_seconds
+                    ? pybind11::object(pybind11::none())
+                    : pybind11::object(
+                          pybind11::float_(admission.timeout_in_seconds));
+            result["in_flight"] = admission.in_flight;
+            return result;
+        },
+        R"pbdoc(
+Return the admission settings and the Jobs counted against them.
+
+Returns
+----------
+A dict with the 'max_jobs', 'policy' and 'timeout' given to
+set_admission_limit(), and 'in_flight', the number of admitted Jobs
+that have not finished yet.
+)pbdoc");
+    return module;
+}
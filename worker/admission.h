@@ -0,0 +1,104 @@
+#ifndef WORKER_ADMISSION_H
+#define WORKER_ADMISSION_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "job.h"
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace worker
+{
+    ///
+    /// \brief What launch() does when the admission limit is reached.
+    ///
+    enum class admission_policy
+    {
+        block,  ///< Wait (without the GIL) until enough jobs finish
+        reject, ///< Throw admission_error at once
+        timeout ///< Wait up to the timeout, then throw admission_error
+    };
+
+    ///
+    /// \brief Thrown when jobs are refused by admission control.
+    ///
+    struct admission_error : public std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * @brief Limit the jobs that are launched but not finished.
+     *
+     *        Jobs admitted before the call keep counting against the
+     *        new limit.  Jobs launched while there was no limit never
+     *        count.
+     *
+     * @param max_jobs The most jobs queued or running at once, or 0
+     *        for no limit (the default).
+     * @param policy What to do when a launch would exceed the limit.
+     * @param timeout_in_seconds How long admission_policy::timeout
+     *        waits.  Ignored by the other policies.
+     */
+    void set_admission_limit(std::size_t max_jobs, admission_policy policy,
+                             double timeout_in_seconds);
+
+    ///
+    /// \brief Holds admission for jobs about to be launched.
+    ///
+    /// The constructor waits or throws, according to the policy.
+    /// Each admitted job is then assigned a slot, which it gives back
+    /// when it finishes.  Slots never assigned (for example, because
+    /// preparing a job threw) are given back by the destructor.
+    /// Call with the GIL held.
+    ///
+    class admission_ticket
+    {
+    public:
+        explicit admission_ticket(std::size_t count);
+        ~admission_ticket();
+
+        /// @brief Hand one of the ticket's slots to a job.
+        void assign(job::control_t &control);
+
+        admission_ticket(const admission_ticket &) = delete;
+        admission_ticket(admission_ticket &&) = delete;
+        admission_ticket &operator=(const admission_ticket &) = delete;
+        admission_ticket &operator=(admission_ticket &&) = delete;
+
+    private:
+        std::size_t m_slots;
+    };
+
+    /**
+     * @brief Give back a finished job's slot, if it holds one.
+     */
+    void release_admission(job::control_t &control);
+
+    pybind11::module &bind_worker_admission(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_ADMISSION_H
@@ -0,0 +1,275 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "async_channel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <mutex>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace
+{
+    ///
+    /// \brief Python-side state.  Only touched under the mutex, which
+    ///        is never held while calling into Python, as for the
+    ///        dispatcher's watchers.
+    ///
+    struct awaiters_t
+    {
+        struct waiting_t
+        {
+            /// @brief Keeps the address (our key) from being reused.
+            worker::job::control_ptr_t control = {};
+            /// @brief Keeps 'await launch(...)' from aborting the job
+            ///        when the temporary Job object is released.
+            pybind11::object job = {};
+            std::vector<pybind11::object> futures = {};
+        };
+
+        /// @brief Futures waiting on each job, by control block.
+        std::unordered_map<const worker::job::control_t *, waiting_t>
+            waiting = {};
+        /// @brief Event loops that already have our reader.
+        std::vector<pybind11::object> loops = {};
+        std::mutex mutex = {};
+    };
+
+    awaiters_t &awaiters()
+    {
+        // Deliberately leaked.  It holds Python objects, which must
+        // not be released after the interpreter has shut down.
+        static auto result = new awaiters_t();
+        return *result;
+    }
+
+    void set_result(pybind11::object future, bool result)
+    {
+        if (future.attr("done")().cast<bool>())
+        {
+            // Cancelled while we were waiting.
+            return;
+        }
+        auto loop = future.attr("get_loop")();
+        auto running =
+            pybind11::module::import("asyncio").attr("_get_running_loop")();
+        if (loop.is(running))
+        {
+            future.attr("set_result")(result);
+        }
+        else
+        {
+            loop.attr("call_soon_threadsafe")(future.attr("set_result"),
+                                              result);
+        }
+    }
+
+    void on_readable()
+    {
+        auto &state = awaiters();
+        for (const auto &control : worker::job_async_channel().drain())
+        {
+            awaiters_t::waiting_t waiting;
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                auto found = state.waiting.find(control.get());
+                if (state.waiting.end() == found)
+                {
+                    // Already resolved by await_job().
+                    continue;
+                }
+                waiting = std::move(found->second);
+                state.waiting.erase(found);
+            }
+            const auto result = worker::state::complete == control->state;
+            for (auto &future : waiting.futures)
+            {
+                set_result(future, result);
+            }
+        }
+    }
+
+    void register_reader(pybind11::object loop)
+    {
+        auto &state = awaiters();
+        std::vector<pybind11::object> loops;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            loops = state.loops;
+        }
+        std::vector<pybind11::object> closed;
+        for (const auto &known : loops)
+        {
+            if (known.is(loop))
+            {
+                return;
+            }
+            if (known.attr("is_closed")().cast<bool>())
+            {
+                closed.push_back(known);
+            }
+        }
+        loop.attr("add_reader")(worker::job_async_channel().fd(),
+                                pybind11::cpp_function(&on_readable));
+
+        // Another thread may have added the same loop meanwhile:
+        // add_reader() then just replaced its reader.  The closed
+        // loops are released after the mutex, with 'closed'.
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto &known = state.loops;
+        const auto is_loop = [&loop](const pybind11::object &item) {
+            return item.is(loop);
+        };
+        for (const auto &gone : closed)
+        {
+            known.erase(std::remove_if(known.begin(), known.end(),
+                                       [&gone](const pybind11::object &item) {
+                                           return item.is(gone);
+                                       }),
+                        known.end());
+        }
+        if (std::none_of(known.begin(), known.end(), is_loop))
+        {
+            known.push_back(std::move(loop));
+        }
+    }
+}
+
+worker::async_channel::async_channel()
+{
+#ifdef __linux__
+    m_read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_write_fd = m_read_fd;
+    if (0 > m_read_fd)
+    {
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+    }
+#else
+    int fds[2] = {-1, -1};
+    if (0 != pipe(fds))
+    {
+        throw std::system_error(errno, std::generic_category(), "pipe");
+    }
+    m_read_fd = fds[0];
+    m_write_fd = fds[1];
+    for (auto fd : fds)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+}
+
+worker::async_channel::~async_channel()
+{
+    if (m_write_fd != m_read_fd)
+    {
+        close(m_write_fd);
+    }
+    close(m_read_fd);
+}
+
+void worker::async_channel::post(job::control_ptr_t control)
+{
+    auto was_empty = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        was_empty = m_posted.empty();
+        m_posted.push_back(std::move(control));
+    }
+    if (was_empty)
+    {
+        // One wakeup per batch.  A failed write means the counter
+        // (or pipe) is already full, which still wakes the reader.
+        const std::uint64_t one = 1;
+        auto written = write(m_write_fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+worker::async_channel::jobs_t worker::async_channel::drain()
+{
+    // Clear the wakeup before taking the jobs, so a job posted after
+    // the swap always makes the descriptor readable again.
+    std::uint64_t buffer[64];
+    while (0 < read(m_read_fd, buffer, sizeof(buffer)))
+    {
+    }
+
+    jobs_t result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    result.swap(m_posted);
+    return result;
+}
+
+worker::async_channel &worker::job_async_channel()
+{
+    // Deliberately leaked, like the executors.  Worker threads may
+    // still post to it while the process exits.
+    static auto result = new async_channel();
+    return *result;
+}
+
+pybind11::object worker::await_job(pybind11::object job_object)
+{
+    auto &job = job_object.cast<worker::job &>();
+    auto loop = pybind11::module::import("asyncio").attr("get_running_loop")();
+    register_reader(loop);
+
+    auto future = loop.attr("create_future")();
+    // run_job checks 'awaited' after setting the final state, so
+    // either it posts the job or we see the final state here.  The
+    // mutex keeps on_readable() from taking the post in between.
+    job.control->awaited = true;
+    auto &awaiting = awaiters();
+    std::unique_lock<std::mutex> lock(awaiting.mutex);
+    switch (job.get_state())
+    {
+    case state::complete:
+    case state::incomplete:
+        lock.unlock();
+        future.attr("set_result")(state::complete == job.get_state());
+        break;
+    case state::not_started:
+    case state::setup:
+    case state::working:
+    case state::teardown:
+    {
+        auto &waiting = awaiting.waiting[job.control.get()];
+        waiting.control = job.control;
+        waiting.job = job_object;
+        waiting.futures.push_back(future);
+        lock.unlock();
+        break;
+    }
+    }
+    return future.attr("__await__")();
+}
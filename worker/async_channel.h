@@ -0,0 +1,95 @@
+#ifndef WORKER_ASYNC_CHANNEL_H
+#define WORKER_ASYNC_CHANNEL_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./job.h"
+
+#include <mutex>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Hands finished jobs to asyncio event loops.
+    ///
+    /// Worker threads post() finished jobs that somebody is awaiting.
+    /// The first post() after a drain() makes fd() readable (an
+    /// eventfd on Linux, a pipe elsewhere).  Each event loop that
+    /// awaits a Job registers fd() once with loop.add_reader(), and
+    /// the reader callback resolves the futures of every job posted
+    /// since the last drain().  So any number of outstanding jobs
+    /// costs one file descriptor and no polling threads.
+    ///
+    class async_channel
+    {
+    public:
+        typedef std::vector<job::control_ptr_t> jobs_t;
+
+        async_channel();
+        ~async_channel();
+
+        /**
+         * @brief The descriptor to register with the event loop.
+         */
+        int fd() const { return m_read_fd; }
+
+        /**
+         * @brief Queue a finished job.  Called from worker threads.
+         */
+        void post(job::control_ptr_t control);
+
+        /**
+         * @brief Take every job posted since the last drain().
+         */
+        jobs_t drain();
+
+        // Owns file descriptors.
+        async_channel(const async_channel &) = delete;
+        async_channel(async_channel &&) = delete;
+        async_channel &operator=(const async_channel &) = delete;
+        async_channel &operator=(async_channel &&) = delete;
+
+    private:
+        int m_read_fd = -1;
+        int m_write_fd = -1;
+        std::mutex m_mutex = {};
+        jobs_t m_posted = {};
+    };
+
+    /**
+     * @brief The channel used by Job.__await__().
+     */
+    async_channel &job_async_channel();
+
+    /**
+     * @brief Implement Job.__await__().
+     * @param job The Job object being awaited.
+     * @return An iterator that finishes with True if the job
+     *        completed successfully, False otherwise.
+     */
+    pybind11::object await_job(pybind11::object job);
+
+} // end namespace worker
+
+#endif // WORKER_ASYNC_CHANNEL_H
@@ -0,0 +1,178 @@
+#ifndef WORKER_CANCELLATION_H
+#define WORKER_CANCELLATION_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace worker
+{
+    class stop_callback;
+
+    ///
+    /// \brief Tells a runnable that its job has been aborted.
+    ///
+    /// stop_requested() is a relaxed load, cheap enough to call on
+    /// every iteration of an inner loop.  sleep_for() and wait_for()
+    /// return as soon as a stop is requested, and stop_callback
+    /// objects let a runnable interrupt anything else it blocks on.
+    ///
+    class cancellation_token
+    {
+    public:
+        cancellation_token() = default;
+
+        /// @brief True once request_stop() has been called.
+        bool stop_requested() const
+        {
+            return m_stopped.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Request a stop: wake sleepers and run callbacks (on
+         *        this thread).
+         * @return True if this call made the request.
+         */
+        bool request_stop();
+
+        /**
+         * @brief Sleep, unless a stop is requested first.
+         * @return True if the whole duration passed without a stop.
+         */
+        template <typename Rep, typename Period>
+        bool sleep_for(const std::chrono::duration<Rep, Period> &duration) const
+        {
+            return !wait_for(duration);
+        }
+
+        /**
+         * @brief Wait up to 'duration' for a stop to be requested.
+         * @return True if a stop was requested.
+         */
+        template <typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> &duration) const
+        {
+            if (stop_requested() || duration <= duration.zero())
+            {
+                return stop_requested();
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_condition.wait_for(lock, duration,
+                                        [this] { return stop_requested(); });
+        }
+
+        // Runnables hold it by reference while the job owns it.
+        cancellation_token(const cancellation_token &) = delete;
+        cancellation_token(cancellation_token &&) = delete;
+        cancellation_token &operator=(const cancellation_token &) = delete;
+        cancellation_token &operator=(cancellation_token &&) = delete;
+
+    private:
+        friend class stop_callback;
+
+        std::atomic<bool> m_stopped = {false};
+        mutable std::mutex m_mutex = {};
+        mutable std::condition_variable m_condition = {};
+        mutable stop_callback *m_callbacks = {nullptr};
+    };
+
+    ///
+    /// \brief Calls a function when a stop is requested on a token.
+    ///
+    /// The function runs at once if the stop was already requested.
+    /// Destroying the stop_callback deregisters it, waiting for the
+    /// function to return if it is running.  The function must not
+    /// create or destroy stop_callback objects for the same token.
+    ///
+    class stop_callback
+    {
+    public:
+        stop_callback(const cancellation_token &token,
+                      std::function<void()> callback);
+        ~stop_callback();
+
+        stop_callback(const stop_callback &) = delete;
+        stop_callback(stop_callback &&) = delete;
+        stop_callback &operator=(const stop_callback &) = delete;
+        stop_callback &operator=(stop_callback &&) = delete;
+
+    private:
+        friend class cancellation_token;
+
+        const cancellation_token &m_token;
+        std::function<void()> m_callback;
+        stop_callback *m_next = {nullptr};
+    };
+
+    inline bool cancellation_token::request_stop()
+    {
+        if (m_stopped.exchange(true))
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_all();
+        for (auto callback = m_callbacks; callback;
+             callback = callback->m_next)
+        {
+            callback->m_callback();
+        }
+        return true;
+    }
+
+    inline stop_callback::stop_callback(const cancellation_token &token,
+                                        std::function<void()> callback)
+        : m_token(token), m_callback(std::move(callback))
+    {
+        std::unique_lock<std::mutex> lock(m_token.m_mutex);
+        if (m_token.stop_requested())
+        {
+            lock.unlock();
+            m_callback();
+            return;
+        }
+        m_next = m_token.m_callbacks;
+        m_token.m_callbacks = this;
+    }
+
+    inline stop_callback::~stop_callback()
+    {
+        std::lock_guard<std::mutex> lock(m_token.m_mutex);
+        for (auto link = &m_token.m_callbacks; *link;
+             link = &(*link)->m_next)
+        {
+            if (this == *link)
+            {
+                *link = m_next;
+                break;
+            }
+        }
+    }
+
+} // end namespace worker
+
+#endif // WORKER_CANCELLATION_H
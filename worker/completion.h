@@ -0,0 +1,123 @@
+#ifndef WORKER_COMPLETION_H
+#define WORKER_COMPLETION_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace worker
+{
+    ///
+    /// \brief Broadcast "some job finished" to any number of waiters.
+    ///
+    /// Every job bumps the generation count when it finishes.  A
+    /// waiter reads generation(), checks the jobs it cares about,
+    /// and if none are done, waits for the generation to change.
+    /// Because the check happens after the generation is read, a
+    /// job that finishes in between is never missed.
+    ///
+    /// notify() only takes the lock when somebody is waiting, so a
+    /// finishing job with no waiters pays for one atomic increment.
+    ///
+    class completion_signal
+    {
+    public:
+        typedef std::uint64_t generation_t;
+        typedef std::chrono::steady_clock clock_t;
+
+        completion_signal() = default;
+
+        /**
+         * @brief Return the current generation.
+         */
+        generation_t generation() const { return m_generation; }
+
+        /**
+         * @brief Wake all waiters.  Called when a job finishes.
+         */
+        void notify()
+        {
+            ++m_generation;
+            if (0 != m_waiters)
+            {
+                {
+                    // Make sure a waiter isn't between its check
+                    // and its wait.
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                }
+                m_condition.notify_all();
+            }
+        }
+
+        /**
+         * @brief Wait until the generation is no longer 'seen'.
+         */
+        void wait(generation_t seen)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_waiters;
+            m_condition.wait(lock, [&] { return seen != m_generation; });
+            --m_waiters;
+        }
+
+        /**
+         * @brief Wait until the generation is no longer 'seen', or
+         *        until the deadline.
+         * @return True if the generation changed.
+         */
+        bool wait_until(generation_t seen, clock_t::time_point deadline)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_waiters;
+            auto result = m_condition.wait_until(
+                lock, deadline, [&] { return seen != m_generation; });
+            --m_waiters;
+            return result;
+        }
+
+        // Waiters hold a reference to the signal.
+        completion_signal(const completion_signal &) = delete;
+        completion_signal(completion_signal &&) = delete;
+        completion_signal &operator=(const completion_signal &) = delete;
+        completion_signal &operator=(completion_signal &&) = delete;
+        ~completion_signal() = default;
+
+    private:
+        std::atomic<generation_t> m_generation = {0};
+        std::atomic<std::size_t> m_waiters = {0};
+        std::mutex m_mutex = {};
+        std::condition_variable m_condition = {};
+    };
+
+    /**
+     * @brief The signal raised whenever any job finishes.
+     */
+    completion_signal &job_completions();
+
+} // end namespace worker
+
+#endif // WORKER_COMPLETION_H
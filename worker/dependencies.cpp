@@ -0,0 +1,147 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "dependencies.h"
+
+///
+/// \brief A job waiting on a prerequisite, in the prerequisite's
+///        job::control_t::dependents list.
+///
+struct worker::dependent_link final : public worker::pooled
+{
+    dependent_link(job::control_ptr_t dependent, dependent_link *next)
+        : dependent(std::move(dependent)), next(next)
+    {
+    }
+
+    job::control_ptr_t dependent = {};
+    dependent_link *next = {};
+
+    dependent_link(const dependent_link &rhs) = delete;
+    dependent_link(dependent_link &&rhs) = delete;
+    dependent_link &operator=(const dependent_link &rhs) = delete;
+    dependent_link &operator=(dependent_link &&rhs) = delete;
+    ~dependent_link() = default;
+};
+
+namespace
+{
+    /**
+     * @brief The list head of a job that has finished.
+     *
+     *        Only its address is used.  A prerequisite's list is
+     *        swapped for this when it finishes, so a dependent added
+     *        afterwards knows not to wait.
+     */
+    worker::dependent_link *closed_list()
+    {
+        static worker::dependent_link closed(nullptr, nullptr);
+        return &closed;
+    }
+
+    /**
+     * @brief Count down one of a job's blockers, submitting it when
+     *        none remain.
+     */
+    void release_blocker(const worker::job::control_ptr_t &control,
+                         bool prerequisite_complete)
+    {
+        if (!prerequisite_complete)
+        {
+            // No point waiting for the rest.
+            control->cancellation.request_stop();
+            worker::submit_if_deferred(*control);
+        }
+        if (1 == control->blockers.fetch_sub(1, std::memory_order_acq_rel))
+        {
+            worker::submit_if_deferred(*control);
+        }
+    }
+
+    void add_dependency(const worker::job::control_ptr_t &dependent,
+                        worker::job::control_t &prerequisite)
+    {
+        auto head = prerequisite.dependents.load(std::memory_order_acquire);
+        if (closed_list() != head)
+        {
+            auto link = new worker::dependent_link(dependent, head);
+            while (closed_list() != head)
+            {
+                link->next = head;
+                if (prerequisite.dependents.compare_exchange_weak(
+                        head, link, std::memory_order_release,
+                        std::memory_order_acquire))
+                {
+                    return;
+                }
+            }
+            delete link;
+        }
+
+        // Finished before we could add ourselves, so its final state
+        // is already visible.
+        release_blocker(dependent,
+                        worker::state::complete == prerequisite.state);
+    }
+}
+
+void worker::submit_after(const job::control_ptr_t &control,
+                          executor::task_t task,
+                          const std::vector<job::control_ptr_t> &prerequisites)
+{
+    control->deferred_task = std::move(task);
+    control->deferred.store(true, std::memory_order_release);
+
+    // One extra blocker, released below, so the job can't be
+    // submitted until every prerequisite has been added.
+    control->blockers = prerequisites.size() + 1;
+    for (auto &prerequisite : prerequisites)
+    {
+        add_dependency(control, *prerequisite);
+    }
+    release_blocker(control, true);
+}
+
+void worker::release_dependents(job::control_t &finished)
+{
+    const auto complete = state::complete == finished.state;
+    auto link = finished.dependents.exchange(closed_list(),
+                                             std::memory_order_acq_rel);
+    while (nullptr != link)
+    {
+        auto next = link->next;
+        release_blocker(link->dependent, complete);
+        delete link;
+        link = next;
+    }
+}
+
+void worker::submit_if_deferred(job::control_t &control)
+{
+    if (control.deferred.load(std::memory_order_acquire) &&
+        control.deferred.exchange(false, std::memory_order_acq_rel))
+    {
+        get_executor().submit(std::move(control.deferred_task),
+                              control.schedule);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef WORKER_DEPENDENCIES_H
+#define WORKER_DEPENDENCIES_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./executor.h"
+#include "./job.h"
+
+#include <vector>
+
+namespace worker
+{
+    /**
+     * @brief Hold a job's task back until its prerequisites finish.
+     *
+     *        The last prerequisite to finish submits the task from
+     *        its own worker thread, so a chain of jobs runs without
+     *        coming back to Python.  If any prerequisite finishes
+     *        incomplete, the job is cancelled and submitted right
+     *        away, so it finishes incomplete too (and so on down
+     *        the chain).
+     *
+     * @param control The waiting job, still in state::not_started.
+     * @param task The task that runs it.
+     * @param prerequisites The jobs it waits for.  Any that have
+     *        already finished are accounted for immediately.
+     */
+    void submit_after(const job::control_ptr_t &control,
+                      executor::task_t task,
+                      const std::vector<job::control_ptr_t> &prerequisites);
+
+    /**
+     * @brief Tell the jobs waiting on a finished job that it is done.
+     *
+     *        Called by the worker thread once the job has entered
+     *        its final state.  Later submit_after() calls see the
+     *        job as already finished.
+     */
+    void release_dependents(job::control_t &finished);
+
+    /**
+     * @brief Submit a job's held-back task now, if it still has one.
+     *
+     *        Used when a waiting job is aborted, so it finishes
+     *        (incomplete) without waiting for its prerequisites.
+     */
+    void submit_if_deferred(job::control_t &control);
+
+} // end namespace worker
+
+#endif // WORKER_DEPENDENCIES_H
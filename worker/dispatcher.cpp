@@ -0,0 +1,453 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "dispatcher.h"
+#include "pool_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    /// @brief The job whose hooks are running on this thread.
+    thread_local const worker::job::control_ptr_t *this_thread_job = nullptr;
+
+    ///
+    /// \brief A progress report or completion, queued for delivery.
+    ///
+    struct event final : public worker::pooled
+    {
+        event(worker::job::control_ptr_t control_, bool done_)
+            : control(std::move(control_)), done(done_)
+        {
+        }
+
+        worker::job::control_ptr_t control;
+        bool done;
+        event *next = {nullptr};
+
+        // Linked by address.
+        event(const event &) = delete;
+        event(event &&) = delete;
+        event &operator=(const event &) = delete;
+        event &operator=(event &&) = delete;
+    };
+
+    ///
+    /// \brief Python-side state.  Only touched under the mutex, which
+    ///        is never held while calling into Python (or releasing an
+    ///        object's last reference), so it can't deadlock with the
+    ///        GIL.  Without a GIL, it is what keeps the map whole.
+    ///
+    struct watchers_t
+    {
+        struct watched_t
+        {
+            /// @brief Keeps the address (our key) from being reused.
+            worker::job::control_ptr_t control = {};
+            /// @brief Passed to the callbacks, and keeps the job from
+            ///        being aborted when Python lets go of it.
+            pybind11::object job = {};
+            std::vector<pybind11::object> on_progress = {};
+            std::vector<pybind11::object> on_done = {};
+        };
+
+        /// @brief Callbacks registered on each job, by control block.
+        std::unordered_map<const worker::job::control_t *, watched_t> jobs =
+            {};
+        std::mutex mutex = {};
+    };
+
+    watchers_t &watchers()
+    {
+        // Deliberately leaked.  It holds Python objects, which must
+        // not be released after the interpreter has shut down.
+        static auto result = new watchers_t();
+        return *result;
+    }
+
+    ///
+    /// \brief Call a callback, reporting (rather than raising) any
+    ///        exception, the way threading reports one from a thread.
+    ///
+    template <typename... Args>
+    void call_callback(const pybind11::object &callback, Args &&... args)
+    {
+        try
+        {
+            callback(std::forward<Args>(args)...);
+        }
+        catch (pybind11::error_already_set &error)
+        {
+            error.restore();
+            PyErr_WriteUnraisable(callback.ptr());
+        }
+        catch (const std::exception &error)
+        {
+            PyErr_SetString(PyExc_RuntimeError, error.what());
+            PyErr_WriteUnraisable(callback.ptr());
+        }
+    }
+
+    ///
+    /// \brief Delivers on_progress and on_done callbacks to Python.
+    ///
+    /// Worker threads push events onto a lock-free stack, and one
+    /// dispatcher thread takes the whole stack at a time, acquiring
+    /// the GIL once for each batch.  Progress is coalesced: a job has
+    /// at most one progress event queued (see control_t::
+    /// progress_posted), and its callbacks get the latest value when
+    /// the event is delivered.  Every completion is delivered.
+    /// Batches are at least 1 / rate apart, so a busy job's progress
+    /// callbacks run at most 'rate' times a second.
+    ///
+    /// The thread is stopped at exit (see bind_worker_dispatcher()),
+    /// before Python finalizes: acquiring the GIL of a finalizing
+    /// interpreter is not safe.
+    ///
+    class dispatcher
+    {
+    public:
+        dispatcher() { m_thread = std::thread([this] { run(); }); }
+
+        /**
+         * @brief Stop delivering callbacks, and wait for the thread
+         *        to exit.  The caller must not hold the GIL.
+         */
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_one();
+            if (m_thread.joinable())
+            {
+                m_thread.join();
+            }
+        }
+
+        /**
+         * @brief Queue an event.  Lock-free, except for waking the
+         *        dispatcher on the first event of a batch.
+         */
+        void post(worker::job::control_ptr_t control, bool done)
+        {
+            auto item = new event(std::move(control), done);
+            auto head = m_head.load(std::memory_order_relaxed);
+            do
+            {
+                item->next = head;
+            } while (!m_head.compare_exchange_weak(head, item,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed));
+            if (nullptr == head)
+            {
+                // Taking the mutex orders this with the dispatcher's
+                // check of m_head, so the wakeup can't be lost.
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                }
+                m_wake.notify_one();
+            }
+        }
+
+        void set_interval(std::chrono::nanoseconds interval)
+        {
+            m_interval_ns.store(interval.count(), std::memory_order_relaxed);
+        }
+
+        // Shared by address with its thread.
+        dispatcher(const dispatcher &) = delete;
+        dispatcher(dispatcher &&) = delete;
+        dispatcher &operator=(const dispatcher &) = delete;
+        dispatcher &operator=(dispatcher &&) = delete;
+
+    private:
+        struct delivery_t
+        {
+            worker::job::control_ptr_t control;
+            bool done;
+            std::int64_t value;
+        };
+
+        void run()
+        {
+            auto next_batch = std::chrono::steady_clock::now();
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [this] {
+                        return m_stop ||
+                               nullptr !=
+                                   m_head.load(std::memory_order_acquire);
+                    });
+                    // Let events gather (and progress coalesce) until
+                    // the next batch is due.
+                    m_wake.wait_until(lock, next_batch,
+                                      [this] { return m_stop; });
+                    if (m_stop)
+                    {
+                        return;
+                    }
+                }
+                deliver(take());
+                next_batch = std::chrono::steady_clock::now() +
+                             std::chrono::nanoseconds(m_interval_ns.load(
+                                 std::memory_order_relaxed));
+            }
+        }
+
+        /**
+         * @brief Take every queued event, oldest first, reading the
+         *        latest progress for each progress event.
+         */
+        std::vector<delivery_t> take()
+        {
+            auto item = m_head.exchange(nullptr, std::memory_order_acquire);
+            std::vector<delivery_t> result;
+            while (item)
+            {
+                delivery_t delivery = {std::move(item->control), item->done,
+                                       0};
+                if (!delivery.done)
+                {
+                    // Clear the flag first, so a later report posts a
+                    // new event.  The exchange also makes every value
+                    // stored before the flag was set visible here.
+                    delivery.control->progress_posted.exchange(
+                        false, std::memory_order_acq_rel);
+                    delivery.value = delivery.control->progress.load(
+                        std::memory_order_relaxed);
+                }
+                result.push_back(std::move(delivery));
+                auto next = item->next;
+                delete item;
+                item = next;
+            }
+            std::reverse(result.begin(), result.end());
+            return result;
+        }
+
+        void deliver(const std::vector<delivery_t> &deliveries)
+        {
+            if (!Py_IsInitialized())
+            {
+                // Exiting: there's nobody left to call back.
+                return;
+            }
+            pybind11::gil_scoped_acquire gil;
+            auto &state = watchers();
+            for (const auto &delivery : deliveries)
+            {
+                // Taken (when done) or copied (since a callback may
+                // register another) under the mutex, and called after.
+                // Done is posted before the job's future is ready, so
+                // this may drop the last reference to a Job whose
+                // destructor still waits: it does so without the GIL.
+                watchers_t::watched_t watched;
+                {
+                    std::lock_guard<std::mutex> lock(state.mutex);
+                    auto found = state.jobs.find(delivery.control.get());
+                    if (state.jobs.end() == found)
+                    {
+                        // Already finished, and its callbacks called.
+                        continue;
+                    }
+                    if (delivery.done)
+                    {
+                        watched = std::move(found->second);
+                        state.jobs.erase(found);
+                    }
+                    else
+                    {
+                        watched.job = found->second.job;
+                        watched.on_progress = found->second.on_progress;
+                    }
+                }
+                if (delivery.done)
+                {
+                    for (const auto &callback : watched.on_done)
+                    {
+                        call_callback(callback, watched.job);
+                    }
+                }
+                else
+                {
+                    for (const auto &callback : watched.on_progress)
+                    {
+                        call_callback(callback, watched.job, delivery.value);
+                    }
+                }
+            }
+        }
+
+        std::atomic<event *> m_head = {nullptr};
+        std::atomic<std::int64_t> m_interval_ns = {10000000};
+        std::mutex m_mutex = {};
+        std::condition_variable m_wake = {};
+        bool m_stop = false;
+        std::thread m_thread = {};
+    };
+
+    dispatcher &get_dispatcher()
+    {
+        // Deliberately leaked, like the executors.  Worker threads
+        // may still post to it while the process exits.
+        static auto result = new dispatcher();
+        return *result;
+    }
+}
+
+bool worker::report_progress(std::int64_t value)
+{
+    const auto control = this_thread_job;
+    if (nullptr == control)
+    {
+        return false;
+    }
+    auto &shared = **control;
+    shared.progress.store(value, std::memory_order_relaxed);
+    if (shared.watched.load(std::memory_order_relaxed) &&
+        !shared.progress_posted.exchange(true, std::memory_order_acq_rel))
+    {
+        get_dispatcher().post(*control, false);
+    }
+    return true;
+}
+
+const worker::job::control_ptr_t *worker::current_job()
+{
+    return this_thread_job;
+}
+
+worker::progress_scope::progress_scope(const job::control_ptr_t &control)
+    : m_previous(this_thread_job)
+{
+    this_thread_job = &control;
+}
+
+worker::progress_scope::~progress_scope() { this_thread_job = m_previous; }
+
+void worker::post_job_done(const job::control_ptr_t &control)
+{
+    get_dispatcher().post(control, true);
+}
+
+void worker::add_job_callback(pybind11::object job_object,
+                              pybind11::object callback, bool done)
+{
+    auto &job = job_object.cast<worker::job &>();
+    {
+        auto &state = watchers();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto &watched = state.jobs[job.control.get()];
+        if (!watched.control)
+        {
+            watched.control = job.control;
+            watched.job = job_object;
+        }
+        (done ? watched.on_done : watched.on_progress)
+            .push_back(std::move(callback));
+    }
+
+    // Start the dispatcher before any job can post to it.
+    get_dispatcher();
+    // run_job checks 'watched' after setting the final state, so
+    // either it posts the completion or we see the final state here.
+    job.control->watched = true;
+    switch (job.get_state())
+    {
+    case state::complete:
+    case state::incomplete:
+        post_job_done(job.control);
+        break;
+    case state::not_started:
+    case state::setup:
+    case state::working:
+    case state::teardown:
+        break;
+    }
+}
+
+void worker::set_callback_rate(double max_per_second)
+{
+    if (0 > max_per_second)
+    {
+        throw std::invalid_argument("max_per_second must not be negative");
+    }
+    get_dispatcher().set_interval(
+        0 == max_per_second
+            ? std::chrono::nanoseconds(0)
+            : std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::duration<double>(1 / max_per_second)));
+}
+
+pybind11::module &worker::bind_worker_dispatcher(pybind11::module &module)
+{
+    // Callbacks still queued at exit are never called.
+    pybind11::module::import("atexit").attr("register")(
+        pybind11::cpp_function([] {
+            pybind11::gil_scoped_release release;
+            get_dispatcher().stop();
+        }));
+
+    module.def("set_callback_rate", &set_callback_rate, R"pbdoc(
+Limit how often Job.on_progress() and Job.on_done() callbacks run.
+
+Callbacks run in batches on one dispatcher thread, which acquires the
+GIL once per batch.  Batches are at least 1 / max_per_second seconds
+apart, so each Job's progress callbacks run at most max_per_second
+times a second, with the latest progress.  Completions are never
+dropped, only held back until the next batch.
+
+Parameters
+----------
+max_per_second: Batches per second (fractions allowed), or 0 for no
+  limit.  The default is 100.
+)pbdoc",
+               pybind11::arg("max_per_second"));
+
+    module.def("report_progress", &report_progress, R"pbdoc(
+Report the progress of the Job running on this thread, for its
+on_progress() callbacks.  Call it from the hooks of a PythonJob.
+
+Parameters
+----------
+value: An integer, such as the number of items done so far.
+
+Returns
+----------
+True if called from a Job's thread, False (doing nothing) otherwise.
+)pbdoc",
+               pybind11::arg("value"));
+    return module;
+}
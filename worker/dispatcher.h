@@ -0,0 +1,99 @@
+#ifndef WORKER_DISPATCHER_H
+#define WORKER_DISPATCHER_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "job.h"
+
+#include <cstdint>
+
+namespace worker
+{
+    /**
+     * @brief Report the progress of the job running on this thread
+     *        (for example, the last number counted).
+     *
+     *        Cheap when nobody is watching the job: a thread-local
+     *        read and a relaxed store.  Does nothing on threads that
+     *        are not running a job's hooks.
+     *
+     * @return True if called from a job's thread.
+     */
+    bool report_progress(std::int64_t value);
+
+    /**
+     * @brief The job whose hooks are running on this thread, or null.
+     *        A runnable that hands work to other threads can give
+     *        them a progress_scope of their own with it.
+     */
+    const job::control_ptr_t *current_job();
+
+    ///
+    /// \brief Makes report_progress() refer to a job while its hooks
+    ///        run on this thread.
+    ///
+    class progress_scope
+    {
+    public:
+        explicit progress_scope(const job::control_ptr_t &control);
+        ~progress_scope();
+
+        progress_scope(const progress_scope &) = delete;
+        progress_scope(progress_scope &&) = delete;
+        progress_scope &operator=(const progress_scope &) = delete;
+        progress_scope &operator=(progress_scope &&) = delete;
+
+    private:
+        const job::control_ptr_t *const m_previous;
+    };
+
+    /**
+     * @brief Post a finished job's on_done callbacks.  Called from
+     *        the worker thread, after the final state is set, when
+     *        the job is watched.
+     */
+    void post_job_done(const job::control_ptr_t &control);
+
+    /**
+     * @brief Implement Job.on_progress() and Job.on_done().  Needs
+     *        the GIL.
+     * @param job The Job object.  Kept alive until it finishes.
+     * @param callback Called with the Job (and, for progress, the
+     *        latest value) on the dispatcher thread.
+     * @param done True for on_done, false for on_progress.
+     */
+    void add_job_callback(pybind11::object job, pybind11::object callback,
+                          bool done);
+
+    /**
+     * @brief Limit how often the dispatcher delivers a batch.
+     * @param max_per_second Batches per second, or 0 for no limit.
+     */
+    void set_callback_rate(double max_per_second);
+
+    pybind11::module &bind_worker_dispatcher(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_DISPATCHER_H
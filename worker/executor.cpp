@@ -0,0 +1,315 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "executor.h"
+#include "metrics.h"
+#include "pool_executor.h"
+#include "stealing_executor.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    ///
+    /// \brief One new (detached) thread for every task.
+    ///
+    /// This was the original behavior of launch().  The job keeps
+    /// the future of the task, so nothing needs to join the thread.
+    ///
+    class thread_executor final : public worker::executor
+    {
+    public:
+        thread_executor() = default;
+
+        virtual bool submit(task_t task,
+                            const worker::task_schedule &schedule) override
+        {
+            // A thread of its own can go straight to the node asked for.
+            auto where = worker::get_node_placement(schedule.node);
+            std::thread([task = std::move(task),
+                         where = std::move(where)]() mutable {
+                worker::count_thread_at_scope counted;
+                if (-1 != where.node)
+                {
+                    worker::place_this_thread(where);
+                }
+                task();
+            }).detach();
+            return true;
+        }
+
+        virtual std::size_t worker_count() const override { return 0; }
+
+        virtual void set_worker_count(std::size_t) override {}
+    };
+
+    std::size_t default_worker_count()
+    {
+        auto result = static_cast<std::size_t>(
+            std::thread::hardware_concurrency());
+        return 0 == result ? 1 : result;
+    }
+
+    struct registry_t
+    {
+        std::mutex mutex = {};
+        /// @brief Serializes resizing and placing the workers, which
+        ///        wait for them without holding 'mutex'.
+        std::mutex resize_mutex = {};
+        worker::executor_kind kind = worker::executor_kind::pool;
+        std::size_t worker_count = default_worker_count();
+        std::unique_ptr<worker::executor> thread = {};
+        std::unique_ptr<worker::executor> pool = {};
+        std::unique_ptr<worker::executor> stealing = {};
+
+        /// @brief The executor for 'kind', read without the mutex.
+        std::atomic<worker::executor *> current = {nullptr};
+
+        worker::executor &create(worker::executor_kind which)
+        {
+            // Caller holds the mutex.
+            switch (which)
+            {
+            case worker::executor_kind::thread:
+                if (!thread)
+                {
+                    thread = std::make_unique<thread_executor>();
+                }
+                return *thread;
+            case worker::executor_kind::stealing:
+                if (!stealing)
+                {
+                    stealing = std::make_unique<worker::stealing_executor>(
+                        worker_count);
+                }
+                return *stealing;
+            case worker::executor_kind::pool:
+                break;
+            }
+            if (!pool)
+            {
+                pool = std::make_unique<worker::pool_executor>(worker_count);
+            }
+            return *pool;
+        }
+    };
+
+    registry_t &registry()
+    {
+        // Deliberately leaked.  Worker threads may still be running
+        // (or blocked waiting for work) when the process exits, and
+        // joining them from a static destructor could hang the exit.
+        static auto result = new registry_t();
+        return *result;
+    }
+}
+
+void worker::executor::submit_many(std::vector<task_t> &tasks,
+                                   const task_schedule &schedule)
+{
+    for (auto &task : tasks)
+    {
+        submit(std::move(task), schedule);
+    }
+}
+
+worker::executor &worker::get_executor()
+{
+    auto &reg = registry();
+    auto result = reg.current.load();
+    if (nullptr == result)
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        result = &reg.create(reg.kind);
+        reg.current = result;
+    }
+    return *result;
+}
+
+worker::executor_kind worker::get_executor_kind()
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.kind;
+}
+
+void worker::set_executor_kind(executor_kind kind)
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.kind = kind;
+    reg.current = &reg.create(kind);
+}
+
+std::size_t worker::get_worker_count()
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.worker_count;
+}
+
+void worker::set_worker_count(std::size_t count)
+{
+    if (0 == count || stealing_executor::MAX_WORKERS < count)
+    {
+        throw std::invalid_argument(
+            "worker count must be between 1 and " +
+            std::to_string(stealing_executor::MAX_WORKERS));
+    }
+
+    // Retired workers may need the GIL to finish their current Job,
+    // and other threads holding the GIL may want the registry, so
+    // wait for them after letting go of it.  The executors, once
+    // created, live as long as the registry.
+    auto &reg = registry();
+    std::lock_guard<std::mutex> resize_lock(reg.resize_mutex);
+    worker::executor *pool = nullptr;
+    worker::executor *stealing = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.worker_count = count;
+        pool = reg.pool.get();
+        stealing = reg.stealing.get();
+    }
+    if (nullptr != pool)
+    {
+        pool->set_worker_count(count);
+    }
+    if (nullptr != stealing)
+    {
+        stealing->set_worker_count(count);
+    }
+}
+
+void worker::set_worker_affinity(affinity kind, const std::vector<int> &cpus)
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> resize_lock(reg.resize_mutex);
+    worker::executor *pool = nullptr;
+    worker::executor *stealing = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        set_affinity(kind, cpus);
+        pool = reg.pool.get();
+        stealing = reg.stealing.get();
+    }
+    if (nullptr != pool)
+    {
+        pool->place_workers();
+    }
+    if (nullptr != stealing)
+    {
+        stealing->place_workers();
+    }
+}
+
+pybind11::module &worker::bind_worker_executor(pybind11::module &module)
+{
+    pybind11::enum_<executor_kind>(module, "Executor", R"pbdoc(
+Executor used by launch() to run Job objects.
+)pbdoc")
+        .value("THREAD", executor_kind::thread,
+               "Start a new thread for every Job (no upper limit)")
+        .value("POOL", executor_kind::pool,
+               "Run Jobs on a fixed number of long-lived threads")
+        .value("STEALING", executor_kind::stealing,
+               "Like POOL, but each thread has its own work-stealing queue");
+
+    pybind11::enum_<priority>(module, "Priority", R"pbdoc(
+How urgently a Job should run, once Executor.POOL has a free thread.
+)pbdoc")
+        .value("LOW", priority::low,
+               "Background work, run when nothing more urgent waits")
+        .value("NORMAL", priority::normal, "The default")
+        .value("HIGH", priority::high, "Latency-critical work, run first");
+
+    module.def("get_executor", &worker::get_executor_kind,
+               "Return the Executor used by launch()",
+               pybind11::call_guard<pybind11::gil_scoped_release>());
+
+    module.def("set_executor", &worker::set_executor_kind, R"pbdoc(
+Select the Executor used by subsequent launch() calls.
+
+Jobs already launched keep running on the Executor they were
+launched on.
+)pbdoc",
+               pybind11::arg("executor"),
+               pybind11::call_guard<pybind11::gil_scoped_release>());
+
+    module.def("get_worker_count", &worker::get_worker_count,
+               "Return the number of threads used by POOL and STEALING",
+               pybind11::call_guard<pybind11::gil_scoped_release>());
+
+    module.def("set_worker_count", &worker::set_worker_count, R"pbdoc(
+Set the number of threads used by Executor.POOL and Executor.STEALING.
+
+The default is the number of CPU cores.  When the count is reduced,
+this call waits for retired threads to finish their current Job.
+)pbdoc",
+               pybind11::arg("count"),
+               pybind11::call_guard<pybind11::gil_scoped_release>());
+
+    module.def("get_affinity", &worker::get_affinity,
+               "Return the Affinity of the POOL and STEALING threads");
+
+    module.def(
+        "set_affinity",
+        [](affinity kind, pybind11::object cpus) {
+            std::vector<int> chosen;
+            if (!cpus.is_none())
+            {
+                for (auto cpu : cpus)
+                {
+                    chosen.push_back(cpu.cast<int>());
+                }
+            }
+            pybind11::gil_scoped_release release;
+            set_worker_affinity(kind, chosen);
+        },
+        R"pbdoc(
+Choose where Executor.POOL and Executor.STEALING put their threads,
+and move the threads already running.
+
+CPU and CORE pin the threads one by one, spreading them over the NUMA
+nodes and using every core once before the second hardware thread of
+any.  NODE gives each NUMA node its share of the threads, free to move
+between that node's CPUs.  With POOL, a Job whose input asks for a
+.numa_node runs on a thread placed on that node (if there is one).
+
+On a machine with one NUMA node, NODE is the same as NONE.  Where the
+OS can't pin threads, nothing is pinned.
+
+Parameters
+----------
+affinity : The Affinity.
+cpus : The CPUs to use, in order (default: every CPU this process may
+    use).  With NONE, the threads may use any of them.
+)pbdoc",
+        pybind11::arg("affinity"), pybind11::arg("cpus") = pybind11::none());
+
+    return module;
+}
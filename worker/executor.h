@@ -0,0 +1,195 @@
+#ifndef WORKER_EXECUTOR_H
+#define WORKER_EXECUTOR_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "topology.h"
+
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief The available executor implementations.
+    ///
+    enum class executor_kind
+    {
+        thread,  ///< One new thread for each task (no upper limit)
+        pool,    ///< Fixed number of long-lived threads, shared queue
+        stealing ///< Fixed number of threads, per-thread deques
+    };
+
+    ///
+    /// \brief How urgently a job should run.
+    ///
+    enum class priority
+    {
+        low,    ///< Background work, run when nothing more urgent waits
+        normal, ///< The default
+        high    ///< Latency-critical work, run first
+    };
+
+    enum
+    {
+        PRIORITY_COUNT = 3
+    };
+
+    ///
+    /// \brief When a task should run, compared to other queued tasks.
+    ///
+    /// Within a priority, tasks with a deadline run earliest deadline
+    /// first, then tasks without one in the order they were submitted.
+    ///
+    struct task_schedule
+    {
+        priority level = priority::normal;
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::time_point::max();
+        /// @brief The NUMA node to run on, or -1 for any.
+        int node = -1;
+    };
+
+    ///
+    /// \brief Base class for objects that run tasks on worker threads.
+    ///
+    /// launch() wraps each job in a task and submits it to the
+    /// current executor.  The executor owns the threads, and the
+    /// job tracks completion through the future of the task.
+    ///
+    class executor
+    {
+    protected:
+        executor() = default;
+
+    public:
+        typedef std::packaged_task<void()> task_t;
+
+        /**
+         * @brief Queue a task for execution on a worker thread.
+         * @param task The task to run.  Its future must already
+         *        have been retrieved by the caller.
+         * @param schedule Its priority and deadline.  Only the pool
+         *        executor orders queued tasks by these.  The others
+         *        ignore them.
+         * @return True if an idle worker was available to pick up
+         *        the task right away, false if the task was queued
+         *        behind other work.
+         */
+        virtual bool submit(task_t task, const task_schedule &schedule) = 0;
+
+        /**
+         * @brief Queue many tasks at once.
+         *
+         *        The default submits them one at a time.  Executors
+         *        override this to take their locks only once.
+         *
+         * @param tasks The tasks to run.  They are moved from.
+         * @param schedule The priority and deadline of every task.
+         */
+        virtual void submit_many(std::vector<task_t> &tasks,
+                                 const task_schedule &schedule);
+
+        /**
+         * @brief Return the number of worker threads.
+         * @return The number of threads, or 0 if there is no
+         *        fixed number of threads.
+         */
+        virtual std::size_t worker_count() const = 0;
+
+        /**
+         * @brief Change the number of worker threads.
+         *
+         *        When shrinking, retired workers finish their
+         *        current task before exiting, and this call waits
+         *        for them to do so.
+         *
+         * @param count The new number of threads (must be > 0).
+         */
+        virtual void set_worker_count(std::size_t count) = 0;
+
+        /**
+         * @brief Move the worker threads to match the current
+         *        affinity (see set_worker_affinity()).
+         *
+         *        The default does nothing.
+         */
+        virtual void place_workers() {}
+
+        // Executors own threads that point back at them, so they
+        // can be neither copied nor moved.
+        executor(const executor &) = delete;
+        executor(executor &&) = delete;
+        executor &operator=(const executor &) = delete;
+        executor &operator=(executor &&) = delete;
+        virtual ~executor() = default;
+    };
+
+    /**
+     * @brief Return the executor used by launch().
+     */
+    executor &get_executor();
+
+    /**
+     * @brief Return which executor is used by launch().
+     */
+    executor_kind get_executor_kind();
+
+    /**
+     * @brief Select the executor used by subsequent launch() calls.
+     *
+     *        Jobs already submitted keep running on the executor
+     *        they were submitted to.
+     */
+    void set_executor_kind(executor_kind kind);
+
+    /**
+     * @brief Return the number of threads used by pooled executors.
+     *
+     *        This is shared by executor_kind::pool and
+     *        executor_kind::stealing.
+     */
+    std::size_t get_worker_count();
+
+    /**
+     * @brief Set the number of threads used by pooled executors.
+     * @param count The new number of threads (must be > 0).
+     */
+    void set_worker_count(std::size_t count);
+
+    /**
+     * @brief Set where pooled executors put their threads, and move
+     *        the threads already running.
+     * @param kind How to place them.
+     * @param cpus If not empty, the only CPUs to use.
+     */
+    void set_worker_affinity(affinity kind, const std::vector<int> &cpus);
+
+    pybind11::module &bind_worker_executor(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_EXECUTOR_H
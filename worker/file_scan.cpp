@@ -0,0 +1,535 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "file_scan.h"
+#include "parallel_range.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+    /// @brief Bytes scanned between checks for an abort.
+    const std::size_t BLOCK_SIZE = 1 << 20;
+
+    std::size_t page_size()
+    {
+        static const auto result =
+            static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        return result;
+    }
+
+    class line_scanner : public worker::chunk_scanner
+    {
+    public:
+        virtual std::uint64_t
+        on_chunk(const unsigned char *data, std::size_t size,
+                 const worker::cancellation_token &cancellation) override
+        {
+            std::uint64_t result = 0;
+            for (std::size_t i = 0;
+                 i < size && !cancellation.stop_requested(); i += BLOCK_SIZE)
+            {
+                const auto end = data + std::min(size, i + BLOCK_SIZE);
+                result += static_cast<std::uint64_t>(
+                    std::count(data + i, end, '\n'));
+            }
+            return result;
+        }
+    };
+
+    class byte_scanner : public worker::chunk_scanner
+    {
+    public:
+        explicit byte_scanner(worker::file_scan_output &output)
+            : worker::chunk_scanner(), m_output(output)
+        {
+            m_output.has_byte_counts = true;
+        }
+
+        virtual std::uint64_t
+        on_chunk(const unsigned char *data, std::size_t size,
+                 const worker::cancellation_token &cancellation) override
+        {
+            // Four tables, so that runs of one byte value don't wait
+            // on the same counter.
+            std::array<std::array<std::uint64_t, 256>, 4> counts = {};
+            std::size_t i = 0;
+            while (i < size && !cancellation.stop_requested())
+            {
+                const auto end = std::min(size, i + BLOCK_SIZE);
+                for (; i + 4 <= end; i += 4)
+                {
+                    ++counts[0][data[i]];
+                    ++counts[1][data[i + 1]];
+                    ++counts[2][data[i + 2]];
+                    ++counts[3][data[i + 3]];
+                }
+                for (; i < end; ++i)
+                {
+                    ++counts[0][data[i]];
+                }
+            }
+            for (std::size_t value = 0; value < 256; ++value)
+            {
+                const auto count = counts[0][value] + counts[1][value] +
+                                   counts[2][value] + counts[3][value];
+                if (0 < count)
+                {
+                    m_output.byte_counts[value].fetch_add(
+                        count, std::memory_order_relaxed);
+                }
+            }
+            return i;
+        }
+
+        byte_scanner(const byte_scanner &) = delete;
+        byte_scanner(byte_scanner &&) = delete;
+        byte_scanner &operator=(const byte_scanner &) = delete;
+        byte_scanner &operator=(byte_scanner &&) = delete;
+
+    private:
+        worker::file_scan_output &m_output;
+    };
+
+    ///
+    /// \brief Claims runs of chunks for the threads of a file scan.
+    ///
+    class scan_body : public worker::range_body<std::uint64_t>
+    {
+    public:
+        scan_body(const worker::mapped_file &file,
+                  worker::chunk_scanner &scanner,
+                  worker::file_scan_output &output)
+            : worker::range_body<std::uint64_t>(), m_file(file),
+              m_scanner(scanner), m_output(output)
+        {
+        }
+
+        virtual std::uint64_t identity() const override { return 0; }
+
+        virtual std::uint64_t
+        on_chunk(std::int64_t begin, std::int64_t end,
+                 const worker::cancellation_token &cancellation) override
+        {
+            const auto first = static_cast<std::size_t>(begin);
+            const auto last = static_cast<std::size_t>(end);
+            const auto offset = first * m_output.chunk_size;
+            m_file.will_need(offset, std::min(m_file.size() - offset,
+                                              (last - first) *
+                                                  m_output.chunk_size));
+            std::uint64_t result = 0;
+            for (auto i = first; i < last; ++i)
+            {
+                if (cancellation.stop_requested())
+                {
+                    break;
+                }
+                const auto chunk_offset = i * m_output.chunk_size;
+                const auto size = std::min(m_output.chunk_size,
+                                           m_file.size() - chunk_offset);
+                const auto value = m_scanner.on_chunk(
+                    m_file.data() + chunk_offset, size, cancellation);
+                if (cancellation.stop_requested())
+                {
+                    break;
+                }
+                m_output.bytes_scanned.fetch_add(size,
+                                                 std::memory_order_relaxed);
+                m_output.set_chunk(i, value, cancellation);
+                ++result;
+            }
+            return result;
+        }
+
+        virtual std::uint64_t reduce(const std::uint64_t &left,
+                                     const std::uint64_t &right) const override
+        {
+            return left + right;
+        }
+
+        virtual bool on_result(const std::uint64_t &) override { return true; }
+
+        scan_body(const scan_body &) = delete;
+        scan_body(scan_body &&) = delete;
+        scan_body &operator=(const scan_body &) = delete;
+        scan_body &operator=(scan_body &&) = delete;
+
+    private:
+        const worker::mapped_file &m_file;
+        worker::chunk_scanner &m_scanner;
+        worker::file_scan_output &m_output;
+    };
+
+    class file_scan_runnable : public worker::runnable
+    {
+    public:
+        file_scan_runnable(std::unique_ptr<worker::mapped_file> file,
+                           std::unique_ptr<worker::chunk_scanner> scanner,
+                           std::shared_ptr<worker::file_scan_output> output)
+            : worker::runnable(), m_file(std::move(file)),
+              m_scanner(std::move(scanner)), m_output(std::move(output))
+        {
+        }
+
+        virtual bool
+        on_working(const worker::cancellation_token &cancellation) override
+        {
+            // Progress counts chunks.
+            worker::parallel_range_runnable<std::uint64_t> range(
+                0, static_cast<std::int64_t>(m_output->chunk_count),
+                std::make_unique<scan_body>(*m_file, *m_scanner, *m_output),
+                1);
+            return range.on_working(cancellation);
+        }
+
+        file_scan_runnable(const file_scan_runnable &) = delete;
+        file_scan_runnable(file_scan_runnable &&) = delete;
+        file_scan_runnable &operator=(const file_scan_runnable &) = delete;
+        file_scan_runnable &operator=(file_scan_runnable &&) = delete;
+
+    private:
+        const std::unique_ptr<worker::mapped_file> m_file;
+        const std::unique_ptr<worker::chunk_scanner> m_scanner;
+        const std::shared_ptr<worker::file_scan_output> m_output;
+    };
+}
+
+worker::mapped_file::mapped_file(const std::string &path)
+{
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat status;
+    auto error = 0;
+    if (0 != ::fstat(fd, &status))
+    {
+        error = errno;
+    }
+    else if (S_ISDIR(status.st_mode))
+    {
+        error = EISDIR;
+    }
+    else if (!S_ISREG(status.st_mode))
+    {
+        error = ENODEV;
+    }
+    else if (0 < status.st_size)
+    {
+        m_size = static_cast<std::size_t>(status.st_size);
+        const auto data =
+            ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data)
+        {
+            error = errno;
+            m_size = 0;
+        }
+        else
+        {
+            m_data = static_cast<const unsigned char *>(data);
+        }
+    }
+    // The mapping keeps the file open.
+    ::close(fd);
+    if (0 != error)
+    {
+        throw std::system_error(error, std::generic_category(), path);
+    }
+    if (m_data)
+    {
+        // Only hints: failing (say, for huge pages on a file system
+        // without them) changes nothing.
+        auto *const data = const_cast<unsigned char *>(m_data);
+        ::madvise(data, m_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        ::madvise(data, m_size, MADV_HUGEPAGE);
+#endif
+    }
+}
+
+worker::mapped_file::~mapped_file()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<unsigned char *>(m_data), m_size);
+    }
+}
+
+void worker::mapped_file::will_need(std::size_t offset, std::size_t size) const
+{
+    // madvise() needs a page-aligned start.
+    const auto start = offset - offset % page_size();
+    if (m_data && start < m_size)
+    {
+        ::madvise(const_cast<unsigned char *>(m_data) + start,
+                  std::min(m_size - start, size + (offset - start)),
+                  MADV_WILLNEED);
+    }
+}
+
+const std::uint64_t worker::file_scan_output::NOT_SCANNED;
+
+worker::file_scan_output::file_scan_output(std::size_t size_,
+                                           std::size_t chunk_size_,
+                                           std::size_t stream_capacity,
+                                           overflow_policy overflow)
+    : stream_output<int>(stream_capacity, overflow), size(size_),
+      chunk_size(chunk_size_),
+      chunk_count((size_ + chunk_size_ - 1) / chunk_size_), byte_counts(),
+      m_values(new std::atomic<std::uint64_t>[chunk_count])
+{
+    for (auto &count : byte_counts)
+    {
+        count = 0;
+    }
+    for (std::size_t i = 0; i < chunk_count; ++i)
+    {
+        m_values[i] = NOT_SCANNED;
+    }
+}
+
+void worker::file_scan_output::set_chunk(
+    std::size_t index, std::uint64_t value,
+    const cancellation_token &cancellation)
+{
+    m_values[index].store(value, std::memory_order_release);
+    total.fetch_add(value, std::memory_order_relaxed);
+    chunks_done.fetch_add(1, std::memory_order_relaxed);
+    // Several threads stream indexes: the ring takes one producer at
+    // a time.
+    std::lock_guard<std::mutex> lock(m_push_mutex);
+    push(static_cast<int>(index),
+         [&cancellation] { return !cancellation.stop_requested(); });
+}
+
+std::uint64_t worker::file_scan_output::get_chunk(std::size_t index) const
+{
+    return m_values[index].load(std::memory_order_acquire);
+}
+
+std::unique_ptr<worker::chunk_scanner>
+worker::file_scan_input::make_scanner(file_scan_output &output) const
+{
+    switch (get_field(*this, &file_scan_input::mode))
+    {
+    case scan_mode::lines:
+        return std::make_unique<line_scanner>();
+    case scan_mode::bytes:
+        return std::make_unique<byte_scanner>(output);
+    }
+    throw std::invalid_argument("unknown ScanMode");
+}
+
+worker::job_data worker::file_scan_input::get_job_data() const
+{
+    // The job runs from this snapshot, even if Python sets a field
+    // (from another thread) while it is made.
+    const auto fields = copy_fields(*this);
+    if (fields.stream_capacity < 1)
+    {
+        throw std::invalid_argument("stream_capacity must be at least 1");
+    }
+    if (fields.chunk_size < 1)
+    {
+        throw std::invalid_argument("chunk_size must be at least 1");
+    }
+    const auto page = page_size();
+    if (SIZE_MAX - page < fields.chunk_size)
+    {
+        // Rounding it up to pages would overflow.
+        throw std::invalid_argument("chunk_size is too large");
+    }
+    const auto rounded = (fields.chunk_size + page - 1) / page * page;
+
+    std::unique_ptr<mapped_file> file;
+    try
+    {
+        file = std::make_unique<mapped_file>(fields.path);
+    }
+    catch (const std::system_error &error)
+    {
+        errno = error.code().value();
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError,
+                                       fields.path.c_str());
+        throw pybind11::error_already_set();
+    }
+    if (INT_MAX < file->size() / rounded)
+    {
+        throw std::invalid_argument("chunk_size is too small for the file");
+    }
+
+    auto output = std::make_shared<file_scan_output>(
+        file->size(), rounded,
+        static_cast<std::size_t>(fields.stream_capacity), fields.overflow);
+    auto scanner = make_scanner(*output);
+
+    worker::job_data result = {};
+    result.python_input = pybind11::cast(fields);
+    result.python_output = pybind11::cast(output);
+    result.runnable_object = std::make_unique<file_scan_runnable>(
+        std::move(file), std::move(scanner), std::move(output));
+    return result;
+}
+
+std::string worker::file_scan_input::get_repr() const
+{
+    return std::string("FileScan") + get_str();
+}
+
+std::string worker::file_scan_input::get_str() const
+{
+    const auto fields = copy_fields(*this);
+    std::stringstream sstr;
+    sstr << "(path='" << fields.path << "', mode=ScanMode."
+         << (scan_mode::lines == fields.mode ? "LINES" : "BYTES")
+         << ", chunk_size=" << fields.chunk_size << ")";
+    return sstr.str();
+}
+
+pybind11::module &worker::bind_worker_file_scan(pybind11::module &module)
+{
+    pybind11::enum_<scan_mode>(module, "ScanMode", R"pbdoc(
+What a FileScan Job looks for in each chunk.
+)pbdoc")
+        .value("LINES", scan_mode::lines,
+               "Count newlines: a chunk's value is its newline count")
+        .value("BYTES", scan_mode::bytes,
+               "Count each byte value: a chunk's value is its size");
+
+    pybind11::class_<file_scan_output, stream_output<int>,
+                     std::shared_ptr<file_scan_output>>
+        output(module, "FileScanOutput", R"pbdoc(
+What a FileScan Job found, chunk by chunk.
+
+The index of each chunk is streamed as it is scanned (in no particular
+order); collect them with .drain() and look them up with .chunk().
+.total, .chunks_done and .bytes_scanned count up as the Job runs.
+)pbdoc");
+    output.def_readonly("size", &file_scan_output::size,
+                        "The size of the file in bytes");
+    output.def_readonly("chunk_size", &file_scan_output::chunk_size,
+                        "The size of each chunk (a whole number of pages)");
+    output.def_readonly("chunk_count", &file_scan_output::chunk_count,
+                        "The number of chunks");
+    output.def_property_readonly(
+        "total",
+        [](const file_scan_output &self) {
+            return static_cast<std::uint64_t>(self.total);
+        },
+        "The sum of the values of the chunks scanned so far");
+    output.def_property_readonly(
+        "chunks_done",
+        [](const file_scan_output &self) {
+            return static_cast<std::uint64_t>(self.chunks_done);
+        },
+        "The number of chunks scanned so far");
+    output.def_property_readonly(
+        "bytes_scanned",
+        [](const file_scan_output &self) {
+            return static_cast<std::uint64_t>(self.bytes_scanned);
+        },
+        "The number of bytes in the chunks scanned so far");
+    output.def_property_readonly(
+        "histogram",
+        [](const file_scan_output &self) -> pybind11::object {
+            if (!self.has_byte_counts)
+            {
+                return pybind11::none();
+            }
+            pybind11::list result;
+            for (const auto &count : self.byte_counts)
+            {
+                result.append(pybind11::int_(
+                    static_cast<std::uint64_t>(count)));
+            }
+            return result;
+        },
+        "With ScanMode.BYTES, the count of each byte value so far");
+    output.def(
+        "chunk",
+        [](const file_scan_output &self,
+           std::size_t index) -> pybind11::object {
+            if (self.chunk_count <= index)
+            {
+                throw pybind11::index_error("chunk index out of range");
+            }
+            const auto offset = index * self.chunk_size;
+            const auto value = self.get_chunk(index);
+            return pybind11::make_tuple(
+                offset, std::min(self.chunk_size, self.size - offset),
+                file_scan_output::NOT_SCANNED == value
+                    ? pybind11::object(pybind11::none())
+                    : pybind11::int_(value));
+        },
+        R"pbdoc(
+Return (offset, length, value) for a chunk.  The value is None until
+the chunk has been scanned.
+)pbdoc",
+        pybind11::arg("index"));
+
+    pybind11::class_<file_scan_input, input> obj(module, "FileScan", R"pbdoc(
+Job that scans a file through a memory map, without reading it into
+Python or holding the GIL.
+
+The file is split into chunks of .chunk_size bytes (rounded up to whole
+pages), which the Executor's threads scan in parallel, the Job's own
+included.  .mode picks what each chunk is scanned for: see ScanMode.
+Progress (see Job.on_progress()) counts chunks.  Aborting the Job
+stops every thread within about a megabyte.
+
+The file is mapped, and any error opening it raised as OSError, at
+launch().  The kernel is told the file will be read sequentially (and
+to use huge pages where it can).  Don't truncate the file while it is
+being scanned: reading past its new end kills the process with SIGBUS.
+)pbdoc");
+    obj.def(pybind11::init([](pybind11::object path, scan_mode mode,
+                              std::size_t chunk_size) {
+                auto fspath = pybind11::module::import("os").attr("fspath");
+                return new file_scan_input(fspath(path).cast<std::string>(),
+                                           mode, chunk_size);
+            }),
+            pybind11::arg("path"), pybind11::arg("mode") = scan_mode::lines,
+            pybind11::arg("chunk_size") = 4 << 20);
+    def_field(obj, "path", &file_scan_input::path, "The file to scan");
+    def_field(obj, "mode", &file_scan_input::mode,
+              "The ScanMode: what to count in each chunk");
+    def_field(obj, "chunk_size", &file_scan_input::chunk_size,
+              "The bytes in each chunk, before rounding up to pages");
+    def_field(obj, "stream_capacity", &file_scan_input::stream_capacity,
+              "The most chunk indexes held for output.drain()");
+    def_field(obj, "overflow", &file_scan_input::overflow,
+              "The OverflowPolicy used when output.drain() falls behind");
+    return module;
+}
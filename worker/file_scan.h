@@ -0,0 +1,183 @@
+#ifndef WORKER_FILE_SCAN_H
+#define WORKER_FILE_SCAN_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "cancellation.h"
+#include "input.h"
+#include "stream_output.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace worker
+{
+    ///
+    /// \brief A read-only memory map of a whole regular file.
+    ///
+    /// The file may be closed or renamed once mapped, but it must not
+    /// be truncated: reading past its new end raises SIGBUS.
+    ///
+    class mapped_file
+    {
+    public:
+        /**
+         * @brief Map 'path', advising the kernel that it will be read
+         *        sequentially (and with huge pages where supported).
+         * @throws std::system_error if the file can't be opened or
+         *         mapped, or isn't a regular file.
+         */
+        explicit mapped_file(const std::string &path);
+        ~mapped_file();
+
+        const unsigned char *data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+
+        /// @brief Ask the kernel to start reading [offset, offset+size).
+        void will_need(std::size_t offset, std::size_t size) const;
+
+        mapped_file(const mapped_file &) = delete;
+        mapped_file(mapped_file &&) = delete;
+        mapped_file &operator=(const mapped_file &) = delete;
+        mapped_file &operator=(mapped_file &&) = delete;
+
+    private:
+        const unsigned char *m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+
+    ///
+    /// \brief What a file scan found, chunk by chunk.
+    ///
+    /// The index of each chunk is streamed as it is scanned, in no
+    /// particular order; chunk() gives its value.
+    ///
+    class file_scan_output : public stream_output<int>
+    {
+    public:
+        /// @brief The value of a chunk not scanned (yet).
+        static const std::uint64_t NOT_SCANNED = ~std::uint64_t{0};
+
+        file_scan_output(std::size_t size_, std::size_t chunk_size_,
+                         std::size_t stream_capacity,
+                         overflow_policy overflow);
+
+        const std::size_t size;
+        const std::size_t chunk_size;
+        const std::size_t chunk_count;
+
+        /// @brief Sum of the chunk values so far.
+        std::atomic<std::uint64_t> total = {0};
+        std::atomic<std::uint64_t> chunks_done = {0};
+        std::atomic<std::uint64_t> bytes_scanned = {0};
+        /// @brief Filled in by scanners that count bytes.
+        std::array<std::atomic<std::uint64_t>, 256> byte_counts;
+        bool has_byte_counts = false;
+
+        /// @brief Record the value of a chunk and stream its index.
+        void set_chunk(std::size_t index, std::uint64_t value,
+                       const cancellation_token &cancellation);
+        /// @brief The value of a chunk, or NOT_SCANNED.
+        std::uint64_t get_chunk(std::size_t index) const;
+
+    private:
+        std::unique_ptr<std::atomic<std::uint64_t>[]> m_values;
+        std::mutex m_push_mutex = {};
+    };
+
+    ///
+    /// \brief Scans the chunks of a mapped file.
+    ///
+    /// on_chunk() is called from several threads at once, on
+    /// different chunks, so anything it keeps across chunks must be
+    /// thread safe.  Derive from this (and from file_scan_input) to
+    /// scan files for something new.
+    ///
+    class chunk_scanner
+    {
+    public:
+        virtual ~chunk_scanner() = default;
+
+        /**
+         * @brief Scan one chunk.
+         * @param data The chunk's bytes.  Only valid during the call.
+         * @param size The number of bytes (a multiple of the page
+         *        size, except for the last chunk).
+         * @param cancellation Set if the job is aborted.  Long scans
+         *        should check it.
+         * @return The chunk's value, added to output.total.
+         */
+        virtual std::uint64_t
+        on_chunk(const unsigned char *data, std::size_t size,
+                 const cancellation_token &cancellation) = 0;
+    };
+
+    /// @brief The built-in scanners.
+    enum class scan_mode
+    {
+        lines, ///< Count newlines (like wc -l)
+        bytes  ///< Count each byte value
+    };
+
+    ///
+    /// \brief Input for a job that scans a file through a memory map,
+    ///        splitting it into page-aligned chunks across the
+    ///        executor's threads.
+    ///
+    struct file_scan_input : public input
+    {
+        file_scan_input(std::string path_, scan_mode mode_,
+                        std::size_t chunk_size_)
+            : path(std::move(path_)), mode(mode_), chunk_size(chunk_size_)
+        {
+        }
+
+        std::string path;
+        scan_mode mode;
+        /// @brief Rounded up to a whole number of pages.
+        std::size_t chunk_size;
+        int stream_capacity = 1024;
+        overflow_policy overflow = overflow_policy::drop_oldest;
+
+        /// @brief Return the scanner for a job.  Called with the GIL
+        ///        held; the default gives the scanner for .mode.
+        virtual std::unique_ptr<chunk_scanner>
+        make_scanner(file_scan_output &output) const;
+
+        /// @brief Needs the GIL.
+        virtual job_data get_job_data() const override;
+        virtual std::string get_repr() const override;
+        virtual std::string get_str() const override;
+    };
+
+    pybind11::module &bind_worker_file_scan(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_FILE_SCAN_H
@@ -1,11 +1,42 @@
 #include "init_worker.h"
+#include "admission.h"
+#include "dispatcher.h"
+#include "executor.h"
+#include "file_scan.h"
+#include "latency_histogram.h"
 #include "launch.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "pool_allocator.h"
+#include "python_job.h"
+#include "reduce.h"
 #include "job.h"
+#include "job_group.h"
+#include "stream_output.h"
+#include "topology.h"
+#include "trace.h"
+#include "wait.h"
 
 void worker::init_worker(pybind11::module &module)
 {
+    worker::bind_worker_admission(module);
+    worker::bind_worker_dispatcher(module);
+    worker::bind_worker_executor(module);
     worker::bind_worker_input(module);
     worker::bind_worker_job(module);
+    worker::bind_worker_job_group(module);
+    worker::bind_worker_latency_histogram(module);
     worker::bind_worker_launch(module);
+    worker::bind_worker_metrics(module);
+    worker::bind_worker_pipeline(module);
+    worker::bind_worker_pool_allocator(module);
+    worker::bind_worker_python_job(module);
+    worker::bind_worker_reduce(module);
     worker::bind_worker_state(module);
+    worker::bind_worker_stream_output(module);
+    // After stream_output, for _IntStreamOutput and OverflowPolicy.
+    worker::bind_worker_file_scan(module);
+    worker::bind_worker_topology(module);
+    worker::bind_worker_trace(module);
+    worker::bind_worker_wait(module);
 }
@@ -26,8 +26,33 @@
 #include "include_pybind11.h"
 #include "runnable.h"
 
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
 namespace worker
 {
+    ///
+    /// \brief Guards the fields Python can set on an input.
+    ///
+    /// Without the GIL (on a free-threaded build), one thread may set
+    /// a field while another launches a job from the same input.
+    /// Copies get a mutex of their own, so inputs stay copyable.
+    ///
+    class field_mutex
+    {
+    public:
+        field_mutex() = default;
+        field_mutex(const field_mutex &) : m_mutex() {}
+        field_mutex &operator=(const field_mutex &) { return *this; }
+
+        void lock() { m_mutex.lock(); }
+        void unlock() { m_mutex.unlock(); }
+
+    private:
+        std::mutex m_mutex = {};
+    };
+
     struct job_data
     {
         pybind11::object python_input = {};
@@ -40,17 +65,93 @@ namespace worker
     ///
     struct input
     {
+        /// @brief The NUMA node to run the job on, or -1 for any.
+        int numa_node = -1;
+
+        /// @brief Held while a field is read or written.  Never held
+        ///        while calling into Python.
+        mutable field_mutex fields_mutex = {};
+
         virtual ~input() = default;
         virtual job_data get_job_data() const = 0;
         virtual std::string get_str() const = 0;
         virtual std::string get_repr() const = 0;
     };
 
+    /**
+     * @brief Read one field of 'fields' under its fields_mutex.
+     */
+    template <typename Fields, typename C, typename T>
+    T get_field(const Fields &fields, T C::*field)
+    {
+        std::lock_guard<field_mutex> lock(fields.fields_mutex);
+        return fields.*field;
+    }
+
+    /**
+     * @brief Copy all of 'fields' under its fields_mutex, so that a
+     *        job is made from values set together.
+     */
+    template <typename T> T copy_fields(const T &fields)
+    {
+        std::lock_guard<field_mutex> lock(fields.fields_mutex);
+        return fields;
+    }
+
+    /**
+     * @brief Bind a field read and written under the fields_mutex, in
+     *        place of def_readwrite().
+     *
+     *        Values are converted to and from Python outside the lock,
+     *        and a replaced value is released only after it.
+     */
+    template <typename Class, typename C, typename T>
+    Class &def_field(Class &obj, const char *name, T C::*field,
+                     const char *doc)
+    {
+        return obj.def_property(
+            name, [field](const C &self) { return get_field(self, field); },
+            [field](C &self, T value) {
+                // 'value', the old one after the swap, outlives the lock.
+                std::lock_guard<field_mutex> lock(self.fields_mutex);
+                std::swap(self.*field, value);
+            },
+            doc);
+    }
+
     inline pybind11::module &bind_worker_input(pybind11::module &module)
     {
         pybind11::class_<input> obj(module, "_JobInput");
         obj.def("__repr__", &input::get_repr);
         obj.def("__str__", &input::get_str);
+        obj.def_property(
+            "numa_node",
+            [](const input &self) -> pybind11::object {
+                const auto node = get_field(self, &input::numa_node);
+                if (node < 0)
+                {
+                    return pybind11::none();
+                }
+                return pybind11::int_(node);
+            },
+            [](input &self, pybind11::object node) {
+                const auto value = node.is_none() ? -1 : node.cast<int>();
+                if (!node.is_none() && value < 0)
+                {
+                    throw std::invalid_argument("numa_node must be >= 0");
+                }
+                std::lock_guard<field_mutex> lock(self.fields_mutex);
+                self.numa_node = value;
+            },
+            R"pbdoc(
+The NUMA node to run the Job on, or None (the default) for any.
+
+With Executor.POOL, the Job waits for a thread placed on the node (see
+set_affinity()); if there is none, any thread runs it.  With
+Executor.THREAD, the Job's thread is pinned to the node's CPUs.  Memory
+the Job first writes to (such as its output's buffers) is then
+allocated on the node.
+)pbdoc");
         return module;
     }
 
@@ -22,12 +22,45 @@
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // ------------------------------------------------------------------
 #include "job.h"
+#include "async_channel.h"
+#include "dependencies.h"
+#include "dispatcher.h"
+#include "metrics.h"
+#include "trace.h"
+#include "wait.h"
 
-worker::job::~job() { abort(DEFAULT_ABORT_TIMEOUT); }
+#include <initializer_list>
 
-bool worker::job::abort(int timeout_in_seconds)
+worker::job::job() { add_metric(metric::jobs_created); }
+
+worker::job::~job()
+{
+    if (Py_IsInitialized() && PyGILState_Check())
+    {
+        // Dropped by Python.  The job may need the GIL to finish (a
+        // PythonJob's hooks take it), so wait without it.
+        pybind11::gil_scoped_release release;
+        abort(DEFAULT_ABORT_TIMEOUT);
+    }
+    else
+    {
+        abort(DEFAULT_ABORT_TIMEOUT);
+    }
+    add_metric(metric::jobs_destroyed);
+}
+
+bool worker::job::abort(double timeout_in_seconds)
 {
-    control->keep_working.clear();
+    if (control->cancellation.request_stop() && !finished())
+    {
+        add_metric(metric::jobs_aborted);
+        if (tracing())
+        {
+            trace_event(trace_kind::abort, control.get());
+        }
+    }
+    // Don't keep waiting for prerequisites.
+    submit_if_deferred(*control);
     wait_for_result(timeout_in_seconds);
     return finished();
 }
@@ -39,7 +72,7 @@ worker::job::clock_t::duration worker::job::elapsed() const
     auto start = clock_t::time_point{control->start_working};
     if (epoch != start)
     {
-        auto end = clock_t::time_point{control->end_working};
+        auto end = clock_t::time_point{control->start_teardown};
         if (end == epoch)
         {
             end = clock_t::now();
@@ -49,6 +82,46 @@ worker::job::clock_t::duration worker::job::elapsed() const
     return result;
 }
 
+worker::job::timings_t worker::job::timings() const
+{
+    const auto epoch = clock_t::time_point{};
+    const auto never = clock_t::duration(-1);
+
+    // Read 'finished' first and 'now' last: every earlier timestamp
+    // was written before them, so the phases always add up.
+    const auto finished = clock_t::time_point{control->finished};
+    const auto teardown = clock_t::time_point{control->start_teardown};
+    const auto working = clock_t::time_point{control->start_working};
+    const auto setup = clock_t::time_point{control->start_setup};
+    const auto launched = clock_t::time_point{control->launched};
+    const auto now = clock_t::now();
+
+    // A phase ends when the next phase the job entered starts.
+    auto span = [&](clock_t::time_point begin,
+                    std::initializer_list<clock_t::time_point> ends) {
+        if (epoch == begin)
+        {
+            return never;
+        }
+        for (auto end : ends)
+        {
+            if (epoch != end)
+            {
+                return end - begin;
+            }
+        }
+        return now - begin;
+    };
+
+    timings_t result = {};
+    result.queued = span(launched, {setup, finished});
+    result.setup = span(setup, {working, teardown, finished});
+    result.working = span(working, {teardown, finished});
+    result.teardown = span(teardown, {finished});
+    result.total = span(launched, {finished});
+    return result;
+}
+
 bool worker::job::finished() const
 {
     auto result = false;
@@ -68,23 +141,29 @@ bool worker::job::finished() const
     return result;
 }
 
-bool worker::job::wait_for_result(int timeout_in_seconds) const
+bool worker::job::wait_for_result(double timeout_in_seconds) const
 {
+    trace_wait_scope traced(control.get());
     auto result = false;
     switch (get_state())
     {
     case state::not_started:
-        // The thread hasn't started.  This means the
-        // object is freestanding and probably won't ever be
-        // associated with anything.  Technically, it's done
-        // but with a failure.
-        break;
+        if (!future.valid())
+        {
+            // The job was never launched.  This means the
+            // object is freestanding and probably won't ever be
+            // associated with anything.  Technically, it's done
+            // but with a failure.
+            break;
+        }
+        // Otherwise the job is queued waiting for a worker thread.
+        // fall through
     case state::setup:
     case state::working:
     case state::teardown:
     case state::complete:
     case state::incomplete:
-        if (0 > timeout_in_seconds)
+        if (waits_forever(timeout_in_seconds))
         {
             // No timeout set, wait "forever"
             future.wait();
@@ -92,7 +171,8 @@ bool worker::job::wait_for_result(int timeout_in_seconds) const
         }
         else
         {
-            switch (future.wait_for(std::chrono::seconds(timeout_in_seconds)))
+            switch (future.wait_for(
+                std::chrono::duration<double>(timeout_in_seconds)))
             {
             case std::future_status::ready:
                 result = (state::complete == get_state());
@@ -105,7 +185,7 @@ bool worker::job::wait_for_result(int timeout_in_seconds) const
                 // given.
                 break;
             case std::future_status::deferred:
-                // IMPOSSIBLE if really_async was used.
+                // IMPOSSIBLE, executors never defer tasks.
                 assert(false);
                 // Still, if assertions aren't enabled, we report
                 // that the worker didn't successfully finish.
@@ -127,12 +207,110 @@ pybind11::module &worker::bind_worker_job(pybind11::module &module)
         thread will block until the job is finished.
         )pbdoc");
 
+    pybind11::class_<job::timings_t> timings(module, "JobTimings", R"pbdoc(
+Time a Job spent in each phase, as datetime.timedelta values.
+
+A phase still in progress counts up to now.  A phase the Job never
+entered (for example, setup for a Job aborted while queued) is None.
+)pbdoc");
+    auto add_timing = [&timings](const char *name,
+                                 job::clock_t::duration job::timings_t::*field,
+                                 const char *doc) {
+        timings.def_property_readonly(
+            name,
+            [field](const job::timings_t &self) -> pybind11::object {
+                if (self.*field < job::clock_t::duration::zero())
+                {
+                    return pybind11::none();
+                }
+                return pybind11::cast(self.*field);
+            },
+            doc);
+    };
+    add_timing("queued", &job::timings_t::queued,
+               "From launch() until a thread picked the Job up");
+    add_timing("setup", &job::timings_t::setup, "In the SETUP state");
+    add_timing("working", &job::timings_t::working, "In the WORKING state");
+    add_timing("teardown", &job::timings_t::teardown,
+               "In the TEARDOWN state");
+    add_timing("total", &job::timings_t::total,
+               "From launch() until the Job finished");
+
+    obj.def("__await__", &await_job, R"pbdoc(
+Wait for the job from an asyncio coroutine:
+
+    result = await my_job
+
+The result is the same as wait_for_result(): True if the job
+finished and completed successfully.  The event loop is woken
+through one file descriptor shared by all awaited Jobs.
+
+An awaited Job is kept alive until it finishes, so
+'await launch(MyJob())' does not abort the Job.
+)pbdoc");
+
+    obj.def(
+        "on_progress",
+        [](pybind11::object self, pybind11::object callback) {
+            add_job_callback(std::move(self), std::move(callback), false);
+        },
+        pybind11::arg("callback"), R"pbdoc(
+Call callback(job, value) as the Job reports progress.
+
+Callbacks run on the dispatcher thread, not the Job's.  Progress is
+coalesced: a callback gets the latest value reported since its last
+call, at most as often as set by set_callback_rate().  Count reports
+the last number counted, and a PythonJob reports whatever it passes
+to report_progress().
+
+The Job is kept alive until it finishes, as with on_done().
+)pbdoc");
+
+    obj.def(
+        "on_done",
+        [](pybind11::object self, pybind11::object callback) {
+            add_job_callback(std::move(self), std::move(callback), true);
+        },
+        pybind11::arg("callback"), R"pbdoc(
+Call callback(job) once the Job is finished.
+
+The callback runs on the dispatcher thread, even if the Job already
+finished.  Every completion is delivered, batched with others that
+arrive close together.  Until then the Job is kept alive, so
+'launch(MyJob()).on_done(callback)' does not abort the Job.
+Exceptions raised by callbacks are reported, not raised.
+)pbdoc");
+
+    obj.def(
+        "abort",
+        [](job &self, pybind11::object timeout) {
+            const auto timeout_in_seconds = to_timeout_in_seconds(timeout);
+            pybind11::gil_scoped_release release;
+            return self.abort(timeout_in_seconds);
+        },
+        pybind11::arg("timeout_in_seconds") = pybind11::none(), R"pbdoc(
+Ask the Job to stop, then wait for it to finish.
+
+The timeout is the same as for wait_for_result().  Returns True if
+the Job is finished.
+)pbdoc");
+
     obj.def_property_readonly(
         "elapsed", &job::elapsed,
         "Time spent in the working state.  Updated in real time by Job");
 
-    obj.def_property_readonly("finished", &job::finished,
-                              "Set to True when job no longer running");
+    obj.def_property_readonly("timings", &job::timings, R"pbdoc(
+Time spent in each phase of the Job, as a JobTimings object.
+)pbdoc");
+
+    obj.def_property_readonly(
+        "finished",
+        [](const job &self) {
+            // Waits (briefly) for the future once the job is done.
+            pybind11::gil_scoped_release release;
+            return self.finished();
+        },
+        "Set to True when job no longer running");
 
     obj.def_readonly("input", &job::input,
                      "Copy of job-specific input parameters");
@@ -141,9 +319,22 @@ pybind11::module &worker::bind_worker_job(pybind11::module &module)
         "output", &job::output,
         "Job-specific output object.  Updated in real time by Job");
 
-    obj.def("wait_for_result", &job::wait_for_result,
-            pybind11::arg("timeout_in_seconds") = -1,
-            "Wait until the job is completed with timeout value");
+    obj.def(
+        "wait_for_result",
+        [](const job &self, pybind11::object timeout) {
+            const auto timeout_in_seconds = to_timeout_in_seconds(timeout);
+            pybind11::gil_scoped_release release;
+            return self.wait_for_result(timeout_in_seconds);
+        },
+        pybind11::arg("timeout_in_seconds") = pybind11::none(), R"pbdoc(
+Wait until the job is completed with timeout value.
+
+The timeout is None (the default) to wait forever, a number of
+seconds (fractions allowed), or a datetime.timedelta.  The GIL is
+released while waiting, so other Python threads keep running.
+
+Returns True if the job finished and completed successfully.
+)pbdoc");
 
     obj.def_property_readonly(
         "state", &job::get_state,
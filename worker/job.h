@@ -23,30 +23,91 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // ------------------------------------------------------------------
+#include "./cancellation.h"
+#include "./executor.h"
+#include "./latch.h"
+#include "./pool_allocator.h"
 #include "./state.h"
 
+#include <cstdint>
 #include <future>
 
 namespace worker
 {
-    struct job final
+    struct dependent_link;
+
+    struct job final : public pooled
     {
         typedef std::chrono::steady_clock clock_t;
         typedef std::atomic<clock_t::time_point> time_point_t;
+
+        ///
+        /// \brief State shared between the job and its worker thread.
+        ///
+        /// Python polls 'state' while the worker tests 'cancellation'
+        /// in its inner loop, and each is written by the other side.
+        /// So they (and the worker-written timestamps) each get their
+        /// own cache line to keep the two threads from false sharing.
+        /// Each timestamp is the time the job entered that state, or
+        /// the clock's epoch if it hasn't.
+        ///
         struct control_t
         {
-            std::atomic<worker::state> state = {worker::state::not_started};
-            std::atomic_flag keep_working = {};
+            alignas(CACHE_LINE_SIZE) std::atomic<worker::state> state = {
+                worker::state::not_started};
+
+            alignas(CACHE_LINE_SIZE) cancellation_token cancellation = {};
 
-            /// @brief The start time for the related runnable::working().
+            /// @brief The priority and deadline given to launch().
+            task_schedule schedule = {};
+
+            /// @brief Set by launch(), so the job's queued time counts.
+            alignas(CACHE_LINE_SIZE) time_point_t launched = {
+                clock_t::time_point{}};
+            time_point_t start_setup = {clock_t::time_point{}};
             time_point_t start_working = {clock_t::time_point{}};
-            /// @brief The end time for the related runnable::working().
-            time_point_t end_working = {clock_t::time_point{}};
+            time_point_t start_teardown = {clock_t::time_point{}};
+            /// @brief Set on entering state::complete or state::incomplete.
+            time_point_t finished = {clock_t::time_point{}};
+
+            /// @brief Released when the job leaves state::not_started.
+            latch started = {};
+
+            /// @brief Set when Python awaits the job, so run_job posts
+            ///        it to the async_channel when finished.
+            std::atomic<bool> awaited = {false};
+
+            /// @brief Set when Python registers a callback on the job,
+            ///        so progress and completion go to the dispatcher.
+            std::atomic<bool> watched = {false};
+
+            /// @brief The latest value given to report_progress(), and
+            ///        whether the dispatcher has a progress event for
+            ///        the job that it hasn't taken yet.
+            std::atomic<std::int64_t> progress = {0};
+            std::atomic<bool> progress_posted = {false};
+
+            /// @brief Set if the job holds an admission slot, to give
+            ///        back when it finishes.
+            bool admitted = false;
+
+            /// @brief Jobs launched to run after this one, or a
+            ///        marker once it has finished (see dependencies.h).
+            std::atomic<dependent_link *> dependents = {nullptr};
+
+            /// @brief Prerequisites this job is still waiting for.
+            std::atomic<std::size_t> blockers = {0};
+
+            /// @brief The task launch() held back for the
+            ///        prerequisites, and whether it is still held.
+            executor::task_t deferred_task = {};
+            std::atomic<bool> deferred = {false};
         };
         typedef std::shared_ptr<control_t> control_ptr_t;
 
         std::future<void> future = {};
-        control_ptr_t control = {std::make_shared<control_t>()};
+        control_ptr_t control = {
+            std::allocate_shared<control_t>(pool_allocator<control_t>())};
         pybind11::object input = {};
         pybind11::object output = {};
 
@@ -61,7 +122,7 @@ namespace worker
          *        If this value is exceeded, the wait is abandoned.
          * @return Returns true if the worker is finished.
          */
-        bool abort(int timeout_in_seconds = DEFAULT_ABORT_TIMEOUT);
+        bool abort(double timeout_in_seconds = DEFAULT_ABORT_TIMEOUT);
 
         /**
          * @brief Return the time spent in runnable::run()
@@ -78,6 +139,26 @@ namespace worker
          */
         clock_t::duration elapsed() const;
 
+        ///
+        /// \brief Time spent in each phase of the job, so far.
+        ///
+        /// A phase still in progress counts up to now.  A phase the
+        /// job never entered is negative.
+        ///
+        struct timings_t
+        {
+            clock_t::duration queued;
+            clock_t::duration setup;
+            clock_t::duration working;
+            clock_t::duration teardown;
+            clock_t::duration total;
+        };
+
+        /**
+         * @brief Return the time spent in each phase.
+         */
+        timings_t timings() const;
+
         /**
          * @brief Return true if worker thread is finished and result is ready.
          * @return true if result is ready, false otherwise.
@@ -92,19 +173,21 @@ namespace worker
 
         /**
          * @brief Wait for the worker to complete
-         * @param timeout_in_seconds The timeout value in seconds.
+         * @param timeout_in_seconds The timeout value in seconds
+         *        (fractions allowed, negative means forever,
+         *        see waits_forever()).
          *        If this value is exceeded, the wait is abandoned
          *        and false is returned.
          * @return Return true if the worker is finished and the
          *        task was completed, false otherwise.
          */
-        bool wait_for_result(int timeout_in_seconds) const;
+        bool wait_for_result(double timeout_in_seconds) const;
 
         // We want to auto-abort at object destruction.
         // Because of the 'rule of 5', this now forces us to specify
         // all five additional forms.  In this case, the object is
         // lazy and just disallows any form of movement or copy.
-        job() = default;
+        job();
         job(const job &rhs) = delete;
         job(job &&rhs) = delete;
         job &operator=(const job &rhs) = delete;
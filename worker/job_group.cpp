@@ -0,0 +1,180 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "job_group.h"
+#include "dependencies.h"
+#include "metrics.h"
+#include "trace.h"
+#include "wait.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    /**
+     * @brief Return the seconds left until the deadline.
+     */
+    double remaining(worker::job::clock_t::time_point deadline)
+    {
+        const auto left = std::chrono::duration<double>(
+            deadline - worker::job::clock_t::now());
+        return std::max(0.0, left.count());
+    }
+
+    worker::job::clock_t::time_point to_deadline(double timeout_in_seconds)
+    {
+        return worker::job::clock_t::now() +
+               std::chrono::duration_cast<worker::job::clock_t::duration>(
+                   std::chrono::duration<double>(timeout_in_seconds));
+    }
+}
+
+worker::job_group::~job_group()
+{
+    if (Py_IsInitialized() && PyGILState_Check())
+    {
+        // Dropped by Python, which the jobs may need to finish.
+        pybind11::gil_scoped_release release;
+        abort(job::DEFAULT_ABORT_TIMEOUT);
+    }
+    else
+    {
+        abort(job::DEFAULT_ABORT_TIMEOUT);
+    }
+}
+
+bool worker::job_group::abort(double timeout_in_seconds)
+{
+    // Tell everybody first, so the jobs wind down in parallel.
+    for (auto &job : jobs)
+    {
+        if (job->control->cancellation.request_stop() && !job->finished())
+        {
+            add_metric(metric::jobs_aborted);
+            if (tracing())
+            {
+                trace_event(trace_kind::abort, job->control.get());
+            }
+        }
+        submit_if_deferred(*job->control);
+    }
+    wait_for_result(timeout_in_seconds);
+    return finished();
+}
+
+bool worker::job_group::finished() const
+{
+    for (auto &job : jobs)
+    {
+        if (!job->finished())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool worker::job_group::wait_for_result(double timeout_in_seconds) const
+{
+    const auto forever = waits_forever(timeout_in_seconds);
+    const auto deadline =
+        forever ? job::clock_t::time_point{} : to_deadline(timeout_in_seconds);
+
+    auto result = true;
+    for (auto &job : jobs)
+    {
+        if (!job->wait_for_result(forever ? -1.0 : remaining(deadline)))
+        {
+            result = false;
+        }
+    }
+    return result;
+}
+
+pybind11::module &worker::bind_worker_job_group(pybind11::module &module)
+{
+    pybind11::class_<job_group> obj(module, "JobGroup", R"pbdoc(
+        Sequence of Job objects.  Returned from launch_many().
+
+        When the object is deleted (reference count reaches 0), any
+        of its Jobs that are not finished are aborted, and the Python
+        thread will block until they are finished.  The Jobs can be
+        passed to wait_all(), wait_any() and as_completed().
+        )pbdoc");
+
+    obj.def("__len__", [](const job_group &self) { return self.jobs.size(); });
+
+    obj.def(
+        "__getitem__",
+        [](job_group &self, std::ptrdiff_t index) -> job & {
+            const auto size = static_cast<std::ptrdiff_t>(self.jobs.size());
+            if (0 > index)
+            {
+                index += size;
+            }
+            if (0 > index || size <= index)
+            {
+                throw pybind11::index_error("JobGroup index out of range");
+            }
+            return *self.jobs[static_cast<std::size_t>(index)];
+        },
+        pybind11::return_value_policy::reference_internal);
+
+    obj.def(
+        "abort",
+        [](job_group &self, pybind11::object timeout) {
+            const auto timeout_in_seconds = to_timeout_in_seconds(timeout);
+            pybind11::gil_scoped_release release;
+            return self.abort(timeout_in_seconds);
+        },
+        pybind11::arg("timeout_in_seconds") = pybind11::none(),
+        "Abort every Job and wait for them.  True if all finished.");
+
+    obj.def_property_readonly(
+        "finished",
+        [](const job_group &self) {
+            pybind11::gil_scoped_release release;
+            return self.finished();
+        },
+        "Set to True when no Job is still running");
+
+    obj.def(
+        "wait_for_result",
+        [](const job_group &self, pybind11::object timeout) {
+            const auto timeout_in_seconds = to_timeout_in_seconds(timeout);
+            pybind11::gil_scoped_release release;
+            return self.wait_for_result(timeout_in_seconds);
+        },
+        pybind11::arg("timeout_in_seconds") = pybind11::none(), R"pbdoc(
+Wait until every Job is completed, with one timeout for the group.
+
+The timeout is None (the default) to wait forever, a number of
+seconds (fractions allowed), or a datetime.timedelta.  The GIL is
+released while waiting.
+
+Returns True if every Job finished and completed successfully.
+)pbdoc");
+
+    return module;
+}
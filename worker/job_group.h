@@ -0,0 +1,75 @@
+#ifndef WORKER_JOB_GROUP_H
+#define WORKER_JOB_GROUP_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./job.h"
+
+#include <memory>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief The jobs created by one launch_many() call.
+    ///
+    struct job_group final
+    {
+        std::vector<std::unique_ptr<job>> jobs = {};
+
+        /**
+         * @brief Request every job to abort, then wait for them.
+         * @param timeout_in_seconds The timeout for the whole group
+         *        (negative means forever).
+         * @return Returns true if every job is finished.
+         */
+        bool abort(double timeout_in_seconds = job::DEFAULT_ABORT_TIMEOUT);
+
+        /**
+         * @brief Return true if every job is finished.
+         */
+        bool finished() const;
+
+        /**
+         * @brief Wait for every job to complete.
+         * @param timeout_in_seconds The timeout for the whole group
+         *        (negative means forever).
+         * @return Return true if every job finished and completed
+         *        successfully, false otherwise.
+         */
+        bool wait_for_result(double timeout_in_seconds) const;
+
+        // Like job, abort at destruction and disallow copy and move.
+        job_group() = default;
+        job_group(const job_group &rhs) = delete;
+        job_group(job_group &&rhs) = delete;
+        job_group &operator=(const job_group &rhs) = delete;
+        job_group &operator=(job_group &&rhs) = delete;
+        ~job_group();
+    };
+
+    pybind11::module &bind_worker_job_group(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_JOB_GROUP_H
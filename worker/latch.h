@@ -0,0 +1,97 @@
+#ifndef WORKER_LATCH_H
+#define WORKER_LATCH_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace worker
+{
+    ///
+    /// \brief One-shot latch: one thread signals, others wait.
+    ///
+    /// A cut-down std::latch (C++20) with a count of one and a timed
+    /// wait.  Waiters block on a condition variable, so they wake as
+    /// soon as count_down() is called rather than on a polling tick.
+    ///
+    class latch
+    {
+    public:
+        latch() = default;
+
+        /**
+         * @brief Release all current and future waiters.
+         */
+        void count_down()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_ready.store(true, std::memory_order_release);
+            }
+            m_condition.notify_all();
+        }
+
+        /**
+         * @brief Return true if count_down() has been called.
+         */
+        bool try_wait() const
+        {
+            return m_ready.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Wait for count_down() with a timeout.
+         * @return True if count_down() was called, false if the
+         *        timeout expired first.
+         */
+        template <typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> &timeout)
+        {
+            if (try_wait())
+            {
+                return true;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_condition.wait_for(lock, timeout,
+                                        [this] { return try_wait(); });
+        }
+
+        // Waiters hold a reference to the latch.
+        latch(const latch &) = delete;
+        latch(latch &&) = delete;
+        latch &operator=(const latch &) = delete;
+        latch &operator=(latch &&) = delete;
+        ~latch() = default;
+
+    private:
+        std::atomic<bool> m_ready = {false};
+        std::mutex m_mutex = {};
+        std::condition_variable m_condition = {};
+    };
+
+} // end namespace worker
+
+#endif // WORKER_LATCH_H
@@ -0,0 +1,288 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "latency_histogram.h"
+#include "thread_shards.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+    using worker::PHASE_COUNT;
+    using worker::PRIORITY_COUNT;
+
+    // Four buckets per power of two of nanoseconds: [0, 4) exactly,
+    // then [4<<b, 5<<b), [5<<b, 6<<b), [6<<b, 7<<b), [7<<b, 8<<b).
+    enum
+    {
+        SUB_BUCKET_BITS = 2,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        BUCKET_COUNT = 64 * SUB_BUCKETS,
+        /// @brief One per phase, then one per priority.
+        HISTOGRAM_COUNT = PHASE_COUNT + PRIORITY_COUNT
+    };
+
+    std::size_t bucket_index(std::uint64_t ns)
+    {
+        if (ns < SUB_BUCKETS)
+        {
+            return static_cast<std::size_t>(ns);
+        }
+        std::size_t top_bit = 63;
+        while (0 == (ns >> top_bit))
+        {
+            --top_bit;
+        }
+        const auto shift = top_bit - SUB_BUCKET_BITS;
+        const auto sub = (ns >> shift) & (SUB_BUCKETS - 1);
+        return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>(sub);
+    }
+
+    std::uint64_t bucket_upper_bound(std::size_t index)
+    {
+        if (index < SUB_BUCKETS)
+        {
+            return index;
+        }
+        const auto shift = index / SUB_BUCKETS - 1;
+        const std::uint64_t sub = SUB_BUCKETS + index % SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    ///
+    /// \brief One thread's buckets.  Only its owner writes them, with
+    ///        plain load/store pairs rather than read-modify-writes.
+    ///
+    struct shard_t
+    {
+        std::atomic<std::uint64_t> counts[HISTOGRAM_COUNT][BUCKET_COUNT];
+        std::atomic<std::uint64_t> max[HISTOGRAM_COUNT];
+    };
+
+    typedef worker::thread_shards<shard_t> shards_t;
+
+    void bump(std::atomic<std::uint64_t> &value)
+    {
+        value.store(value.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    const char *phase_name(worker::phase which)
+    {
+        switch (which)
+        {
+        case worker::phase::queued:
+            return "queued";
+        case worker::phase::setup:
+            return "setup";
+        case worker::phase::working:
+            return "working";
+        case worker::phase::teardown:
+            return "teardown";
+        case worker::phase::total:
+            break;
+        }
+        return "total";
+    }
+
+    const char *priority_name(worker::priority level)
+    {
+        switch (level)
+        {
+        case worker::priority::low:
+            return "low";
+        case worker::priority::high:
+            return "high";
+        case worker::priority::normal:
+            break;
+        }
+        return "normal";
+    }
+
+    std::size_t histogram_index(worker::priority level)
+    {
+        return PHASE_COUNT + static_cast<std::size_t>(level);
+    }
+
+    void record(std::size_t p, std::chrono::nanoseconds latency)
+    {
+        const auto ns = static_cast<std::uint64_t>(
+            std::max(latency.count(), std::chrono::nanoseconds::rep(0)));
+        auto &shard = shards_t::local();
+        bump(shard.counts[p][bucket_index(ns)]);
+        if (shard.max[p].load(std::memory_order_relaxed) < ns)
+        {
+            shard.max[p].store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    worker::latency_summary summarize(std::size_t p)
+    {
+        std::uint64_t counts[BUCKET_COUNT] = {};
+        std::uint64_t max = 0;
+        shards_t::for_each([&](const shard_t &shard) {
+            for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+            {
+                counts[i] +=
+                    shard.counts[p][i].load(std::memory_order_relaxed);
+            }
+            max =
+                std::max(max, shard.max[p].load(std::memory_order_relaxed));
+        });
+
+        std::uint64_t total = 0;
+        for (auto count : counts)
+        {
+            total += count;
+        }
+
+        // Smallest bucket bound with at least 'fraction' of the
+        // samples at or below it.
+        auto percentile = [&](double fraction) {
+            const auto wanted =
+                static_cast<std::uint64_t>(fraction * total);
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+            {
+                seen += counts[i];
+                if (0 < seen && wanted <= seen)
+                {
+                    return std::chrono::nanoseconds(
+                        std::min(bucket_upper_bound(i), max));
+                }
+            }
+            return std::chrono::nanoseconds(max);
+        };
+
+        worker::latency_summary result = {};
+        result.count = total;
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.max = std::chrono::nanoseconds(max);
+        return result;
+    }
+}
+
+void worker::record_latency(phase which, std::chrono::nanoseconds latency)
+{
+    record(static_cast<std::size_t>(which), latency);
+}
+
+void worker::record_queue_wait(priority level,
+                               std::chrono::nanoseconds latency)
+{
+    record(histogram_index(level), latency);
+}
+
+worker::latency_summary worker::get_latency_summary(phase which)
+{
+    return summarize(static_cast<std::size_t>(which));
+}
+
+worker::latency_summary worker::get_queue_wait_summary(priority level)
+{
+    return summarize(histogram_index(level));
+}
+
+void worker::reset_latency_histograms()
+{
+    shards_t::for_each([](shard_t &shard) {
+        for (auto &phase_counts : shard.counts)
+        {
+            for (auto &count : phase_counts)
+            {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+        for (auto &max : shard.max)
+        {
+            max.store(0, std::memory_order_relaxed);
+        }
+    });
+}
+
+pybind11::module &
+worker::bind_worker_latency_histogram(pybind11::module &module)
+{
+    auto to_dict = [](const latency_summary &summary) {
+        pybind11::dict entry;
+        entry["count"] = summary.count;
+        entry["p50"] = summary.p50;
+        entry["p90"] = summary.p90;
+        entry["p99"] = summary.p99;
+        entry["max"] = summary.max;
+        return entry;
+    };
+
+    module.def(
+        "latency_histograms",
+        [to_dict] {
+            pybind11::dict result;
+            for (int p = 0; p < PHASE_COUNT; ++p)
+            {
+                const auto which = static_cast<phase>(p);
+                result[phase_name(which)] =
+                    to_dict(get_latency_summary(which));
+            }
+            return result;
+        },
+        R"pbdoc(
+Summarize how long every Job has spent in each phase.
+
+Returns
+----------
+A dict keyed by 'queued', 'setup', 'working', 'teardown' and
+'total'.  Each value is a dict with the sample 'count' and the
+'p50', 'p90', 'p99' and 'max' latencies as datetime.timedelta.
+Percentiles come from buckets and may overstate by up to 25%.
+)pbdoc");
+
+    module.def(
+        "queue_wait_histograms",
+        [to_dict] {
+            pybind11::dict result;
+            for (int p = 0; p < PRIORITY_COUNT; ++p)
+            {
+                const auto level = static_cast<priority>(p);
+                result[priority_name(level)] =
+                    to_dict(get_queue_wait_summary(level));
+            }
+            return result;
+        },
+        R"pbdoc(
+Summarize how long Jobs of each Priority waited to be started.
+
+Returns
+----------
+A dict keyed by 'low', 'normal' and 'high', with values like those
+of latency_histograms().  Together they cover the same Jobs as its
+'queued' entry.
+)pbdoc");
+
+    module.def("reset_latency_histograms", &worker::reset_latency_histograms,
+               "Empty the histograms summarized by latency_histograms() "
+               "and queue_wait_histograms()");
+    return module;
+}
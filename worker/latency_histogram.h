@@ -0,0 +1,98 @@
+#ifndef WORKER_LATENCY_HISTOGRAM_H
+#define WORKER_LATENCY_HISTOGRAM_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "executor.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace worker
+{
+    ///
+    /// \brief The parts of a job's life that are timed.
+    ///
+    enum class phase
+    {
+        queued,   ///< From launch until a worker picks the job up
+        setup,    ///< In runnable::on_setup()
+        working,  ///< In runnable::on_working()
+        teardown, ///< In runnable::on_teardown()
+        total     ///< From launch until the job is finished
+    };
+
+    enum
+    {
+        PHASE_COUNT = 5
+    };
+
+    ///
+    /// \brief Summary of one phase's latency histogram.
+    ///
+    /// Percentiles are bucket upper bounds, so they may overstate
+    /// by up to 25% (but never beyond max).
+    ///
+    struct latency_summary
+    {
+        std::uint64_t count;
+        std::chrono::nanoseconds p50;
+        std::chrono::nanoseconds p90;
+        std::chrono::nanoseconds p99;
+        std::chrono::nanoseconds max;
+    };
+
+    /**
+     * @brief Add a sample to a phase's histogram.  Lock-free; each
+     *        thread writes its own buckets.
+     */
+    void record_latency(phase which, std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Merge every thread's buckets for a phase.
+     */
+    latency_summary get_latency_summary(phase which);
+
+    /**
+     * @brief Add a sample to the queue-wait histogram of a priority.
+     *        The same wait is also recorded as phase::queued.
+     */
+    void record_queue_wait(priority level, std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Merge every thread's queue-wait buckets for a priority.
+     */
+    latency_summary get_queue_wait_summary(priority level);
+
+    /**
+     * @brief Empty every histogram.  Samples recorded at the same
+     *        moment may survive.
+     */
+    void reset_latency_histograms();
+
+    pybind11::module &bind_worker_latency_histogram(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_LATENCY_HISTOGRAM_H
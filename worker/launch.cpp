@@ -22,62 +22,223 @@
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // ------------------------------------------------------------------
 #include "launch.h"
+#include "admission.h"
+#include "async_channel.h"
+#include "completion.h"
+#include "dependencies.h"
+#include "dispatcher.h"
+#include "executor.h"
 #include "input.h"
 #include "job.h"
-#include "really_async.h"
+#include "job_group.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "trace.h"
+#include "wait.h"
+
+#include <map>
+#include <vector>
 
 namespace
 {
-    class set_timestamp_at_scope_exit
+    /**
+     * @brief Move the job to the given state, timestamping the
+     *        transition and recording how long the last phase took.
+     */
+    void enter_state(worker::job::control_t &control, worker::state state)
     {
-    public:
-        set_timestamp_at_scope_exit(worker::job::time_point_t &time)
-            : m_time(time)
+        const auto now = worker::job::clock_t::now();
+        auto record = [now](worker::phase which,
+                            const worker::job::time_point_t &since) {
+            worker::record_latency(
+                which, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           now - worker::job::clock_t::time_point{since}));
+        };
+
+        switch (control.state.load())
         {
+        case worker::state::not_started:
+            record(worker::phase::queued, control.launched);
+            worker::record_queue_wait(
+                control.schedule.level,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - worker::job::clock_t::time_point{control.launched}));
+            worker::add_metric(worker::metric::jobs_dequeued);
+            break;
+        case worker::state::setup:
+            record(worker::phase::setup, control.start_setup);
+            break;
+        case worker::state::working:
+            record(worker::phase::working, control.start_working);
+            break;
+        case worker::state::teardown:
+            record(worker::phase::teardown, control.start_teardown);
+            break;
+        case worker::state::complete:
+        case worker::state::incomplete:
+            break;
         }
-        ~set_timestamp_at_scope_exit() { m_time = worker::job::clock_t::now(); }
+
+        switch (state)
+        {
+        case worker::state::not_started:
+            break;
+        case worker::state::setup:
+            control.start_setup = now;
+            break;
+        case worker::state::working:
+            control.start_working = now;
+            break;
+        case worker::state::teardown:
+            control.start_teardown = now;
+            break;
+        case worker::state::complete:
+        case worker::state::incomplete:
+            control.finished = now;
+            record(worker::phase::total, control.launched);
+            worker::add_metric(worker::state::complete == state
+                                   ? worker::metric::jobs_completed
+                                   : worker::metric::jobs_incomplete);
+            break;
+        }
+        control.state = state;
+        if (worker::tracing())
+        {
+            worker::trace_event(worker::trace_kind::state, &control,
+                                static_cast<std::uint32_t>(state));
+        }
+    }
+
+    class count_down_at_scope_exit
+    {
+    public:
+        count_down_at_scope_exit(worker::latch &latch) : m_latch(latch) {}
+        ~count_down_at_scope_exit() { m_latch.count_down(); }
 
         // Delete copy constructor
-        set_timestamp_at_scope_exit(const set_timestamp_at_scope_exit &rhs) =
+        count_down_at_scope_exit(const count_down_at_scope_exit &rhs) =
             delete;
 
         // Delete move constructor
-        set_timestamp_at_scope_exit(set_timestamp_at_scope_exit &&rhs) = delete;
+        count_down_at_scope_exit(count_down_at_scope_exit &&rhs) = delete;
+
+        // Delete copy assignment
+        count_down_at_scope_exit
+        operator=(const count_down_at_scope_exit &rhs) = delete;
+
+        // Delete move assignment
+        count_down_at_scope_exit
+        operator=(count_down_at_scope_exit &&rhs) = delete;
+
+    private:
+        worker::latch &m_latch;
+    };
+
+    /**
+     * @brief Move from not_started to the given state and tell
+     *        launch() that the job has started.
+     */
+    void start_job(worker::job::control_t &control, worker::state state)
+    {
+        count_down_at_scope_exit started(control.started);
+        enter_state(control, state);
+    }
+
+    class notify_completion_at_scope_exit
+    {
+    public:
+        notify_completion_at_scope_exit(
+            const worker::job::control_ptr_t &control)
+            : m_control(control)
+        {
+        }
+        ~notify_completion_at_scope_exit()
+        {
+            // Let in any launch waiting for admission, and start any
+            // dependents from this thread, before waking anybody up.
+            worker::release_admission(*m_control);
+            worker::release_dependents(*m_control);
+            worker::job_completions().notify();
+            if (m_control->awaited)
+            {
+                worker::job_async_channel().post(m_control);
+            }
+            if (m_control->watched)
+            {
+                worker::post_job_done(m_control);
+            }
+        }
+
+        // Delete copy constructor
+        notify_completion_at_scope_exit(
+            const notify_completion_at_scope_exit &rhs) = delete;
+
+        // Delete move constructor
+        notify_completion_at_scope_exit(
+            notify_completion_at_scope_exit &&rhs) = delete;
 
         // Delete copy assignment
-        set_timestamp_at_scope_exit
-        operator=(const set_timestamp_at_scope_exit &rhs) = delete;
+        notify_completion_at_scope_exit
+        operator=(const notify_completion_at_scope_exit &rhs) = delete;
 
         // Delete move assignment
-        set_timestamp_at_scope_exit
-        operator=(set_timestamp_at_scope_exit &&rhs) = delete;
+        notify_completion_at_scope_exit
+        operator=(notify_completion_at_scope_exit &&rhs) = delete;
 
     private:
-        worker::job::time_point_t &m_time;
+        const worker::job::control_ptr_t &m_control;
     };
 
+    /**
+     * @brief Destroy the runnable, then enter the final state.
+     *
+     *        Runnables may hold Python objects, and take the GIL to
+     *        release them.  Doing that first means that waiting for a
+     *        finished job's future never waits for the GIL.
+     */
+    void finish_job(worker::job::control_t &control,
+                    std::unique_ptr<worker::runnable> &runnable,
+                    worker::state state)
+    {
+        runnable.reset();
+        enter_state(control, state);
+    }
+
     void run_job(std::unique_ptr<worker::runnable> runnable,
                  worker::job::control_ptr_t control)
     {
+        // Declared first so it fires after the final state is set,
+        // whichever way we leave.
+        notify_completion_at_scope_exit notify_completion(control);
+        // So the runnable can report_progress() from this thread.
+        worker::progress_scope progress(control);
+
         if (worker::state::not_started != control->state)
         {
             // This should be impossible.  Somebody's broken the source.
             assert(false);
-            control->state = worker::state::incomplete;
+            runnable.reset();
+            start_job(*control, worker::state::incomplete);
             throw std::runtime_error("[DEVELOPER] New job != not_started");
         }
 
+        if (control->cancellation.stop_requested())
+        {
+            // Aborted while still queued, so never start.
+            runnable.reset();
+            start_job(*control, worker::state::incomplete);
+            return;
+        }
+
         auto success = false;
         try
         {
-            control->state = worker::state::setup;
-            success = runnable->on_setup();
+            start_job(*control, worker::state::setup);
+            success = runnable->on_setup(control->cancellation);
             if (success)
             {
-                control->state = worker::state::working;
-                control->start_working = worker::job::clock_t::now();
-                set_timestamp_at_scope_exit end_working(control->end_working);
-                success = runnable->on_working(control->keep_working);
+                enter_state(*control, worker::state::working);
+                success = runnable->on_working(control->cancellation);
             }
         }
         catch (...)
@@ -85,65 +246,179 @@ namespace
             // Want to teardown despite error, but ignore further errors.
             try
             {
-                control->state = worker::state::teardown;
-                runnable->on_teardown();
+                enter_state(*control, worker::state::teardown);
+                runnable->on_teardown(control->cancellation);
             }
             catch (...)
             {
                 // IGNORE!
             }
             success = false;
-            control->state = worker::state::incomplete;
+            finish_job(*control, runnable, worker::state::incomplete);
             throw;
         }
 
         try
         {
-            control->state = worker::state::teardown;
-            success = runnable->on_teardown() && success;
+            enter_state(*control, worker::state::teardown);
+            success = runnable->on_teardown(control->cancellation) && success;
         }
         catch (...)
         {
             success = false;
-            control->state = worker::state::incomplete;
+            finish_job(*control, runnable, worker::state::incomplete);
             throw;
         }
 
-        control->state =
-            success ? worker::state::complete : worker::state::incomplete;
+        finish_job(*control, runnable,
+                   success ? worker::state::complete
+                           : worker::state::incomplete);
     }
-}
 
-pybind11::object worker::launch(worker::input *input)
-{
-    auto job = std::make_unique<worker::job>();
-    auto job_data = input->get_job_data();
+    /**
+     * @brief Create a job for the input, and the task that runs it.
+     * @param input The job-specific input.  Needs the GIL.
+     * @param task Set to the task to submit to the executor.
+     * @param schedule The job's priority and deadline.  The input
+     *        adds its NUMA node.
+     * @return The job, whose future is already tied to the task.
+     */
+    std::unique_ptr<worker::job>
+    prepare_job(const worker::input &input, worker::executor::task_t &task,
+                const worker::task_schedule &schedule)
+    {
+        auto job = std::make_unique<worker::job>();
+        auto job_data = input.get_job_data();
+        job->control->schedule = schedule;
+        job->control->schedule.node =
+            worker::get_field(input, &worker::input::numa_node);
+        job->control->launched = worker::job::clock_t::now();
+        if (worker::tracing())
+        {
+            worker::trace_event(worker::trace_kind::launch,
+                                job->control.get());
+        }
 
-    // Weirdly, atomic_flag is difficult to initialize within a
-    // structure.  Specifically, it doesn't seem to be able to be
-    // done in C++ by standard.  So we will set it here
-    job->control->keep_working.test_and_set();
+        job->input = std::move(job_data.python_input);
+        job->output = std::move(job_data.python_output);
 
-    job->input = std::move(job_data.python_input);
-    job->output = std::move(job_data.python_output);
-    job->future = really_async(run_job, std::move(job_data.runnable_object),
-                               job->control);
+        auto runnable = std::move(job_data.runnable_object);
+        task = worker::executor::task_t(
+            [runnable = std::move(runnable), control = job->control]() mutable
+            { run_job(std::move(runnable), std::move(control)); });
+        job->future = task.get_future();
+        return job;
+    }
 
-    auto retries = 0;
-    const auto MAX_RETRIES = 100;
-    do
+    /**
+     * @brief Submit the tasks of a group, together for each NUMA node
+     *        their inputs asked for.
+     */
+    void submit_by_node(const worker::job_group &group,
+                        std::vector<worker::executor::task_t> &tasks,
+                        const worker::task_schedule &schedule)
     {
-        if (worker::state::not_started == job->get_state())
+        std::map<int, std::vector<worker::executor::task_t>> by_node;
+        for (std::size_t i = 0; i < tasks.size(); ++i)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            by_node[group.jobs[i]->control->schedule.node].push_back(
+                std::move(tasks[i]));
         }
-        else
+        for (auto &item : by_node)
         {
-            // The worker has started.  We're done waiting.
-            break;
+            auto node_schedule = schedule;
+            node_schedule.node = item.first;
+            worker::get_executor().submit_many(item.second, node_schedule);
         }
-    } while (++retries < MAX_RETRIES);
-    if (MAX_RETRIES == retries)
+    }
+
+    /**
+     * @brief Return the schedule for the priority and deadline passed
+     *        to launch().  The deadline is in seconds (or a timedelta)
+     *        from now, or None.
+     */
+    worker::task_schedule get_schedule(worker::priority level,
+                                       const pybind11::object &deadline)
+    {
+        worker::task_schedule result = {};
+        result.level = level;
+        if (!deadline.is_none())
+        {
+            // Numbers as well as timedeltas, like the wait timeouts.
+            const auto seconds = worker::to_timeout_in_seconds(deadline);
+            result.deadline =
+                worker::job::clock_t::now() +
+                std::chrono::duration_cast<worker::job::clock_t::duration>(
+                    std::chrono::duration<double>(seconds));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Return the controls of the Job (or iterable of Jobs)
+     *        passed to launch() as 'depends_on'.
+     */
+    std::vector<worker::job::control_ptr_t>
+    get_prerequisites(const pybind11::object &depends_on)
+    {
+        std::vector<worker::job::control_ptr_t> prerequisites;
+        if (depends_on.is_none())
+        {
+            return prerequisites;
+        }
+        if (pybind11::isinstance<worker::job>(depends_on))
+        {
+            prerequisites.push_back(depends_on.cast<worker::job &>().control);
+            return prerequisites;
+        }
+        for (auto item : pybind11::iterable(depends_on))
+        {
+            prerequisites.push_back(item.cast<worker::job &>().control);
+        }
+        return prerequisites;
+    }
+}
+
+pybind11::object worker::launch(worker::input *input,
+                                pybind11::object depends_on,
+                                worker::priority level,
+                                pybind11::object deadline)
+{
+    // Check the arguments before creating the job, since a job that
+    // is never submitted can't finish.
+    const auto prerequisites = get_prerequisites(depends_on);
+    const auto schedule = get_schedule(level, deadline);
+    worker::admission_ticket ticket(1);
+
+    worker::executor::task_t task;
+    auto job = prepare_job(*input, task, schedule);
+    auto control = job->control;
+    ticket.assign(*control);
+    worker::add_metric(worker::metric::jobs_launched);
+    if (!prerequisites.empty())
+    {
+        // Waits (in state not_started) for the prerequisites, so
+        // there's nothing to wait for here.
+        worker::submit_after(control, std::move(task), prerequisites);
+        return pybind11::cast(job.release());
+    }
+
+    if (!worker::get_executor().submit(std::move(task), control->schedule))
+    {
+        // Every worker is busy, so the job stays queued (in state
+        // not_started) until one is free.  Don't wait for it.
+        return pybind11::cast(job.release());
+    }
+
+    // A worker is on its way, so wait (without the GIL) for it to
+    // move the job out of not_started.  It should take microseconds,
+    // so if a whole second goes by, something is badly wrong.
+    auto started = false;
+    {
+        pybind11::gil_scoped_release release;
+        started = control->started.wait_for(std::chrono::seconds(1));
+    }
+    if (!started)
     {
         throw std::runtime_error("Launched thread did not start");
     }
@@ -151,6 +426,37 @@ pybind11::object worker::launch(worker::input *input)
     return pybind11::cast(job.release());
 }
 
+pybind11::object worker::launch_many(pybind11::iterable inputs,
+                                     worker::priority level,
+                                     pybind11::object deadline)
+{
+    const auto schedule = get_schedule(level, deadline);
+    // Take every input first, so all of the Jobs are admitted at
+    // once.  Admitting one at a time could wait forever for slots
+    // held by earlier, not yet submitted, Jobs of the same call.
+    const pybind11::list items(inputs);
+    worker::admission_ticket ticket(items.size());
+
+    auto group = std::make_unique<worker::job_group>();
+    std::vector<worker::executor::task_t> tasks;
+    group->jobs.reserve(items.size());
+    tasks.reserve(items.size());
+    for (auto item : items)
+    {
+        tasks.emplace_back();
+        group->jobs.push_back(prepare_job(
+            item.cast<const worker::input &>(), tasks.back(), schedule));
+        ticket.assign(*group->jobs.back()->control);
+    }
+
+    worker::add_metric(worker::metric::jobs_launched, tasks.size());
+    {
+        pybind11::gil_scoped_release release;
+        submit_by_node(*group, tasks, schedule);
+    }
+    return pybind11::cast(group.release());
+}
+
 pybind11::module &worker::bind_worker_launch(pybind11::module &module)
 {
     module.def("launch", &worker::launch, R"pbdoc(
@@ -160,6 +466,10 @@ Returns
 ----------
 A Job object.
 
+The Job runs on the Executor selected with set_executor().  If all
+of its threads are busy, the Job is queued and its state stays
+NOT_STARTED until a thread is free.
+
 Note that if a Job object goes out of scope, the Job is
 aborted and the Python thread waits for the Job to finish.
 This means that the following code is (1) is effectively
@@ -175,7 +485,48 @@ function to a variable, so the job can execute, e.g.:
 my_job = launch(MyJob())
 if not my_job.wait_for_result(60):
     raise RuntimeError("Job didn't complete successfully in 1 minute!!")
+
+Parameters
+----------
+input : The Job-specific input.
+depends_on : A Job, or an iterable of Jobs, that must finish before
+    this Job starts.  The new Job stays NOT_STARTED until they have.
+    The worker thread that finishes the last of them starts it,
+    without going back to Python.  If any of them finishes
+    INCOMPLETE, the new Job is cancelled and finishes INCOMPLETE
+    too, as do any Jobs that depend on it.  launch() does not wait
+    for such a Job to start.
+priority : The Priority of the Job.  With Executor.POOL, a queued
+    Job of higher Priority starts before one of lower Priority, but
+    a lower Priority is never passed over more than a few times in
+    a row.
+deadline : Seconds (or a timedelta) from now by which the Job
+    should start.  With Executor.POOL, queued Jobs of the same
+    Priority start earliest deadline first, ahead of Jobs with no
+    deadline.  A missed deadline is not an error.
+)pbdoc",
+               pybind11::arg("input"),
+               pybind11::arg("depends_on") = pybind11::none(),
+               pybind11::arg("priority") = worker::priority::normal,
+               pybind11::arg("deadline") = pybind11::none());
+
+    module.def("launch_many", &worker::launch_many, R"pbdoc(
+Launch one Job for each input in an iterable.
+
+All the Jobs are prepared in one pass and then handed to the
+Executor at once, with the GIL released only once.  Unlike launch(),
+this does not wait for any Job to start.
+
+Returns
+----------
+A JobGroup holding the Jobs, in the same order as the inputs.
+
+As with launch(), keep the JobGroup in a variable.  When it goes
+out of scope, all of its Jobs are aborted.  The priority and deadline
+apply to every Job, as described for launch().
 )pbdoc",
-               pybind11::arg("input"));
+               pybind11::arg("inputs"),
+               pybind11::arg("priority") = worker::priority::normal,
+               pybind11::arg("deadline") = pybind11::none());
     return module;
 }
@@ -23,11 +23,20 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // ------------------------------------------------------------------
+#include "./executor.h"
 #include "./input.h"
 
 namespace worker
 {
-    pybind11::object launch(worker::input *input);
+    pybind11::object launch(worker::input *input,
+                            pybind11::object depends_on = pybind11::none(),
+                            worker::priority level = worker::priority::normal,
+                            pybind11::object deadline = pybind11::none());
+
+    pybind11::object
+    launch_many(pybind11::iterable inputs,
+                worker::priority level = worker::priority::normal,
+                pybind11::object deadline = pybind11::none());
 
     pybind11::module &bind_worker_launch(pybind11::module &module);
 
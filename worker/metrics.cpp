@@ -0,0 +1,207 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "metrics.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+    struct metric_info
+    {
+        worker::metric which;
+        const char *name;
+        const char *help;
+    };
+
+    // In the order get_metrics() reads them: every event is listed
+    // before the events that must happen first.
+    const metric_info METRICS[worker::METRIC_COUNT] = {
+        {worker::metric::jobs_destroyed, "jobs_destroyed",
+         "Job objects destroyed"},
+        {worker::metric::threads_exited, "threads_exited",
+         "Executor threads exited"},
+        {worker::metric::jobs_completed, "jobs_completed",
+         "Jobs that finished in state COMPLETE"},
+        {worker::metric::jobs_incomplete, "jobs_incomplete",
+         "Jobs that finished in state INCOMPLETE"},
+        {worker::metric::jobs_aborted, "jobs_aborted",
+         "Unfinished Jobs told to abort"},
+        {worker::metric::jobs_dequeued, "jobs_dequeued",
+         "Jobs picked up by a thread (or dropped, if aborted first)"},
+        {worker::metric::jobs_launched, "jobs_launched",
+         "Jobs handed to the executor"},
+        {worker::metric::jobs_created, "jobs_created",
+         "Job objects created"},
+        {worker::metric::jobs_rejected, "jobs_rejected",
+         "Jobs refused by admission control"},
+        {worker::metric::launches_throttled, "launches_throttled",
+         "Launches that waited for admission"},
+        {worker::metric::threads_started, "threads_started",
+         "Executor threads started"},
+    };
+
+    // For output, in declaration order.
+    const metric_info &info_for(std::size_t index)
+    {
+        for (const auto &info : METRICS)
+        {
+            if (static_cast<std::size_t>(info.which) == index)
+            {
+                return info;
+            }
+        }
+        return METRICS[0];
+    }
+
+    std::uint64_t difference(std::uint64_t larger, std::uint64_t smaller)
+    {
+        return larger < smaller ? 0 : larger - smaller;
+    }
+}
+
+std::uint64_t worker::metrics_snapshot::jobs_queued() const
+{
+    return difference(get(metric::jobs_launched), get(metric::jobs_dequeued));
+}
+
+std::uint64_t worker::metrics_snapshot::jobs_running() const
+{
+    return difference(get(metric::jobs_dequeued),
+                      get(metric::jobs_completed) +
+                          get(metric::jobs_incomplete));
+}
+
+std::uint64_t worker::metrics_snapshot::jobs_alive() const
+{
+    return difference(get(metric::jobs_created),
+                      get(metric::jobs_destroyed));
+}
+
+std::uint64_t worker::metrics_snapshot::worker_threads() const
+{
+    return difference(get(metric::threads_started),
+                      get(metric::threads_exited));
+}
+
+worker::metrics_snapshot worker::get_metrics()
+{
+    metrics_snapshot result = {};
+    for (const auto &info : METRICS)
+    {
+        const auto index = static_cast<std::size_t>(info.which);
+        std::uint64_t total = 0;
+        thread_shards<metrics_shard>::for_each(
+            [&](const metrics_shard &shard) {
+                total += shard.counts[index].load(std::memory_order_acquire);
+            });
+        result.counts[index] = total;
+    }
+    return result;
+}
+
+std::string worker::format_prometheus(const metrics_snapshot &snapshot)
+{
+    std::ostringstream out;
+    auto write = [&out](const std::string &name, const char *type,
+                        const char *help, std::uint64_t value) {
+        out << "# HELP gild_" << name << ' ' << help << '\n'
+            << "# TYPE gild_" << name << ' ' << type << '\n'
+            << "gild_" << name << ' ' << value << '\n';
+    };
+    for (std::size_t i = 0; i < worker::METRIC_COUNT; ++i)
+    {
+        const auto &info = info_for(i);
+        write(std::string(info.name) + "_total", "counter", info.help,
+              snapshot.get(info.which));
+    }
+    write("jobs_queued", "gauge", "Jobs waiting for a thread",
+          snapshot.jobs_queued());
+    write("jobs_running", "gauge", "Jobs in SETUP, WORKING or TEARDOWN",
+          snapshot.jobs_running());
+    write("jobs_alive", "gauge", "Job objects not yet destroyed",
+          snapshot.jobs_alive());
+    write("worker_threads", "gauge", "Executor threads running",
+          snapshot.worker_threads());
+    return out.str();
+}
+
+pybind11::module &worker::bind_worker_metrics(pybind11::module &module)
+{
+    module.def(
+        "metrics",
+        [] {
+            const auto snapshot = get_metrics();
+            pybind11::dict result;
+            for (std::size_t i = 0; i < METRIC_COUNT; ++i)
+            {
+                const auto &info = info_for(i);
+                result[info.name] = snapshot.get(info.which);
+            }
+            result["jobs_queued"] = snapshot.jobs_queued();
+            result["jobs_running"] = snapshot.jobs_running();
+            result["jobs_alive"] = snapshot.jobs_alive();
+            result["worker_threads"] = snapshot.worker_threads();
+            return result;
+        },
+        R"pbdoc(
+Return a snapshot of the module's Job and thread metrics.
+
+Returns
+----------
+A dict of event counters since the module was loaded:
+'jobs_created', 'jobs_launched', 'jobs_dequeued',
+'jobs_completed', 'jobs_incomplete', 'jobs_aborted',
+'jobs_destroyed', 'threads_started', 'threads_exited',
+'jobs_rejected' and 'launches_throttled'; and gauges derived from
+them: 'jobs_queued', 'jobs_running', 'jobs_alive' and
+'worker_threads'.
+
+Each thread counts into its own shard and the shards are summed
+here.  They are read so that the gauges are never negative.
+)pbdoc");
+
+    module.def(
+        "metrics_prometheus", [] { return format_prometheus(get_metrics()); },
+        "Return metrics() in Prometheus text exposition format");
+
+    module.def(
+        "_time_add_metric",
+        [](std::size_t iterations) {
+            pybind11::gil_scoped_release release;
+            // Same code as add_metric(), but its own shards, so the
+            // real counters are left alone.
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < iterations; ++i)
+            {
+                increment_shard<counter_shard<1>>(0);
+            }
+            const auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration<double>(stop - start).count() /
+                   static_cast<double>(iterations ? iterations : 1);
+        },
+        pybind11::arg("iterations"),
+        "Benchmark hook: seconds per metric update.");
+    return module;
+}
@@ -0,0 +1,139 @@
+#ifndef WORKER_METRICS_H
+#define WORKER_METRICS_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "thread_shards.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace worker
+{
+    ///
+    /// \brief Monotonic event counters.
+    ///
+    /// Gauges (jobs queued, running or alive; worker threads) are the
+    /// difference of two counters, so each thread only ever adds to
+    /// its own shard.
+    ///
+    enum class metric
+    {
+        jobs_created,    ///< Job objects created
+        jobs_launched,   ///< Jobs handed to the executor
+        jobs_dequeued,   ///< Jobs that left state::not_started
+        jobs_completed,  ///< Jobs that finished in state::complete
+        jobs_incomplete, ///< Jobs that finished in state::incomplete
+        jobs_aborted,    ///< Unfinished jobs told to abort
+        jobs_destroyed,  ///< Job objects destroyed
+        threads_started, ///< Executor threads started
+        threads_exited,  ///< Executor threads exited
+        jobs_rejected,   ///< Jobs refused by admission control
+        launches_throttled ///< Launches that waited for admission
+    };
+
+    enum
+    {
+        METRIC_COUNT = 11
+    };
+
+    template <std::size_t Count> struct counter_shard
+    {
+        std::atomic<std::uint64_t> counts[Count];
+    };
+    typedef counter_shard<METRIC_COUNT> metrics_shard;
+
+    /**
+     * @brief Add to a counter in this thread's shard.  A few
+     *        nanoseconds: a thread-local lookup and a load/store pair.
+     */
+    template <typename Shard>
+    inline void increment_shard(std::size_t index, std::uint64_t amount = 1)
+    {
+        auto &count = thread_shards<Shard>::local().counts[index];
+        // Release, so a reader that sees an event also sees the
+        // events that led to it (see get_metrics()).
+        count.store(count.load(std::memory_order_relaxed) + amount,
+                    std::memory_order_release);
+    }
+
+    /**
+     * @brief Count an event ('amount' times).
+     */
+    inline void add_metric(metric which, std::uint64_t amount = 1)
+    {
+        increment_shard<metrics_shard>(static_cast<std::size_t>(which),
+                                       amount);
+    }
+
+    ///
+    /// \brief Totals over every thread's shard.
+    ///
+    struct metrics_snapshot
+    {
+        std::uint64_t counts[METRIC_COUNT];
+
+        std::uint64_t get(metric which) const
+        {
+            return counts[static_cast<std::size_t>(which)];
+        }
+        std::uint64_t jobs_queued() const;
+        std::uint64_t jobs_running() const;
+        std::uint64_t jobs_alive() const;
+        std::uint64_t worker_threads() const;
+    };
+
+    /**
+     * @brief Sum every counter.  Counters are read effects-first (a
+     *        job's end before its start), so no gauge goes negative.
+     */
+    metrics_snapshot get_metrics();
+
+    /**
+     * @brief The snapshot in Prometheus text exposition format.
+     */
+    std::string format_prometheus(const metrics_snapshot &snapshot);
+
+    ///
+    /// \brief Counts an executor thread for as long as it is in scope.
+    ///
+    class count_thread_at_scope
+    {
+    public:
+        count_thread_at_scope() { add_metric(metric::threads_started); }
+        ~count_thread_at_scope() { add_metric(metric::threads_exited); }
+
+        count_thread_at_scope(const count_thread_at_scope &) = delete;
+        count_thread_at_scope(count_thread_at_scope &&) = delete;
+        count_thread_at_scope &
+        operator=(const count_thread_at_scope &) = delete;
+        count_thread_at_scope &operator=(count_thread_at_scope &&) = delete;
+    };
+
+    pybind11::module &bind_worker_metrics(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_METRICS_H
@@ -0,0 +1,299 @@
+#ifndef WORKER_PARALLEL_RANGE_H
+#define WORKER_PARALLEL_RANGE_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "cancellation.h"
+#include "dispatcher.h"
+#include "executor.h"
+#include "job.h"
+#include "runnable.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief The work of a parallel range job: what to do with each
+    ///        chunk of the range, and how to combine the results.
+    ///
+    /// on_chunk() and reduce() are called from several threads at
+    /// once, so they must only read shared state.  reduce() combines
+    /// partial results in no particular order, so it must be
+    /// associative and commutative.
+    ///
+    template <typename T> class range_body : public pooled
+    {
+    protected:
+        range_body() = default;
+
+    public:
+        /// @brief The result of an empty range.
+        virtual T identity() const = 0;
+
+        /**
+         * @brief Process the items in [begin, end).
+         * @param cancellation Set if the job is aborted, or another
+         *        chunk fails.  Long chunks should check it.
+         * @return The result for the chunk.
+         */
+        virtual T on_chunk(std::int64_t begin, std::int64_t end,
+                           const cancellation_token &cancellation) = 0;
+
+        /// @brief Combine two results.
+        virtual T reduce(const T &left, const T &right) const = 0;
+
+        /**
+         * @brief Called on the job's thread with the result for the
+         *        whole range, unless the job was aborted or failed.
+         * @return True if the job completed successfully.
+         */
+        virtual bool on_result(const T &result) = 0;
+
+        range_body(const range_body &) = delete;
+        range_body(range_body &&) = delete;
+        range_body &operator=(const range_body &) = delete;
+        range_body &operator=(range_body &&) = delete;
+        virtual ~range_body() = default;
+    };
+
+    ///
+    /// \brief Splits a range across the executor's threads as one job.
+    ///
+    /// The job's thread submits a helper task for each other worker
+    /// thread, then works on the range itself.  Every thread claims
+    /// chunks from a shared index until the range is used up.  Chunks
+    /// start large and shrink as the range runs out (guided
+    /// scheduling), so threads finish close together without paying
+    /// for a claim per item.  Each thread reduces its own chunks, and
+    /// the partial results are reduced when it leaves.
+    ///
+    /// Helpers that only start once the range is used up (because the
+    /// executor was busy) do nothing, so the job never waits for a
+    /// free thread.  The job has one state machine like any other:
+    /// helpers don't touch it, and aborting the job stops every chunk.
+    ///
+    template <typename T> class parallel_range_runnable : public runnable
+    {
+    public:
+        /**
+         * @param begin The first item.
+         * @param end One past the last item.
+         * @param body What to do with the items.
+         * @param min_chunk The smallest chunk claimed (at least 1).
+         * @param progress_offset Added to the items done when
+         *        reporting progress, for a job that works through
+         *        several ranges in turn.
+         */
+        parallel_range_runnable(std::int64_t begin, std::int64_t end,
+                                std::unique_ptr<range_body<T>> body,
+                                std::int64_t min_chunk,
+                                std::int64_t progress_offset = 0)
+            : runnable(), m_begin(begin), m_end(std::max(begin, end)),
+              m_body(std::move(body)),
+              m_min_chunk(std::max<std::int64_t>(1, min_chunk)),
+              m_progress_offset(progress_offset)
+        {
+        }
+
+        virtual bool
+        on_working(const cancellation_token &cancellation) override
+        {
+            auto &executor = get_executor();
+            auto threads = executor.worker_count();
+            if (0 == threads)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            const auto job = current_job();
+            auto shared = std::make_shared<shared_t>(
+                *this, job ? *job : job::control_ptr_t(),
+                static_cast<std::int64_t>(threads));
+
+            // Stops every chunk, whether the job is aborted or a chunk
+            // fails.
+            stop_callback forward_abort(cancellation, [&shared] {
+                shared->stop.request_stop();
+            });
+
+            std::vector<executor::task_t> helpers;
+            for (std::size_t i = 1; i < threads; ++i)
+            {
+                helpers.emplace_back([shared] { shared->help(); });
+            }
+            try
+            {
+                executor.submit_many(helpers, job ? (*job)->schedule
+                                                  : task_schedule());
+            }
+            catch (...)
+            {
+                // Some helpers may have started, and they use 'this'.
+                shared->stop.request_stop();
+                shared->finish();
+                throw;
+            }
+
+            shared->work();
+            shared->finish();
+            if (shared->stop.stop_requested())
+            {
+                return false;
+            }
+            return m_body->on_result(shared->result);
+        }
+
+    private:
+        ///
+        /// \brief State shared with the helper tasks.  Helpers still
+        ///        queued after the job finishes keep it alive, but
+        ///        find it closed.
+        ///
+        struct shared_t
+        {
+            shared_t(parallel_range_runnable &owner_,
+                     job::control_ptr_t control_, std::int64_t threads_)
+                : owner(owner_), control(std::move(control_)),
+                  threads(threads_), next(owner_.m_begin),
+                  result(owner_.m_body->identity())
+            {
+            }
+
+            /// @brief Run on a helper thread, unless the job is done.
+            void help()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (closed)
+                    {
+                        return;
+                    }
+                    ++active;
+                }
+                // Report progress as the job, from this thread too.
+                if (control)
+                {
+                    progress_scope progress(control);
+                    work();
+                }
+                else
+                {
+                    work();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                --active;
+                left.notify_all();
+            }
+
+            /// @brief Claim and process chunks until none are left.
+            void work()
+            {
+                auto &body = *owner.m_body;
+                auto partial = body.identity();
+                std::int64_t begin = 0;
+                std::int64_t end = 0;
+                try
+                {
+                    while (!stop.stop_requested() && claim(begin, end))
+                    {
+                        partial = body.reduce(
+                            partial, body.on_chunk(begin, end, stop));
+                        // Under the lock, so the progress reported
+                        // from different threads never goes back.
+                        std::lock_guard<std::mutex> lock(mutex);
+                        done += end - begin;
+                        report_progress(owner.m_progress_offset + done);
+                    }
+                }
+                catch (...)
+                {
+                    // Handled as a failure, like runnable's hooks.
+                    stop.request_stop();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                result = body.reduce(result, partial);
+            }
+
+            /// @brief Take the next chunk, sized to leave the other
+            ///        threads about as much again.
+            bool claim(std::int64_t &begin, std::int64_t &end)
+            {
+                auto claimed = next.load(std::memory_order_relaxed);
+                std::int64_t size = 0;
+                do
+                {
+                    if (owner.m_end <= claimed)
+                    {
+                        return false;
+                    }
+                    const auto remaining = owner.m_end - claimed;
+                    size = std::min(
+                        remaining,
+                        std::max(owner.m_min_chunk, remaining / (2 * threads)));
+                } while (!next.compare_exchange_weak(
+                    claimed, claimed + size, std::memory_order_relaxed));
+                begin = claimed;
+                end = claimed + size;
+                return true;
+            }
+
+            /// @brief Keep helpers from starting, and wait for those
+            ///        that have.  Called by the job's thread.
+            void finish()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                closed = true;
+                left.wait(lock, [this] { return 0 == active; });
+            }
+
+            parallel_range_runnable &owner;
+            const job::control_ptr_t control;
+            const std::int64_t threads;
+            cancellation_token stop = {};
+            std::atomic<std::int64_t> next;
+
+            std::mutex mutex = {};
+            /// @brief Items processed, for progress.
+            std::int64_t done = 0;
+            std::condition_variable left = {};
+            bool closed = false;
+            std::size_t active = 0;
+            T result;
+        };
+
+        const std::int64_t m_begin;
+        const std::int64_t m_end;
+        std::unique_ptr<range_body<T>> m_body;
+        const std::int64_t m_min_chunk;
+        const std::int64_t m_progress_offset;
+    };
+
+} // end namespace worker
+
+#endif // WORKER_PARALLEL_RANGE_H
@@ -0,0 +1,533 @@
+#ifndef WORKER_PIPELINE_H
+#define WORKER_PIPELINE_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "cancellation.h"
+#include "input.h"
+#include "ring_buffer.h"
+#include "runnable.h"
+#include "stream_output.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Bounded queue carrying items from one pipeline stage to
+    ///        the next.
+    ///
+    /// A ring_buffer with overflow_policy::block, plus a way for each
+    /// side to wait on the other: write() blocks while the queue is
+    /// full (backpressure) and read() while it is empty.  Either one
+    /// spins briefly, then sleeps until the other side makes progress,
+    /// the producer closes the queue, or the pipeline is cancelled.
+    /// Items move in batches, with one index update per batch.
+    ///
+    template <typename T> class stage_queue
+    {
+    public:
+        stage_queue(std::size_t capacity, std::size_t batch_size)
+            : m_ring(capacity, overflow_policy::block),
+              m_batch_size(std::max<std::size_t>(1, batch_size))
+        {
+        }
+
+        /// @brief The number of items a stage should move at once.
+        std::size_t batch_size() const { return m_batch_size; }
+
+        /**
+         * @brief Add items, waiting for room as needed.  Producer only.
+         * @return False if cancelled before all of them were added.
+         */
+        bool write(const T *items, std::size_t count,
+                   const cancellation_token &cancellation)
+        {
+            while (true)
+            {
+                const auto added = m_ring.push_many(items, count);
+                if (0 < added)
+                {
+                    wake();
+                    items += added;
+                    count -= added;
+                }
+                if (0 == count)
+                {
+                    return true;
+                }
+                if (!wait(cancellation, [this] {
+                        return m_ring.size() < m_ring.capacity();
+                    }))
+                {
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * @brief Remove up to 'count' items, waiting for at least
+         *        one.  Consumer only.
+         * @return The number of items removed.  Zero once the queue
+         *        is closed and empty, or if cancelled.
+         */
+        std::size_t read(T *out, std::size_t count,
+                         const cancellation_token &cancellation)
+        {
+            while (true)
+            {
+                // Look before draining, so nothing written before
+                // close() is missed.
+                const auto closed = m_closed.load(std::memory_order_acquire);
+                const auto removed = m_ring.drain(out, count);
+                if (0 < removed)
+                {
+                    wake();
+                    return removed;
+                }
+                if (closed)
+                {
+                    return 0;
+                }
+                if (!wait(cancellation, [this] {
+                        return 0 < m_ring.size() ||
+                               m_closed.load(std::memory_order_acquire);
+                    }))
+                {
+                    return 0;
+                }
+            }
+        }
+
+        /// @brief Tell the consumer that no more items are coming.
+        void close()
+        {
+            m_closed.store(true, std::memory_order_release);
+            wake();
+        }
+
+        /// @brief Wake whichever side is asleep, if either is.
+        void wake()
+        {
+            // Pairs with the fence in wait(): either the sleeper sees
+            // our change, or we see the sleeper.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (0 < m_sleepers.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_condition.notify_all();
+            }
+        }
+
+        const ring_buffer<T> &queue() const { return m_ring; }
+
+        // Shared by address between two stages.
+        stage_queue(const stage_queue &) = delete;
+        stage_queue(stage_queue &&) = delete;
+        stage_queue &operator=(const stage_queue &) = delete;
+        stage_queue &operator=(stage_queue &&) = delete;
+
+    private:
+        enum
+        {
+            SPIN_COUNT = 64
+        };
+
+        template <typename Predicate>
+        bool wait(const cancellation_token &cancellation, Predicate ready)
+        {
+            // The other stage is usually only a batch behind.
+            for (int i = 0; i < SPIN_COUNT; ++i)
+            {
+                if (cancellation.stop_requested())
+                {
+                    return false;
+                }
+                if (ready())
+                {
+                    return true;
+                }
+                std::this_thread::yield();
+            }
+
+            m_sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                // The timeout is only a backstop.
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                    return cancellation.stop_requested() || ready();
+                });
+            }
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return !cancellation.stop_requested();
+        }
+
+        ring_buffer<T> m_ring;
+        const std::size_t m_batch_size;
+        std::atomic<bool> m_closed = {false};
+        std::atomic<int> m_sleepers = {0};
+        std::mutex m_mutex = {};
+        std::condition_variable m_condition = {};
+    };
+
+    ///
+    /// \brief Base class for one stage of a pipeline.
+    ///
+    /// Every stage runs at the same time as the others, on its own
+    /// thread, reading from the previous stage's queue and writing to
+    /// its own.
+    ///
+    template <typename T> class pipeline_stage : public pooled
+    {
+    protected:
+        pipeline_stage() = default;
+
+    public:
+        /**
+         * @brief Run the stage until its input runs out.
+         * @param input Items from the previous stage, or null for
+         *        the first stage (which produces items itself).
+         * @param output Where to write items for the next stage.
+         *        The pipeline closes it when this returns.
+         * @param cancellation Set if the pipeline is aborted, or if
+         *        another stage fails.  Reads and writes give up
+         *        once it is.
+         * @return True if the stage completed successfully.
+         */
+        virtual bool on_stage(stage_queue<T> *input, stage_queue<T> &output,
+                              const cancellation_token &cancellation) = 0;
+
+        pipeline_stage(const pipeline_stage &) = delete;
+        pipeline_stage(pipeline_stage &&) = delete;
+        pipeline_stage &operator=(const pipeline_stage &) = delete;
+        pipeline_stage &operator=(pipeline_stage &&) = delete;
+        virtual ~pipeline_stage() = default;
+    };
+
+    ///
+    /// \brief A stage that turns each batch it reads into a batch
+    ///        it writes.
+    ///
+    template <typename T> class batch_stage : public pipeline_stage<T>
+    {
+    protected:
+        batch_stage() = default;
+
+    public:
+        virtual bool on_stage(stage_queue<T> *input, stage_queue<T> &output,
+                              const cancellation_token &cancellation) final
+        {
+            if (!input)
+            {
+                throw std::logic_error("A batch stage can't come first");
+            }
+            std::vector<T> items(input->batch_size());
+            std::vector<T> results;
+            while (auto count =
+                       input->read(items.data(), items.size(), cancellation))
+            {
+                results.clear();
+                on_batch(items.data(), count, results);
+                if (!output.write(results.data(), results.size(),
+                                  cancellation))
+                {
+                    return false;
+                }
+            }
+            if (cancellation.stop_requested())
+            {
+                return false;
+            }
+            results.clear();
+            on_end(results);
+            return output.write(results.data(), results.size(), cancellation);
+        }
+
+        /// @brief Append the results for a batch of items to 'results'.
+        virtual void on_batch(const T *items, std::size_t count,
+                              std::vector<T> &results) = 0;
+
+        /// @brief Append anything held back until the input ended.
+        virtual void on_end(std::vector<T> &) {}
+    };
+
+    ///
+    /// \brief Describes a stage from Python.  Each launch creates a
+    ///        new pipeline_stage from it.
+    ///
+    template <typename T> struct stage_input
+    {
+        /// @brief Held while a field is read or written, as for input.
+        mutable field_mutex fields_mutex = {};
+
+        virtual ~stage_input() = default;
+        virtual std::unique_ptr<pipeline_stage<T>> create_stage() const = 0;
+        virtual std::string get_repr() const = 0;
+    };
+
+    ///
+    /// \brief Runs the stages of a pipeline as one job.
+    ///
+    /// Each stage gets a thread of its own, so a pipeline never waits
+    /// for a free executor thread part way through.  The job's thread
+    /// moves what the last stage writes into the job's output stream.
+    ///
+    template <typename T> class pipeline_runnable : public runnable
+    {
+    public:
+        typedef std::vector<std::unique_ptr<pipeline_stage<T>>> stages_t;
+
+        pipeline_runnable(stages_t stages, std::size_t queue_capacity,
+                          std::size_t batch_size,
+                          std::shared_ptr<stream_output<T>> output)
+            : runnable(), m_stages(std::move(stages)),
+              m_queue_capacity(queue_capacity), m_batch_size(batch_size),
+              m_output(std::move(output))
+        {
+        }
+
+        virtual bool
+        on_working(const cancellation_token &cancellation) override
+        {
+            // Stops every stage, whether the job is aborted or a
+            // stage fails.
+            cancellation_token stop;
+            std::vector<std::unique_ptr<stage_queue<T>>> queues;
+            for (std::size_t i = 0; i < m_stages.size(); ++i)
+            {
+                queues.push_back(std::make_unique<stage_queue<T>>(
+                    m_queue_capacity, m_batch_size));
+            }
+            stop_callback wake_queues(stop, [&queues] {
+                for (auto &queue : queues)
+                {
+                    queue->wake();
+                }
+            });
+            stop_callback forward_abort(cancellation,
+                                        [&stop] { stop.request_stop(); });
+
+            std::vector<char> succeeded(m_stages.size(), false);
+            auto run_stage = [&](std::size_t i) {
+                auto success = false;
+                try
+                {
+                    success = m_stages[i]->on_stage(
+                        0 == i ? nullptr : queues[i - 1].get(), *queues[i],
+                        stop);
+                }
+                catch (...)
+                {
+                    // Handled as a failure, like runnable's hooks.
+                }
+                queues[i]->close();
+                if (!success)
+                {
+                    stop.request_stop();
+                }
+                succeeded[i] = success;
+            };
+
+            std::vector<std::thread> threads;
+            try
+            {
+                for (std::size_t i = 0; i < m_stages.size(); ++i)
+                {
+                    threads.emplace_back(run_stage, i);
+                }
+            }
+            catch (...)
+            {
+                stop.request_stop();
+                for (auto &thread : threads)
+                {
+                    thread.join();
+                }
+                throw;
+            }
+
+            const auto delivered = deliver(*queues.back(), stop);
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+            return delivered && !stop.stop_requested() &&
+                   std::all_of(succeeded.begin(), succeeded.end(),
+                               [](char success) { return success; });
+        }
+
+    private:
+        /// @brief Move the last stage's items to the output stream.
+        bool deliver(stage_queue<T> &last, const cancellation_token &stop)
+        {
+            std::vector<T> items(last.batch_size());
+            while (auto count = last.read(items.data(), items.size(), stop))
+            {
+                if (count != m_output->push_many(items.data(), count, [&stop] {
+                        return !stop.stop_requested();
+                    }))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        stages_t m_stages;
+        std::size_t m_queue_capacity;
+        std::size_t m_batch_size;
+        std::shared_ptr<stream_output<T>> m_output;
+    };
+
+    ///
+    /// \brief Input for a job that runs a pipeline of stages.
+    ///
+    template <typename T> struct pipeline_input : public input
+    {
+        typedef std::vector<std::shared_ptr<stage_input<T>>> stages_t;
+
+        explicit pipeline_input(stages_t stages_) : stages(std::move(stages_))
+        {
+        }
+
+        stages_t stages;
+        std::size_t queue_capacity = 1024;
+        std::size_t batch_size = 64;
+        std::size_t stream_capacity = 1024;
+        overflow_policy overflow = overflow_policy::drop_oldest;
+
+        virtual job_data get_job_data() const override
+        {
+            const auto fields = copy_fields(*this);
+            if (fields.stages.empty())
+            {
+                throw std::invalid_argument("A pipeline needs a stage");
+            }
+            if (fields.queue_capacity < 1 || fields.stream_capacity < 1)
+            {
+                throw std::invalid_argument("Capacities must be at least 1");
+            }
+            typename pipeline_runnable<T>::stages_t created;
+            for (auto &stage : fields.stages)
+            {
+                if (!stage)
+                {
+                    throw std::invalid_argument("A stage can't be None");
+                }
+                created.push_back(stage->create_stage());
+            }
+            auto output_data = std::allocate_shared<stream_output<T>>(
+                pool_allocator<stream_output<T>>(), fields.stream_capacity,
+                fields.overflow);
+
+            job_data result = {};
+            result.python_input = pybind11::cast(fields);
+            result.python_output = pybind11::cast(output_data);
+            result.runnable_object = std::make_unique<pipeline_runnable<T>>(
+                std::move(created), fields.queue_capacity, fields.batch_size,
+                std::move(output_data));
+            return result;
+        }
+
+        virtual std::string get_repr() const override
+        {
+            return std::string("Pipeline") + get_str();
+        }
+
+        virtual std::string get_str() const override
+        {
+            const auto stages_now = get_field(*this, &pipeline_input::stages);
+            std::stringstream sstr;
+            sstr << "([";
+            for (std::size_t i = 0; i < stages_now.size(); ++i)
+            {
+                sstr << (0 == i ? "" : ", ")
+                     << (stages_now[i] ? stages_now[i]->get_repr() : "None");
+            }
+            sstr << "])";
+            return sstr.str();
+        }
+    };
+
+    ///
+    /// @brief Bind stage_input<T> and pipeline_input<T> to Python.
+    ///        stream_output<T> must already be bound.
+    ///
+    template <typename T>
+    pybind11::module &bind_pipeline(pybind11::module &module,
+                                    const char *stage_name,
+                                    const char *pipeline_name)
+    {
+        typedef stage_input<T> stage_t;
+        typedef pipeline_input<T> pipeline_t;
+
+        pybind11::class_<stage_t, std::shared_ptr<stage_t>> stage(
+            module, stage_name, R"pbdoc(
+Base class for the stages of a Pipeline.
+)pbdoc");
+        stage.def("__repr__", &stage_t::get_repr);
+
+        pybind11::class_<pipeline_t, input> obj(module, pipeline_name, R"pbdoc(
+Asynchronous C++ job that runs stages connected by bounded queues.
+
+Every stage runs at the same time, on its own thread, and passes
+batches of items to the next stage without going through Python.
+When a queue is full, the stage writing to it waits (backpressure).
+The items written by the last stage go to the Job's output, which is
+drained like a Count's.
+
+Aborting the Job cancels every stage.  If any stage fails, the
+others are cancelled and the Job ends INCOMPLETE.
+)pbdoc");
+        obj.def(pybind11::init<typename pipeline_t::stages_t>(),
+                pybind11::arg("stages"));
+        def_field(obj, "stages", &pipeline_t::stages,
+                  "The stages, first (the producer) to last");
+        def_field(obj, "queue_capacity", &pipeline_t::queue_capacity,
+                  "The most items held between two stages");
+        def_field(obj, "batch_size", &pipeline_t::batch_size,
+                  "The most items a stage reads at once");
+        def_field(obj, "stream_capacity", &pipeline_t::stream_capacity,
+                  "The most results held for output.drain()");
+        def_field(obj, "overflow", &pipeline_t::overflow,
+                  "The OverflowPolicy used when output.drain() falls behind");
+        return module;
+    }
+
+    pybind11::module &bind_worker_pipeline(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_PIPELINE_H
@@ -0,0 +1,258 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "pool_allocator.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+    enum
+    {
+        /// @brief 64, 128, ... POOL_MAX_BLOCK_SIZE
+        SIZE_CLASSES = 7,
+        /// @brief Blocks moved between a thread and the shared list,
+        ///        and blocks per slab.
+        BATCH = 32
+    };
+
+    static_assert(worker::POOL_BLOCK_ALIGNMENT << (SIZE_CLASSES - 1) ==
+                      worker::POOL_MAX_BLOCK_SIZE,
+                  "size classes don't match the maximum block size");
+
+    struct free_block
+    {
+        free_block *next;
+    };
+
+    std::size_t size_class(std::size_t size)
+    {
+        std::size_t result = 0;
+        for (std::size_t block = worker::POOL_BLOCK_ALIGNMENT; block < size;
+             block <<= 1)
+        {
+            ++result;
+        }
+        return result;
+    }
+
+    std::size_t block_size(std::size_t size_class)
+    {
+        return static_cast<std::size_t>(worker::POOL_BLOCK_ALIGNMENT)
+               << size_class;
+    }
+
+    struct shared_t
+    {
+        std::mutex mutex[SIZE_CLASSES];
+        free_block *head[SIZE_CLASSES] = {};
+
+        std::atomic<std::uint64_t> system_allocations = {0};
+        std::atomic<std::uint64_t> system_bytes = {0};
+        std::atomic<std::uint64_t> oversize_allocations = {0};
+    };
+
+    shared_t &shared()
+    {
+        // Deliberately leaked.  Threads hand their cached blocks back
+        // when they exit, which may be after static destruction.
+        static auto result = new shared_t();
+        return *result;
+    }
+
+    struct thread_cache_t
+    {
+        free_block *head[SIZE_CLASSES] = {};
+        std::size_t count[SIZE_CLASSES] = {};
+
+        /**
+         * @brief Move 'blocks' blocks to the shared free list.
+         */
+        void give_back(std::size_t size_class, std::size_t blocks)
+        {
+            if (0 == blocks)
+            {
+                return;
+            }
+            auto first = head[size_class];
+            auto last = first;
+            for (std::size_t i = 1; i < blocks; ++i)
+            {
+                last = last->next;
+            }
+            head[size_class] = last->next;
+            count[size_class] -= blocks;
+
+            auto &pool = shared();
+            std::lock_guard<std::mutex> lock(pool.mutex[size_class]);
+            last->next = pool.head[size_class];
+            pool.head[size_class] = first;
+        }
+
+        /**
+         * @brief Take a batch of blocks from the shared free list,
+         *        or from a new slab if the shared list is empty.
+         */
+        void refill(std::size_t size_class)
+        {
+            auto &pool = shared();
+            {
+                std::lock_guard<std::mutex> lock(pool.mutex[size_class]);
+                for (std::size_t i = 0; i < BATCH; ++i)
+                {
+                    auto block = pool.head[size_class];
+                    if (nullptr == block)
+                    {
+                        break;
+                    }
+                    pool.head[size_class] = block->next;
+                    block->next = head[size_class];
+                    head[size_class] = block;
+                    ++count[size_class];
+                }
+            }
+            if (0 != count[size_class])
+            {
+                return;
+            }
+
+            const auto size = block_size(size_class);
+            const auto bytes = BATCH * size + worker::POOL_BLOCK_ALIGNMENT;
+            auto slab = reinterpret_cast<std::uintptr_t>(::operator new(bytes));
+            const auto mask = static_cast<std::uintptr_t>(
+                worker::POOL_BLOCK_ALIGNMENT - 1);
+            slab = (slab + mask) & ~mask;
+            for (std::size_t i = 0; i < BATCH; ++i)
+            {
+                auto block = reinterpret_cast<free_block *>(slab + i * size);
+                block->next = head[size_class];
+                head[size_class] = block;
+            }
+            count[size_class] = BATCH;
+            pool.system_allocations.fetch_add(1, std::memory_order_relaxed);
+            pool.system_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        thread_cache_t() = default;
+        thread_cache_t(const thread_cache_t &) = delete;
+        thread_cache_t(thread_cache_t &&) = delete;
+        thread_cache_t &operator=(const thread_cache_t &) = delete;
+        thread_cache_t &operator=(thread_cache_t &&) = delete;
+        ~thread_cache_t()
+        {
+            for (std::size_t i = 0; i < SIZE_CLASSES; ++i)
+            {
+                give_back(i, count[i]);
+            }
+        }
+    };
+
+    thread_local thread_cache_t thread_cache;
+}
+
+void *worker::pool_allocate(std::size_t size)
+{
+    if (POOL_MAX_BLOCK_SIZE < size)
+    {
+        auto &pool = shared();
+        pool.oversize_allocations.fetch_add(1, std::memory_order_relaxed);
+        pool.system_allocations.fetch_add(1, std::memory_order_relaxed);
+        pool.system_bytes.fetch_add(size, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    const auto cls = size_class(size);
+    auto &cache = thread_cache;
+    if (nullptr == cache.head[cls])
+    {
+        cache.refill(cls);
+    }
+    auto block = cache.head[cls];
+    cache.head[cls] = block->next;
+    --cache.count[cls];
+    return block;
+}
+
+void worker::pool_deallocate(void *block, std::size_t size) noexcept
+{
+    if (nullptr == block)
+    {
+        return;
+    }
+    if (POOL_MAX_BLOCK_SIZE < size)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    const auto cls = size_class(size);
+    auto &cache = thread_cache;
+    auto free = static_cast<free_block *>(block);
+    free->next = cache.head[cls];
+    cache.head[cls] = free;
+    if (2 * BATCH < ++cache.count[cls])
+    {
+        // Threads that mostly free (like workers finishing jobs that
+        // Python allocated) pass the surplus back.
+        cache.give_back(cls, BATCH);
+    }
+}
+
+worker::pool_allocation_stats worker::get_pool_allocation_stats()
+{
+    auto &pool = shared();
+    pool_allocation_stats result = {};
+    result.system_allocations = pool.system_allocations;
+    result.system_bytes = pool.system_bytes;
+    result.oversize_allocations = pool.oversize_allocations;
+    return result;
+}
+
+pybind11::module &
+worker::bind_worker_pool_allocator(pybind11::module &module)
+{
+    module.def(
+        "allocation_stats",
+        [] {
+            const auto stats = get_pool_allocation_stats();
+            pybind11::dict result;
+            result["system_allocations"] = stats.system_allocations;
+            result["system_bytes"] = stats.system_bytes;
+            result["oversize_allocations"] = stats.oversize_allocations;
+            return result;
+        },
+        R"pbdoc(
+Return counters for memory taken from the system by the per-job pools.
+
+Jobs, their control blocks, outputs and runnables are recycled
+through pools.  Once the pools are warm, launching more Jobs should
+not change these counters.
+
+Returns
+----------
+A dict with 'system_allocations', 'system_bytes' and
+'oversize_allocations'.
+)pbdoc");
+    return module;
+}
@@ -0,0 +1,140 @@
+#ifndef WORKER_POOL_ALLOCATOR_H
+#define WORKER_POOL_ALLOCATOR_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace worker
+{
+    enum
+    {
+        CACHE_LINE_SIZE = 64,
+        /// @brief Pool blocks are aligned (and sized) to cache lines.
+        POOL_BLOCK_ALIGNMENT = CACHE_LINE_SIZE,
+        /// @brief Larger requests go straight to operator new.
+        POOL_MAX_BLOCK_SIZE = 4096
+    };
+
+    ///
+    /// \brief Counters for memory the pools took from the system.
+    ///
+    /// Once the pools are warmed up, launching and finishing jobs
+    /// recycles blocks and these stop changing.
+    ///
+    struct pool_allocation_stats
+    {
+        std::uint64_t system_allocations; ///< Slabs plus oversize blocks
+        std::uint64_t system_bytes;       ///< Bytes in those allocations
+        std::uint64_t oversize_allocations; ///< Requests over the max size
+    };
+
+    /**
+     * @brief Allocate a block of at least 'size' bytes.
+     *
+     *        Blocks up to POOL_MAX_BLOCK_SIZE come from per-thread
+     *        free lists, refilled in batches from a shared free list,
+     *        which in turn is refilled with slabs from the system.
+     *        Blocks are never returned to the system.
+     */
+    void *pool_allocate(std::size_t size);
+
+    /**
+     * @brief Return a block from pool_allocate() with the same size.
+     *
+     *        Any thread may free a block, not just the one that
+     *        allocated it.
+     */
+    void pool_deallocate(void *block, std::size_t size) noexcept;
+
+    /**
+     * @brief Return a snapshot of the counters.
+     */
+    pool_allocation_stats get_pool_allocation_stats();
+
+    ///
+    /// \brief Standard allocator over pool_allocate(), for use with
+    ///        std::allocate_shared().
+    ///
+    template <typename T> struct pool_allocator
+    {
+        typedef T value_type;
+
+        pool_allocator() = default;
+        template <typename U> pool_allocator(const pool_allocator<U> &) {}
+
+        T *allocate(std::size_t count)
+        {
+            static_assert(POOL_BLOCK_ALIGNMENT % alignof(T) == 0,
+                          "pool blocks are not aligned enough");
+            return static_cast<T *>(pool_allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T *pointer, std::size_t count) noexcept
+        {
+            pool_deallocate(pointer, count * sizeof(T));
+        }
+
+        template <typename U> bool operator==(const pool_allocator<U> &) const
+        {
+            return true;
+        }
+        template <typename U> bool operator!=(const pool_allocator<U> &) const
+        {
+            return false;
+        }
+    };
+
+    ///
+    /// \brief Base class that gives derived classes pooled new/delete.
+    ///
+    /// The sized operator delete receives the size of the most derived
+    /// class (given a virtual destructor), so one base serves a whole
+    /// class hierarchy.
+    ///
+    struct pooled
+    {
+        static void *operator new(std::size_t size)
+        {
+            return pool_allocate(size);
+        }
+        static void operator delete(void *block, std::size_t size) noexcept
+        {
+            pool_deallocate(block, size);
+        }
+
+    protected:
+        // Only a mixin, never deleted through a pointer to pooled.
+        pooled() = default;
+        ~pooled() = default;
+    };
+
+    pybind11::module &bind_worker_pool_allocator(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_POOL_ALLOCATOR_H
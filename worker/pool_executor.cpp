@@ -0,0 +1,326 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "pool_executor.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+worker::pool_executor::pool_executor(std::size_t worker_count)
+{
+    set_worker_count(worker_count);
+}
+
+worker::pool_executor::~pool_executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    std::lock_guard<std::mutex> resize_lock(m_resize_mutex);
+    for (auto &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+bool worker::pool_executor::submit(task_t task, const task_schedule &schedule)
+{
+    auto dispatched = false;
+    auto shared = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &queue = queue_for(schedule);
+        shared = &queue == &m_queue;
+        // Only count on an idle worker that no other waiting task
+        // could take first.  Reserve it by handing the task over
+        // directly, so a task with a higher priority can't get it.
+        dispatched =
+            shared && m_handoff.size() + m_queue.size() + m_node_tasks < m_idle;
+        if (dispatched)
+        {
+            m_handoff.push_back(std::move(task));
+        }
+        else
+        {
+            queue.push(std::move(task), schedule);
+            m_node_tasks += shared ? 0 : 1;
+        }
+    }
+    if (shared)
+    {
+        m_wake.notify_one();
+    }
+    else
+    {
+        // Only workers on the node will take it.
+        m_wake.notify_all();
+    }
+    return dispatched;
+}
+
+void worker::pool_executor::submit_many(std::vector<task_t> &tasks,
+                                        const task_schedule &schedule)
+{
+    auto shared = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &queue = queue_for(schedule);
+        shared = &queue == &m_queue;
+        for (auto &task : tasks)
+        {
+            queue.push(std::move(task), schedule);
+        }
+        m_node_tasks += shared ? 0 : tasks.size();
+    }
+    if (1 == tasks.size() && shared)
+    {
+        m_wake.notify_one();
+    }
+    else if (!tasks.empty())
+    {
+        m_wake.notify_all();
+    }
+}
+
+std::size_t worker::pool_executor::worker_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_target;
+}
+
+void worker::pool_executor::set_worker_count(std::size_t count)
+{
+    if (0 == count)
+    {
+        throw std::invalid_argument("worker count must be at least 1");
+    }
+
+    std::lock_guard<std::mutex> resize_lock(m_resize_mutex);
+    std::vector<placement> places;
+    for (auto i = m_threads.size(); i < count; ++i)
+    {
+        places.push_back(get_placement(i));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_target = count;
+        if (m_nodes.size() < count)
+        {
+            m_nodes.resize(count, -1);
+            m_waiting.resize(count, 0);
+        }
+        for (auto i = count; i < m_threads.size(); ++i)
+        {
+            // Retired workers are no longer idle, though they still
+            // start any tasks already handed to them (see worker_main).
+            if (m_waiting[i])
+            {
+                m_waiting[i] = 0;
+                --m_idle;
+            }
+        }
+        for (std::size_t i = 0; i < places.size(); ++i)
+        {
+            m_nodes[m_threads.size() + i] = places[i].node;
+        }
+        count_node_workers();
+    }
+
+    if (count < m_threads.size())
+    {
+        // Retired workers notice the new target and exit once they
+        // are done with whatever they are running now.
+        m_wake.notify_all();
+        for (auto i = count; i < m_threads.size(); ++i)
+        {
+            m_threads[i].join();
+        }
+        m_threads.resize(count);
+    }
+    else
+    {
+        for (const auto &where : places)
+        {
+            m_threads.emplace_back(&pool_executor::worker_main, this,
+                                   m_threads.size());
+            place_thread(m_threads.back(), where);
+        }
+    }
+}
+
+void worker::pool_executor::place_workers()
+{
+    std::lock_guard<std::mutex> resize_lock(m_resize_mutex);
+    std::vector<placement> places;
+    for (std::size_t i = 0; i < m_threads.size(); ++i)
+    {
+        places.push_back(get_placement(i));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::size_t i = 0; i < places.size(); ++i)
+        {
+            m_nodes[i] = places[i].node;
+        }
+        count_node_workers();
+    }
+    for (std::size_t i = 0; i < places.size(); ++i)
+    {
+        place_thread(m_threads[i], places[i]);
+    }
+    // A node may have lost its workers, leaving tasks for anyone.
+    m_wake.notify_all();
+}
+
+worker::task_queue &
+worker::pool_executor::queue_for(const task_schedule &schedule)
+{
+    const auto node = static_cast<std::size_t>(schedule.node);
+    if (0 <= schedule.node && node < m_node_workers.size() &&
+        0 < m_node_workers[node])
+    {
+        return *m_node_queues[node];
+    }
+    return m_queue;
+}
+
+worker::task_queue *worker::pool_executor::find_queue(std::size_t index)
+{
+    const auto node = m_nodes[index];
+    if (0 <= node && !m_node_queues[static_cast<std::size_t>(node)]->empty())
+    {
+        return m_node_queues[static_cast<std::size_t>(node)].get();
+    }
+    if (!m_queue.empty())
+    {
+        return &m_queue;
+    }
+    if (0 < m_node_tasks)
+    {
+        // Tasks left waiting for a node that has lost its workers.
+        for (std::size_t i = 0; i < m_node_queues.size(); ++i)
+        {
+            if (0 == m_node_workers[i] && !m_node_queues[i]->empty())
+            {
+                return m_node_queues[i].get();
+            }
+        }
+    }
+    return nullptr;
+}
+
+void worker::pool_executor::count_node_workers()
+{
+    auto node_count = m_node_queues.size();
+    for (std::size_t i = 0; i < m_target; ++i)
+    {
+        node_count =
+            std::max(node_count, static_cast<std::size_t>(m_nodes[i] + 1));
+    }
+    // Queues are never removed, since they may hold tasks.
+    while (m_node_queues.size() < node_count)
+    {
+        m_node_queues.emplace_back(new task_queue());
+    }
+    m_node_workers.assign(node_count, 0);
+    for (std::size_t i = 0; i < m_target; ++i)
+    {
+        if (0 <= m_nodes[i])
+        {
+            ++m_node_workers[static_cast<std::size_t>(m_nodes[i])];
+        }
+    }
+}
+
+void worker::pool_executor::worker_main(std::size_t index)
+{
+    count_thread_at_scope counted;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        if (index < m_target)
+        {
+            m_waiting[index] = 1;
+            ++m_idle;
+        }
+        m_wake.wait(lock, [&] {
+            return m_stop || index >= m_target || !m_handoff.empty() ||
+                   nullptr != find_queue(index);
+        });
+        if (m_waiting[index])
+        {
+            m_waiting[index] = 0;
+            --m_idle;
+        }
+
+        // A retired worker stays while tasks handed over to it (when it
+        // was idle) outnumber the idle workers left to start them.
+        if (index >= m_target && m_handoff.size() <= m_idle)
+        {
+            if (0 < m_node_tasks || !m_handoff.empty())
+            {
+                m_wake.notify_all();
+            }
+            else if (!m_queue.empty())
+            {
+                // We may have consumed the wakeup meant for a task.
+                m_wake.notify_one();
+            }
+            break;
+        }
+
+        task_t task;
+        if (!m_handoff.empty())
+        {
+            task = std::move(m_handoff.front());
+            m_handoff.pop_front();
+        }
+        else
+        {
+            auto queue = find_queue(index);
+            if (nullptr == queue)
+            {
+                // Only possible when stopping.
+                break;
+            }
+
+            task = queue->pop();
+            if (&m_queue != queue)
+            {
+                --m_node_tasks;
+                if (!m_queue.empty())
+                {
+                    // We may have consumed the wakeup meant for a task.
+                    m_wake.notify_one();
+                }
+            }
+        }
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
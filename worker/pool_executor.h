@@ -0,0 +1,111 @@
+#ifndef WORKER_POOL_EXECUTOR_H
+#define WORKER_POOL_EXECUTOR_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./executor.h"
+#include "./task_queue.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Executor with a fixed number of long-lived threads.
+    ///
+    /// All workers take tasks from one shared queue, so a task
+    /// submitted while every worker is busy waits (in state
+    /// not_started) until a worker becomes free.  Waiting tasks are
+    /// taken in priority and deadline order (see task_queue).
+    ///
+    /// A task that asks for a NUMA node waits in that node's own
+    /// queue, which workers placed on the node serve before the shared
+    /// one.  If no worker is on the node, the task goes to the shared
+    /// queue.
+    ///
+    /// submit() only reports a task as dispatched after reserving an
+    /// idle worker for it: the task skips the queues and waits in
+    /// m_handoff, which workers always serve first.
+    ///
+    class pool_executor final : public executor
+    {
+    public:
+        explicit pool_executor(std::size_t worker_count);
+        ~pool_executor();
+
+        virtual bool submit(task_t task,
+                            const task_schedule &schedule) override;
+        virtual void submit_many(std::vector<task_t> &tasks,
+                                 const task_schedule &schedule) override;
+        virtual std::size_t worker_count() const override;
+        virtual void set_worker_count(std::size_t count) override;
+        virtual void place_workers() override;
+
+    private:
+        void worker_main(std::size_t index);
+
+        /// @brief The queue for a new task.  Caller holds m_mutex.
+        task_queue &queue_for(const task_schedule &schedule);
+        /// @brief The queue worker 'index' should take a task from,
+        ///        or nullptr.  Caller holds m_mutex.
+        task_queue *find_queue(std::size_t index);
+        /// @brief Recount m_node_workers.  Caller holds m_mutex.
+        void count_node_workers();
+
+        mutable std::mutex m_mutex = {};
+        std::condition_variable m_wake = {};
+        task_queue m_queue = {};
+        /// @brief Tasks that asked for a NUMA node, by node.
+        std::vector<std::unique_ptr<task_queue>> m_node_queues = {};
+        /// @brief The NUMA node of each worker, or -1.
+        std::vector<int> m_nodes = {};
+        /// @brief The workers (below m_target) on each node.
+        std::vector<std::size_t> m_node_workers = {};
+        /// @brief The tasks in m_node_queues.
+        std::size_t m_node_tasks = 0;
+
+        /// @brief Tasks with a reserved worker (see submit()).
+        std::deque<task_t> m_handoff = {};
+        /// @brief Whether each worker is counted in m_idle.
+        std::vector<char> m_waiting = {};
+
+        /// @brief Workers with an index >= m_target exit.
+        std::size_t m_target = 0;
+        /// @brief Workers (below m_target) waiting for something to
+        ///        do.  Each task in m_handoff has reserved one of them.
+        std::size_t m_idle = 0;
+        bool m_stop = false;
+
+        /// @brief Serializes set_worker_count() (guards m_threads).
+        std::mutex m_resize_mutex = {};
+        std::vector<std::thread> m_threads = {};
+    };
+
+} // end namespace worker
+
+#endif // WORKER_POOL_EXECUTOR_H
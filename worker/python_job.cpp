@@ -0,0 +1,259 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "python_job.h"
+#include "runnable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    ///
+    /// \brief Lets Python classes override the python_job hooks.
+    ///
+    /// Each override acquires the GIL for the call only.
+    ///
+    class python_job_trampoline : public worker::python_job
+    {
+    public:
+        using worker::python_job::python_job;
+
+        virtual bool on_setup(const token_ptr_t &cancellation) override
+        {
+            PYBIND11_OVERLOAD(bool, worker::python_job, on_setup,
+                              cancellation);
+        }
+
+        virtual bool on_working(const token_ptr_t &cancellation) override
+        {
+            PYBIND11_OVERLOAD(bool, worker::python_job, on_working,
+                              cancellation);
+        }
+
+        virtual bool on_teardown(const token_ptr_t &cancellation) override
+        {
+            PYBIND11_OVERLOAD(bool, worker::python_job, on_teardown,
+                              cancellation);
+        }
+
+        virtual bool on_step() override
+        {
+            PYBIND11_OVERLOAD_PURE(bool, worker::python_job, on_step, );
+        }
+    };
+
+    ///
+    /// \brief Runs a python_job's hooks on the worker thread.
+    ///
+    /// Holds no reference to the Python object: the Job does, as its
+    /// input, and doesn't let go until the job is done.  So nothing
+    /// here needs the GIL once the hooks have returned.  Passes the
+    /// hooks a token of their own, chained to the job's, since Python
+    /// may keep it after the job is gone.
+    ///
+    class python_runnable : public worker::runnable
+    {
+    public:
+        explicit python_runnable(worker::python_job &job)
+            : worker::runnable(), m_job(job),
+              m_token(std::make_shared<worker::cancellation_token>())
+        {
+        }
+
+        virtual bool
+        on_setup(const worker::cancellation_token &cancellation) override
+        {
+            chain(cancellation);
+            return m_job.on_setup(m_token);
+        }
+
+        virtual bool
+        on_working(const worker::cancellation_token &cancellation) override
+        {
+            chain(cancellation);
+            return m_job.on_working(m_token);
+        }
+
+        virtual bool
+        on_teardown(const worker::cancellation_token &cancellation) override
+        {
+            chain(cancellation);
+            return m_job.on_teardown(m_token);
+        }
+
+        python_runnable(const python_runnable &) = delete;
+        python_runnable(python_runnable &&) = delete;
+        python_runnable &operator=(const python_runnable &) = delete;
+        python_runnable &operator=(python_runnable &&) = delete;
+
+    private:
+        void chain(const worker::cancellation_token &cancellation)
+        {
+            if (!m_chain)
+            {
+                auto token = m_token;
+                m_chain = std::make_unique<worker::stop_callback>(
+                    cancellation, [token] { token->request_stop(); });
+            }
+        }
+
+        worker::python_job &m_job;
+        const worker::python_job::token_ptr_t m_token;
+        // Declared last, so it is deregistered first.
+        std::unique_ptr<worker::stop_callback> m_chain = {};
+    };
+}
+
+bool worker::python_job::on_setup(const token_ptr_t &) { return true; }
+
+bool worker::python_job::on_working(const token_ptr_t &cancellation)
+{
+    while (!cancellation->stop_requested())
+    {
+        // One acquisition of the GIL for a whole chunk of steps.
+        pybind11::gil_scoped_acquire gil;
+        const auto chunk = get_field(*this, &python_job::chunk_size);
+        for (auto steps = std::max(chunk, 1); 0 < steps; --steps)
+        {
+            if (!on_step())
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool worker::python_job::on_teardown(const token_ptr_t &) { return true; }
+
+worker::job_data worker::python_job::get_job_data() const
+{
+    if (get_field(*this, &python_job::chunk_size) < 1)
+    {
+        throw std::invalid_argument("chunk_size must be at least 1");
+    }
+    // The object Python already has, not a copy: hooks keep their
+    // state on it.
+    auto &job = const_cast<python_job &>(*this);
+    auto self = pybind11::cast(&job, pybind11::return_value_policy::reference);
+
+    worker::job_data result = {};
+    result.python_input = self;
+    result.python_output = self;
+    result.runnable_object = std::make_unique<python_runnable>(job);
+    return result;
+}
+
+std::string worker::python_job::get_repr() const
+{
+    auto self = pybind11::cast(const_cast<python_job *>(this),
+                               pybind11::return_value_policy::reference);
+    return self.attr("__class__").attr("__name__").cast<std::string>() +
+           get_str();
+}
+
+std::string worker::python_job::get_str() const
+{
+    std::stringstream sstr;
+    sstr << "(chunk_size=" << get_field(*this, &python_job::chunk_size)
+         << ")";
+    return sstr.str();
+}
+
+pybind11::module &worker::bind_worker_python_job(pybind11::module &module)
+{
+    pybind11::class_<cancellation_token, std::shared_ptr<cancellation_token>>
+        token(module, "CancellationToken", R"pbdoc(
+Passed to the hooks of a PythonJob.  Set once the Job is aborted.
+)pbdoc");
+    token.def_property_readonly("stop_requested",
+                                &cancellation_token::stop_requested,
+                                "True once the Job has been aborted");
+    token.def_property_readonly(
+        "keep_working",
+        [](const cancellation_token &cancellation) {
+            return !cancellation.stop_requested();
+        },
+        "False once the Job has been aborted");
+    token.def(
+        "sleep_for",
+        [](const cancellation_token &cancellation,
+           std::chrono::duration<double> duration) {
+            pybind11::gil_scoped_release release;
+            return cancellation.sleep_for(duration);
+        },
+        R"pbdoc(
+Sleep, with the GIL released, unless the Job is aborted first.
+
+Parameters
+----------
+duration: The time to sleep, as a number of seconds (fractions
+  allowed) or a datetime.timedelta.
+
+Returns
+----------
+True if the whole duration passed, False if the Job was aborted.
+)pbdoc",
+        pybind11::arg("duration"));
+
+    pybind11::class_<python_job, input, python_job_trampoline> obj(
+        module, "PythonJob", R"pbdoc(
+Base class for Jobs written in Python.
+
+Derive from it, call super().__init__(), and override either:
+
+on_working(self, token):
+
+  Do the work, returning True if it was completed.  Check
+  token.keep_working (or use token.sleep_for()) to notice an abort.
+
+on_step(self):
+
+  Do one step of the work, returning True while there is more to
+  do.  The default on_working() calls it .chunk_size times for each
+  acquisition of the GIL, and checks for an abort, without the GIL,
+  in between.
+
+on_setup(self, token) and on_teardown(self, token) may also be
+overridden, and return True on success.  A hook that raises fails
+the Job, as if it returned False.
+
+Each hook runs on the Job's worker thread, holding the GIL only for
+the call, so the Job runs alongside other Python threads rather than
+in parallel with them.  On a free-threaded build of Python (without
+a GIL) the hooks run in parallel, so guard any state they share with
+other threads.  The PythonJob is both the Job's input and its
+output: keep results on self.  Launch an instance only once at a time.
+)pbdoc");
+    obj.def(pybind11::init<>());
+    def_field(obj, "chunk_size", &python_job::chunk_size,
+              "Steps taken for each acquisition of the GIL");
+    obj.def("on_setup", &python_job::on_setup, pybind11::arg("token"));
+    obj.def("on_working", &python_job::on_working, pybind11::arg("token"));
+    obj.def("on_teardown", &python_job::on_teardown, pybind11::arg("token"));
+    obj.def("on_step", &python_job::on_step);
+    return module;
+}
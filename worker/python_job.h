@@ -0,0 +1,95 @@
+#ifndef WORKER_PYTHON_JOB_H
+#define WORKER_PYTHON_JOB_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "cancellation.h"
+#include "input.h"
+
+#include <memory>
+#include <string>
+
+namespace worker
+{
+    ///
+    /// \brief Input for a job whose hooks are written in Python.
+    ///
+    /// Python classes derive from it (as PythonJob) and override
+    /// on_working(), or on_step() to have the work done in chunks,
+    /// and optionally on_setup() and on_teardown().  The worker thread
+    /// holds the GIL only while one of those runs, and checks for a
+    /// stop between chunks without it.  The Python object is both the
+    /// job's input and its output, so hooks can leave results on it.
+    ///
+    class python_job : public input
+    {
+    public:
+        typedef std::shared_ptr<cancellation_token> token_ptr_t;
+
+        /// @brief Steps taken by the default on_working() for each
+        ///        acquisition of the GIL.  Guarded by fields_mutex.
+        int chunk_size = 1;
+
+        /**
+         * @brief Called without the GIL.  Overrides run with it.
+         * @param cancellation Set if the job is aborted.  Shared, so
+         *        that Python may keep hold of it.
+         * @return True if setup was successful.
+         */
+        virtual bool on_setup(const token_ptr_t &cancellation);
+
+        /**
+         * @brief Called without the GIL.  Overrides run with it.
+         *
+         *        By default, calls on_step() until it returns false,
+         *        'chunk_size' times for each acquisition of the GIL,
+         *        checking for a stop in between.
+         *
+         * @return True if the work was completed, false if aborted.
+         */
+        virtual bool on_working(const token_ptr_t &cancellation);
+
+        /**
+         * @brief Called without the GIL.  Overrides run with it.
+         * @return True if teardown was successful.
+         */
+        virtual bool on_teardown(const token_ptr_t &cancellation);
+
+        /**
+         * @brief Take one step of the work.  Called with the GIL held.
+         * @return True if there is more work to do.
+         */
+        virtual bool on_step() = 0;
+
+        /// @brief Needs the GIL.
+        virtual job_data get_job_data() const override;
+        virtual std::string get_repr() const override;
+        virtual std::string get_str() const override;
+    };
+
+    pybind11::module &bind_worker_python_job(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_PYTHON_JOB_H
@@ -0,0 +1,608 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "reduce.h"
+#include "parallel_range.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    /// @brief Items scanned between checks for an abort.
+    const std::size_t BLOCK_SIZE = 1 << 16;
+
+    template <typename E> struct partial_t
+    {
+        worker::block_stats<E> stats = {};
+        std::vector<std::uint64_t> bins = {};
+    };
+
+    ///
+    /// \brief One pass over the buffer: stats, a histogram, or both.
+    ///
+    template <typename E>
+    class reduce_body : public worker::range_body<partial_t<E>>
+    {
+    public:
+        struct pass_t
+        {
+            bool stats;
+            std::size_t bins;
+            double low;
+            double high;
+        };
+
+        reduce_body(const E *data, pass_t pass, worker::simd_level level,
+                    worker::reduce_output &output, partial_t<E> &result)
+            : worker::range_body<partial_t<E>>(), m_data(data), m_pass(pass),
+              m_level(level), m_output(output), m_result(result)
+        {
+        }
+
+        virtual partial_t<E> identity() const override
+        {
+            partial_t<E> result;
+            result.bins.resize(m_pass.bins);
+            return result;
+        }
+
+        virtual partial_t<E>
+        on_chunk(std::int64_t begin, std::int64_t end,
+                 const worker::cancellation_token &cancellation) override
+        {
+            auto result = identity();
+            auto i = static_cast<std::size_t>(begin);
+            const auto last = static_cast<std::size_t>(end);
+            while (i < last && !cancellation.stop_requested())
+            {
+                const auto count = std::min(BLOCK_SIZE, last - i);
+                if (m_pass.stats)
+                {
+                    result.stats.merge(
+                        worker::compute_stats(m_data + i, count, m_level));
+                }
+                if (0 < m_pass.bins)
+                {
+                    worker::compute_histogram(m_data + i, count, m_pass.low,
+                                              m_pass.high, result.bins.data(),
+                                              m_pass.bins);
+                }
+                m_output.processed.fetch_add(count, std::memory_order_relaxed);
+                i += count;
+            }
+            return result;
+        }
+
+        virtual partial_t<E> reduce(const partial_t<E> &left,
+                                    const partial_t<E> &right) const override
+        {
+            auto result = left;
+            result.stats.merge(right.stats);
+            for (std::size_t i = 0; i < result.bins.size(); ++i)
+            {
+                result.bins[i] += right.bins[i];
+            }
+            return result;
+        }
+
+        virtual bool on_result(const partial_t<E> &result) override
+        {
+            m_result = result;
+            return true;
+        }
+
+        reduce_body(const reduce_body &) = delete;
+        reduce_body(reduce_body &&) = delete;
+        reduce_body &operator=(const reduce_body &) = delete;
+        reduce_body &operator=(reduce_body &&) = delete;
+
+    private:
+        const E *const m_data;
+        const pass_t m_pass;
+        const worker::simd_level m_level;
+        worker::reduce_output &m_output;
+        partial_t<E> &m_result;
+    };
+
+    template <typename E>
+    void set_stats(const worker::block_stats<E> &stats,
+                   worker::reduce_output::result_t &result)
+    {
+        result.integer = false;
+        result.sum = stats.sum;
+        result.min = stats.min;
+        result.max = stats.max;
+    }
+
+    template <>
+    void set_stats(const worker::block_stats<std::int32_t> &stats,
+                   worker::reduce_output::result_t &result)
+    {
+        result.integer = true;
+        result.int_sum = stats.sum;
+        result.int_min = stats.min;
+        result.int_max = stats.max;
+    }
+
+    template <>
+    void set_stats(const worker::block_stats<std::int64_t> &stats,
+                   worker::reduce_output::result_t &result)
+    {
+        result.integer = true;
+        result.int_sum = stats.sum;
+        result.int_min = stats.min;
+        result.int_max = stats.max;
+    }
+
+    ///
+    /// \brief Reduces a buffer of E, in one pass, or two for a
+    ///        histogram that needs the min and max first.
+    ///
+    template <typename E> class reduce_runnable : public worker::runnable
+    {
+    public:
+        reduce_runnable(pybind11::object source,
+                        std::unique_ptr<pybind11::buffer_info> info,
+                        std::size_t count, const worker::reduce_input &input,
+                        std::shared_ptr<worker::reduce_output> output)
+            : worker::runnable(), m_source(std::move(source)),
+              m_info(std::move(info)), m_count(count), m_bins(input.bins),
+              m_range(!input.range.is_none()), m_min_chunk(input.min_chunk),
+              m_output(std::move(output))
+        {
+            if (m_range)
+            {
+                const pybind11::tuple bounds(input.range);
+                if (2 != bounds.size())
+                {
+                    throw std::invalid_argument("range must be (low, high)");
+                }
+                m_low = bounds[0].cast<double>();
+                m_high = bounds[1].cast<double>();
+                if (!(m_low < m_high))
+                {
+                    throw std::invalid_argument("range must have low < high");
+                }
+            }
+        }
+
+        ~reduce_runnable() { release_buffer(); }
+
+        virtual bool
+        on_working(const worker::cancellation_token &cancellation) override
+        {
+            const auto data = static_cast<const E *>(m_info->ptr);
+            typename reduce_body<E>::pass_t pass = {
+                true, m_range ? m_bins : 0, m_low, m_high};
+            partial_t<E> first;
+            if (!run_pass(data, pass, first, 0, cancellation))
+            {
+                return false;
+            }
+
+            worker::reduce_output::result_t result;
+            result.count = first.stats.count;
+            set_stats(first.stats, result);
+            result.histogram = std::move(first.bins);
+            if (0 < m_bins && !m_range)
+            {
+                // Like numpy.histogram: the items' own range, widened
+                // if they are all equal.
+                m_low = 0 < result.count ? first.stats.min : 0;
+                m_high = 0 < result.count ? first.stats.max : 1;
+                if (m_low == m_high)
+                {
+                    m_low -= 0.5;
+                    m_high += 0.5;
+                }
+                pass = {false, m_bins, m_low, m_high};
+                partial_t<E> second;
+                if (!run_pass(data, pass, second,
+                              static_cast<std::int64_t>(m_count),
+                              cancellation))
+                {
+                    return false;
+                }
+                result.histogram = std::move(second.bins);
+            }
+            result.low = m_low;
+            result.high = m_high;
+            result.ready = true;
+            m_output->set_result(std::move(result));
+            return true;
+        }
+
+        virtual bool
+        on_teardown(const worker::cancellation_token &) override
+        {
+            // Before the job is finished, so that nobody waiting for a
+            // finished job also waits for the GIL.
+            release_buffer();
+            return true;
+        }
+
+        reduce_runnable(const reduce_runnable &) = delete;
+        reduce_runnable(reduce_runnable &&) = delete;
+        reduce_runnable &operator=(const reduce_runnable &) = delete;
+        reduce_runnable &operator=(reduce_runnable &&) = delete;
+
+    private:
+        /// @brief Called on the worker thread, which doesn't hold the
+        ///        GIL.  During exit, leaks the buffer instead.
+        void release_buffer()
+        {
+            if (!m_info)
+            {
+                return;
+            }
+            if (Py_IsInitialized())
+            {
+                pybind11::gil_scoped_acquire gil;
+                m_info.reset();
+                m_source = pybind11::object();
+            }
+            else
+            {
+                m_info.release();
+                m_source.release();
+            }
+        }
+
+        bool run_pass(const E *data,
+                      const typename reduce_body<E>::pass_t &pass,
+                      partial_t<E> &result, std::int64_t progress_offset,
+                      const worker::cancellation_token &cancellation)
+        {
+            worker::parallel_range_runnable<partial_t<E>> range(
+                0, static_cast<std::int64_t>(m_count),
+                std::make_unique<reduce_body<E>>(data, pass, m_output->level,
+                                                 *m_output, result),
+                m_min_chunk, progress_offset);
+            return range.on_working(cancellation);
+        }
+
+        pybind11::object m_source;
+        std::unique_ptr<pybind11::buffer_info> m_info;
+        const std::size_t m_count;
+        const std::size_t m_bins;
+        const bool m_range;
+        double m_low = 0;
+        double m_high = 0;
+        const std::int64_t m_min_chunk;
+        const std::shared_ptr<worker::reduce_output> m_output;
+    };
+
+    enum class item_kind
+    {
+        float32,
+        float64,
+        int32,
+        int64
+    };
+
+    /**
+     * @brief Return the kind of item in a buffer, or throw
+     *        pybind11::type_error if reduce can't handle it.
+     */
+    item_kind get_item_kind(const pybind11::buffer_info &info)
+    {
+        auto format = info.format;
+        const std::uint16_t probe = 1;
+        const auto little_endian =
+            1 == *reinterpret_cast<const unsigned char *>(&probe);
+        if (!format.empty() &&
+            ('@' == format[0] || '=' == format[0] ||
+             ('<' == format[0] && little_endian)))
+        {
+            format.erase(0, 1);
+        }
+        if (1 == format.size())
+        {
+            switch (format[0])
+            {
+            case 'f':
+                if (4 == info.itemsize)
+                {
+                    return item_kind::float32;
+                }
+                break;
+            case 'd':
+                if (8 == info.itemsize)
+                {
+                    return item_kind::float64;
+                }
+                break;
+            case 'i':
+            case 'l':
+            case 'q':
+            case 'n':
+                if (4 == info.itemsize)
+                {
+                    return item_kind::int32;
+                }
+                if (8 == info.itemsize)
+                {
+                    return item_kind::int64;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        throw pybind11::type_error(
+            "Reduce needs float32, float64, int32 or int64 items, not '" +
+            info.format + "'");
+    }
+
+    /**
+     * @brief Return the number of items in a C-contiguous buffer, or
+     *        throw std::invalid_argument if it has gaps.
+     */
+    std::size_t get_item_count(const pybind11::buffer_info &info)
+    {
+        auto expected = info.itemsize;
+        std::size_t count = 1;
+        for (auto dimension = info.ndim; 0 < dimension--;)
+        {
+            const auto extent = info.shape[dimension];
+            if (1 != extent && expected != info.strides[dimension])
+            {
+                throw std::invalid_argument(
+                    "Reduce needs a C-contiguous buffer");
+            }
+            expected *= extent;
+            count *= static_cast<std::size_t>(extent);
+        }
+        return count;
+    }
+
+    template <typename E>
+    std::unique_ptr<worker::runnable>
+    make_runnable(pybind11::object source,
+                  std::unique_ptr<pybind11::buffer_info> info,
+                  std::size_t count, const worker::reduce_input &input,
+                  std::shared_ptr<worker::reduce_output> output)
+    {
+        return std::make_unique<reduce_runnable<E>>(
+            std::move(source), std::move(info), count, input,
+            std::move(output));
+    }
+}
+
+void worker::reduce_output::set_result(result_t result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_result = std::move(result);
+}
+
+worker::reduce_output::result_t worker::reduce_output::get_result() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_result;
+}
+
+worker::job_data worker::reduce_input::get_job_data() const
+{
+    // The job runs from this snapshot, even if Python sets a field
+    // (from another thread) while it is made.
+    const auto fields = copy_fields(*this);
+    if (fields.min_chunk < 1)
+    {
+        throw std::invalid_argument("min_chunk must be at least 1");
+    }
+    auto info = std::make_unique<pybind11::buffer_info>(fields.data.request());
+    const auto kind = get_item_kind(*info);
+    const auto count = get_item_count(*info);
+
+    auto output = std::make_shared<reduce_output>();
+    output->level = get_simd_level();
+
+    worker::job_data result = {};
+    result.python_input = pybind11::cast(fields);
+    result.python_output = pybind11::cast(output);
+    switch (kind)
+    {
+    case item_kind::float32:
+        result.runnable_object = make_runnable<float>(
+            fields.data, std::move(info), count, fields, std::move(output));
+        break;
+    case item_kind::float64:
+        result.runnable_object = make_runnable<double>(
+            fields.data, std::move(info), count, fields, std::move(output));
+        break;
+    case item_kind::int32:
+        result.runnable_object = make_runnable<std::int32_t>(
+            fields.data, std::move(info), count, fields, std::move(output));
+        break;
+    case item_kind::int64:
+        result.runnable_object = make_runnable<std::int64_t>(
+            fields.data, std::move(info), count, fields, std::move(output));
+        break;
+    }
+    return result;
+}
+
+std::string worker::reduce_input::get_repr() const
+{
+    return std::string("Reduce") + get_str();
+}
+
+std::string worker::reduce_input::get_str() const
+{
+    std::stringstream sstr;
+    sstr << "(bins=" << get_field(*this, &reduce_input::bins)
+         << ", min_chunk=" << get_field(*this, &reduce_input::min_chunk) << ")";
+    return sstr.str();
+}
+
+pybind11::module &worker::bind_worker_reduce(pybind11::module &module)
+{
+    pybind11::enum_<simd_level>(module, "SimdLevel", R"pbdoc(
+The instruction set used by the Reduce kernels.
+)pbdoc")
+        .value("SCALAR", simd_level::scalar, "Plain C++, for any CPU")
+        .value("AVX2", simd_level::avx2, "256-bit vectors")
+        .value("AVX512", simd_level::avx512, "512-bit vectors (AVX-512F)");
+
+    module.def("supported_simd_level", &supported_simd_level,
+               "Return the best SimdLevel this CPU supports");
+    module.def("get_simd_level", &get_simd_level,
+               "Return the SimdLevel used by Reduce Jobs launched from now on");
+    module.def("set_simd_level", &set_simd_level, R"pbdoc(
+Choose the SimdLevel for Reduce Jobs launched from now on, for
+example to compare kernels.  It starts as supported_simd_level().
+
+Returns
+----------
+The level set, which is never above supported_simd_level().
+)pbdoc",
+               pybind11::arg("level"));
+
+    pybind11::class_<reduce_output, std::shared_ptr<reduce_output>> output(
+        module, "ReduceOutput", R"pbdoc(
+What a Reduce Job found.  Everything but .processed and .simd is None
+until the Job completes.
+)pbdoc");
+    output.def_property_readonly(
+        "processed",
+        [](const reduce_output &self) {
+            return static_cast<std::uint64_t>(self.processed);
+        },
+        "Items scanned so far (a histogram without a range scans twice)");
+    output.def_readonly("simd", &reduce_output::level,
+                        "The SimdLevel of the kernels used");
+    output.def_property_readonly(
+        "count",
+        [](const reduce_output &self) -> pybind11::object {
+            const auto result = self.get_result();
+            if (!result.ready)
+            {
+                return pybind11::none();
+            }
+            return pybind11::int_(result.count);
+        },
+        "The number of items");
+    typedef reduce_output::result_t result_t;
+    auto add_stat = [&output](const char *name, double result_t::*value,
+                              std::int64_t result_t::*int_value,
+                              const char *doc) {
+        output.def_property_readonly(
+            name,
+            [value, int_value](const reduce_output &self) -> pybind11::object {
+                const auto result = self.get_result();
+                if (!result.ready || (int_value != &result_t::int_sum &&
+                                      0 == result.count))
+                {
+                    return pybind11::none();
+                }
+                if (result.integer)
+                {
+                    return pybind11::int_(result.*int_value);
+                }
+                return pybind11::float_(result.*value);
+            },
+            doc);
+    };
+    add_stat("sum", &result_t::sum, &result_t::int_sum,
+             "The sum: an int for integer items, a float otherwise");
+    add_stat("min", &result_t::min, &result_t::int_min,
+             "The smallest item, or None if there are none");
+    add_stat("max", &result_t::max, &result_t::int_max,
+             "The largest item, or None if there are none");
+    output.def_property_readonly(
+        "mean",
+        [](const reduce_output &self) -> pybind11::object {
+            const auto result = self.get_result();
+            if (!result.ready || 0 == result.count)
+            {
+                return pybind11::none();
+            }
+            const auto sum = result.integer
+                                 ? static_cast<double>(result.int_sum)
+                                 : result.sum;
+            return pybind11::float_(sum / static_cast<double>(result.count));
+        },
+        "The mean, or None if there are no items");
+    output.def_property_readonly(
+        "histogram",
+        [](const reduce_output &self) -> pybind11::object {
+            const auto result = self.get_result();
+            if (!result.ready || result.histogram.empty())
+            {
+                return pybind11::none();
+            }
+            pybind11::list bins;
+            for (auto count : result.histogram)
+            {
+                bins.append(pybind11::int_(count));
+            }
+            return bins;
+        },
+        "The count in each bin, if bins were asked for");
+    output.def_property_readonly(
+        "range",
+        [](const reduce_output &self) -> pybind11::object {
+            const auto result = self.get_result();
+            if (!result.ready || result.histogram.empty())
+            {
+                return pybind11::none();
+            }
+            return pybind11::make_tuple(result.low, result.high);
+        },
+        "The (low, high) range the bins cover");
+
+    pybind11::class_<reduce_input, input> obj(module, "Reduce", R"pbdoc(
+Job that reduces a buffer of numbers, such as a NumPy array or an
+array.array, without copying it or holding the GIL.
+
+It finds the count, sum, min, max and mean of the items and, if .bins
+is set, a histogram like numpy.histogram's: equal bins over .range
+(or the items' min and max).  Items may be float32, float64, int32
+or int64, in any C-contiguous shape.  Sums of floats are kept as
+float64 and sums of integers as int64.  NaNs give unspecified results.
+
+The kernels use the widest vectors the CPU supports (see
+set_simd_level()).  Buffers longer than .min_chunk are split across
+the Executor's threads, the Job's own included.  Progress (see
+Job.on_progress()) and output.processed count the items scanned.
+
+The buffer is held (so it can't be resized) until the Job finishes.
+Don't write to it meanwhile.
+)pbdoc");
+    obj.def(pybind11::init<pybind11::buffer, std::size_t, pybind11::object,
+                           std::int64_t>(),
+            pybind11::arg("data"), pybind11::arg("bins") = 0,
+            pybind11::arg("range") = pybind11::none(),
+            pybind11::arg("min_chunk") = 65536);
+    obj.def_readonly("data", &reduce_input::data, "The buffer to reduce");
+    def_field(obj, "bins", &reduce_input::bins,
+              "Histogram bins, or 0 for no histogram");
+    def_field(obj, "range", &reduce_input::range,
+              "(low, high) for the histogram, or None");
+    def_field(obj, "min_chunk", &reduce_input::min_chunk,
+              "The fewest items handed to a thread at once");
+    return module;
+}
@@ -0,0 +1,115 @@
+#ifndef WORKER_REDUCE_H
+#define WORKER_REDUCE_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "input.h"
+#include "reduce_kernels.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief What a reduce job found.
+    ///
+    /// The result is set once, when the job completes.  'processed'
+    /// counts up while it runs.
+    ///
+    struct reduce_output
+    {
+        struct result_t
+        {
+            bool ready = false;
+            /// @brief Integer items set the int_ fields, floating
+            ///        point items the others.
+            bool integer = false;
+            std::uint64_t count = 0;
+            double sum = 0;
+            double min = 0;
+            double max = 0;
+            std::int64_t int_sum = 0;
+            std::int64_t int_min = 0;
+            std::int64_t int_max = 0;
+            /// @brief Empty unless bins were asked for.
+            std::vector<std::uint64_t> histogram = {};
+            double low = 0;
+            double high = 0;
+        };
+
+        /// @brief Items scanned so far.  A histogram without a range
+        ///        scans the items twice.
+        std::atomic<std::uint64_t> processed = {0};
+        /// @brief The kernels used.  Set before the job is submitted.
+        simd_level level = simd_level::scalar;
+
+        void set_result(result_t result);
+        result_t get_result() const;
+
+    private:
+        mutable std::mutex m_mutex = {};
+        result_t m_result = {};
+    };
+
+    ///
+    /// \brief Input for a job that reduces a buffer of numbers:
+    ///        count, sum, min, max and (optionally) a histogram.
+    ///
+    /// The job reads the buffer in place, without the GIL, holding
+    /// the buffer (so it can't be resized) until it finishes.  Large
+    /// buffers are split across the executor's threads.
+    ///
+    struct reduce_input : public input
+    {
+        reduce_input(pybind11::buffer data_, std::size_t bins_,
+                     pybind11::object range_, std::int64_t min_chunk_)
+            : data(std::move(data_)), bins(bins_), range(std::move(range_)),
+              min_chunk(min_chunk_)
+        {
+        }
+
+        pybind11::buffer data;
+        /// @brief Histogram bins, or 0 for no histogram.
+        std::size_t bins;
+        /// @brief (low, high) for the histogram, or None for the
+        ///        items' min and max.
+        pybind11::object range;
+        /// @brief The fewest items handed to a thread at once.
+        std::int64_t min_chunk;
+
+        /// @brief Needs the GIL.
+        virtual job_data get_job_data() const override;
+        virtual std::string get_repr() const override;
+        virtual std::string get_str() const override;
+    };
+
+    pybind11::module &bind_worker_reduce(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_REDUCE_H
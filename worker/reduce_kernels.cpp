@@ -0,0 +1,435 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "reduce_kernels.h"
+
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// Kernels are compiled for AVX2 and AVX-512 with target attributes,
+// so the rest of the library still runs on any x86 CPU.
+#define WORKER_REDUCE_X86 1
+#include <immintrin.h>
+#define WORKER_TARGET_AVX2 __attribute__((target("avx2")))
+#define WORKER_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define WORKER_REDUCE_X86 0
+#endif
+
+namespace
+{
+    std::atomic<worker::simd_level> &current_level()
+    {
+        static std::atomic<worker::simd_level> result = {
+            worker::supported_simd_level()};
+        return result;
+    }
+
+    template <typename E>
+    worker::block_stats<E> stats_scalar(const E *data, std::size_t count)
+    {
+        worker::block_stats<E> result;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto item = data[i];
+            result.sum += item;
+            result.min = item < result.min ? item : result.min;
+            result.max = result.max < item ? item : result.max;
+        }
+        result.count = count;
+        return result;
+    }
+
+    /// @brief Fold vector lanes (stored to arrays) into 'result'.
+    template <typename E, typename Sum, std::size_t SUMS, std::size_t LANES>
+    void fold_lanes(const Sum (&sums)[SUMS], const E (&mins)[LANES],
+                    const E (&maxes)[LANES], worker::block_stats<E> &result)
+    {
+        for (auto sum : sums)
+        {
+            result.sum += sum;
+        }
+        for (std::size_t i = 0; i < LANES; ++i)
+        {
+            result.min = mins[i] < result.min ? mins[i] : result.min;
+            result.max = result.max < maxes[i] ? maxes[i] : result.max;
+        }
+    }
+
+    /// @brief Add the stats of the items after the last full vector.
+    template <typename E>
+    worker::block_stats<E> with_tail(worker::block_stats<E> result,
+                                     const E *data, std::size_t done,
+                                     std::size_t count)
+    {
+        result.count = done;
+        result.merge(stats_scalar(data + done, count - done));
+        return result;
+    }
+
+#if WORKER_REDUCE_X86
+    WORKER_TARGET_AVX2 worker::block_stats<double>
+    stats_avx2(const double *data, std::size_t count)
+    {
+        worker::block_stats<double> result;
+        std::size_t i = 0;
+        if (4 <= count)
+        {
+            // Two sums, to hide the latency of the adds.
+            auto sum0 = _mm256_setzero_pd();
+            auto sum1 = _mm256_setzero_pd();
+            auto low = _mm256_loadu_pd(data);
+            auto high = low;
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto a = _mm256_loadu_pd(data + i);
+                const auto b = _mm256_loadu_pd(data + i + 4);
+                sum0 = _mm256_add_pd(sum0, a);
+                sum1 = _mm256_add_pd(sum1, b);
+                low = _mm256_min_pd(low, _mm256_min_pd(a, b));
+                high = _mm256_max_pd(high, _mm256_max_pd(a, b));
+            }
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto a = _mm256_loadu_pd(data + i);
+                sum0 = _mm256_add_pd(sum0, a);
+                low = _mm256_min_pd(low, a);
+                high = _mm256_max_pd(high, a);
+            }
+            double sums[4], mins[4], maxes[4];
+            _mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+            _mm256_storeu_pd(mins, low);
+            _mm256_storeu_pd(maxes, high);
+            fold_lanes(sums, mins, maxes, result);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX2 worker::block_stats<float>
+    stats_avx2(const float *data, std::size_t count)
+    {
+        worker::block_stats<float> result;
+        std::size_t i = 0;
+        if (8 <= count)
+        {
+            // Sums are widened to double, min and max stay float.
+            auto sum0 = _mm256_setzero_pd();
+            auto sum1 = _mm256_setzero_pd();
+            auto low = _mm256_loadu_ps(data);
+            auto high = low;
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto a = _mm256_loadu_ps(data + i);
+                sum0 = _mm256_add_pd(
+                    sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+                sum1 = _mm256_add_pd(
+                    sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+                low = _mm256_min_ps(low, a);
+                high = _mm256_max_ps(high, a);
+            }
+            double sums[4];
+            float mins[8], maxes[8];
+            _mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+            _mm256_storeu_ps(mins, low);
+            _mm256_storeu_ps(maxes, high);
+            fold_lanes(sums, mins, maxes, result);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX2 worker::block_stats<std::int32_t>
+    stats_avx2(const std::int32_t *data, std::size_t count)
+    {
+        worker::block_stats<std::int32_t> result;
+        std::size_t i = 0;
+        if (8 <= count)
+        {
+            // Sums are widened to 64 bits, so they don't overflow.
+            auto sum0 = _mm256_setzero_si256();
+            auto sum1 = _mm256_setzero_si256();
+            auto low = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(data));
+            auto high = low;
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto a = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(data + i));
+                sum0 = _mm256_add_epi64(
+                    sum0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(a)));
+                sum1 = _mm256_add_epi64(
+                    sum1,
+                    _mm256_cvtepi32_epi64(_mm256_extracti128_si256(a, 1)));
+                low = _mm256_min_epi32(low, a);
+                high = _mm256_max_epi32(high, a);
+            }
+            std::int64_t sums[4];
+            std::int32_t mins[8], maxes[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums),
+                                _mm256_add_epi64(sum0, sum1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(mins), low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(maxes), high);
+            fold_lanes(sums, mins, maxes, result);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX2 worker::block_stats<std::int64_t>
+    stats_avx2(const std::int64_t *data, std::size_t count)
+    {
+        worker::block_stats<std::int64_t> result;
+        std::size_t i = 0;
+        if (4 <= count)
+        {
+            // AVX2 has no 64-bit min or max, so compare and blend.
+            auto sum = _mm256_setzero_si256();
+            auto low = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(data));
+            auto high = low;
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto a = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(data + i));
+                sum = _mm256_add_epi64(sum, a);
+                low = _mm256_blendv_epi8(low, a, _mm256_cmpgt_epi64(low, a));
+                high = _mm256_blendv_epi8(high, a, _mm256_cmpgt_epi64(a, high));
+            }
+            std::int64_t sums[4], mins[4], maxes[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), sum);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(mins), low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(maxes), high);
+            fold_lanes(sums, mins, maxes, result);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX512 worker::block_stats<double>
+    stats_avx512(const double *data, std::size_t count)
+    {
+        worker::block_stats<double> result;
+        std::size_t i = 0;
+        if (8 <= count)
+        {
+            auto sum0 = _mm512_setzero_pd();
+            auto sum1 = _mm512_setzero_pd();
+            auto low = _mm512_loadu_pd(data);
+            auto high = low;
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto a = _mm512_loadu_pd(data + i);
+                const auto b = _mm512_loadu_pd(data + i + 8);
+                sum0 = _mm512_add_pd(sum0, a);
+                sum1 = _mm512_add_pd(sum1, b);
+                low = _mm512_min_pd(low, _mm512_min_pd(a, b));
+                high = _mm512_max_pd(high, _mm512_max_pd(a, b));
+            }
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto a = _mm512_loadu_pd(data + i);
+                sum0 = _mm512_add_pd(sum0, a);
+                low = _mm512_min_pd(low, a);
+                high = _mm512_max_pd(high, a);
+            }
+            result.sum = _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+            result.min = _mm512_reduce_min_pd(low);
+            result.max = _mm512_reduce_max_pd(high);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX512 worker::block_stats<float>
+    stats_avx512(const float *data, std::size_t count)
+    {
+        worker::block_stats<float> result;
+        std::size_t i = 0;
+        if (16 <= count)
+        {
+            auto sum0 = _mm512_setzero_pd();
+            auto sum1 = _mm512_setzero_pd();
+            auto low = _mm512_loadu_ps(data);
+            auto high = low;
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto a = _mm512_loadu_ps(data + i);
+                const auto upper = _mm256_castpd_ps(
+                    _mm512_extractf64x4_pd(_mm512_castps_pd(a), 1));
+                sum0 = _mm512_add_pd(
+                    sum0, _mm512_cvtps_pd(_mm512_castps512_ps256(a)));
+                sum1 = _mm512_add_pd(sum1, _mm512_cvtps_pd(upper));
+                low = _mm512_min_ps(low, a);
+                high = _mm512_max_ps(high, a);
+            }
+            result.sum = _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+            result.min = _mm512_reduce_min_ps(low);
+            result.max = _mm512_reduce_max_ps(high);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX512 worker::block_stats<std::int32_t>
+    stats_avx512(const std::int32_t *data, std::size_t count)
+    {
+        worker::block_stats<std::int32_t> result;
+        std::size_t i = 0;
+        if (16 <= count)
+        {
+            auto sum0 = _mm512_setzero_si512();
+            auto sum1 = _mm512_setzero_si512();
+            auto low = _mm512_loadu_si512(data);
+            auto high = low;
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto a = _mm512_loadu_si512(data + i);
+                sum0 = _mm512_add_epi64(
+                    sum0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(a)));
+                sum1 = _mm512_add_epi64(
+                    sum1,
+                    _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(a, 1)));
+                low = _mm512_min_epi32(low, a);
+                high = _mm512_max_epi32(high, a);
+            }
+            result.sum = _mm512_reduce_add_epi64(_mm512_add_epi64(sum0, sum1));
+            result.min = _mm512_reduce_min_epi32(low);
+            result.max = _mm512_reduce_max_epi32(high);
+        }
+        return with_tail(result, data, i, count);
+    }
+
+    WORKER_TARGET_AVX512 worker::block_stats<std::int64_t>
+    stats_avx512(const std::int64_t *data, std::size_t count)
+    {
+        worker::block_stats<std::int64_t> result;
+        std::size_t i = 0;
+        if (8 <= count)
+        {
+            auto sum = _mm512_setzero_si512();
+            auto low = _mm512_loadu_si512(data);
+            auto high = low;
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto a = _mm512_loadu_si512(data + i);
+                sum = _mm512_add_epi64(sum, a);
+                low = _mm512_min_epi64(low, a);
+                high = _mm512_max_epi64(high, a);
+            }
+            result.sum = _mm512_reduce_add_epi64(sum);
+            result.min = _mm512_reduce_min_epi64(low);
+            result.max = _mm512_reduce_max_epi64(high);
+        }
+        return with_tail(result, data, i, count);
+    }
+#endif
+}
+
+worker::simd_level worker::supported_simd_level()
+{
+#if WORKER_REDUCE_X86
+    static const auto result = [] {
+        // Also checks that the OS saves the wider registers.
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            return simd_level::avx512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return simd_level::avx2;
+        }
+        return simd_level::scalar;
+    }();
+    return result;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+worker::simd_level worker::get_simd_level() { return current_level(); }
+
+worker::simd_level worker::set_simd_level(simd_level level)
+{
+    const auto supported = supported_simd_level();
+    if (static_cast<int>(supported) < static_cast<int>(level))
+    {
+        level = supported;
+    }
+    current_level() = level;
+    return level;
+}
+
+template <typename E>
+worker::block_stats<E> worker::compute_stats(const E *data, std::size_t count,
+                                             simd_level level)
+{
+    switch (level)
+    {
+#if WORKER_REDUCE_X86
+    case simd_level::avx512:
+        return stats_avx512(data, count);
+    case simd_level::avx2:
+        return stats_avx2(data, count);
+#else
+    case simd_level::avx512:
+    case simd_level::avx2:
+#endif
+    case simd_level::scalar:
+        break;
+    }
+    return stats_scalar(data, count);
+}
+
+template <typename E>
+void worker::compute_histogram(const E *data, std::size_t count, double low,
+                               double high, std::uint64_t *bins,
+                               std::size_t bin_count)
+{
+    const auto scale = static_cast<double>(bin_count) / (high - low);
+    const auto last = bin_count - 1;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto item = static_cast<double>(data[i]);
+        if (low <= item && item <= high)
+        {
+            const auto bin = static_cast<std::size_t>((item - low) * scale);
+            ++bins[bin < last ? bin : last];
+        }
+    }
+}
+
+template worker::block_stats<float>
+worker::compute_stats(const float *, std::size_t, simd_level);
+template worker::block_stats<double>
+worker::compute_stats(const double *, std::size_t, simd_level);
+template worker::block_stats<std::int32_t>
+worker::compute_stats(const std::int32_t *, std::size_t, simd_level);
+template worker::block_stats<std::int64_t>
+worker::compute_stats(const std::int64_t *, std::size_t, simd_level);
+
+template void worker::compute_histogram(const float *, std::size_t, double,
+                                        double, std::uint64_t *, std::size_t);
+template void worker::compute_histogram(const double *, std::size_t, double,
+                                        double, std::uint64_t *, std::size_t);
+template void worker::compute_histogram(const std::int32_t *, std::size_t,
+                                        double, double, std::uint64_t *,
+                                        std::size_t);
+template void worker::compute_histogram(const std::int64_t *, std::size_t,
+                                        double, double, std::uint64_t *,
+                                        std::size_t);
@@ -0,0 +1,128 @@
+#ifndef WORKER_REDUCE_KERNELS_H
+#define WORKER_REDUCE_KERNELS_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace worker
+{
+    ///
+    /// \brief The instruction sets the reduction kernels can use.
+    ///
+    enum class simd_level
+    {
+        scalar, ///< Plain C++, for any CPU
+        avx2,   ///< 256-bit vectors
+        avx512  ///< 512-bit vectors (AVX-512F)
+    };
+
+    /**
+     * @brief The best level this CPU (and OS) supports.  Detected on
+     *        the first call.
+     */
+    simd_level supported_simd_level();
+
+    /**
+     * @brief The level used by reductions launched from now on.
+     *        Starts as supported_simd_level().
+     */
+    simd_level get_simd_level();
+
+    /**
+     * @brief Choose the level for reductions launched from now on,
+     *        for example to compare kernels.
+     * @return The level set: 'level', or the supported level if the
+     *        CPU can't run 'level'.
+     */
+    simd_level set_simd_level(simd_level level);
+
+    /// @brief The type sums of E are kept in.
+    template <typename E> struct accumulator
+    {
+        typedef double type;
+    };
+    template <> struct accumulator<std::int32_t>
+    {
+        typedef std::int64_t type;
+    };
+    template <> struct accumulator<std::int64_t>
+    {
+        typedef std::int64_t type;
+    };
+
+    ///
+    /// \brief Sum, minimum and maximum of a block of items.
+    ///
+    template <typename E> struct block_stats
+    {
+        typename accumulator<E>::type sum = 0;
+        E min = std::numeric_limits<E>::has_infinity
+                    ? std::numeric_limits<E>::infinity()
+                    : std::numeric_limits<E>::max();
+        E max = std::numeric_limits<E>::has_infinity
+                    ? -std::numeric_limits<E>::infinity()
+                    : std::numeric_limits<E>::lowest();
+        std::uint64_t count = 0;
+
+        /// @brief Add another block's stats to these.
+        void merge(const block_stats &other)
+        {
+            sum += other.sum;
+            min = other.min < min ? other.min : min;
+            max = max < other.max ? other.max : max;
+            count += other.count;
+        }
+    };
+
+    /**
+     * @brief Compute the stats of 'count' items with the kernel for
+     *        'level'.  Floating-point sums may differ in the last
+     *        bits between levels, since they add in a different order.
+     *
+     *        Instantiated for float, double, std::int32_t and
+     *        std::int64_t.
+     */
+    template <typename E>
+    block_stats<E> compute_stats(const E *data, std::size_t count,
+                                 simd_level level);
+
+    /**
+     * @brief Count items into 'bin_count' equal bins over [low, high].
+     *        Items outside the range are skipped, and 'high' falls in
+     *        the last bin (as numpy.histogram does).
+     *
+     *        Binning is scalar: scattered increments don't gain from
+     *        vectors.  Instantiated for the same types as
+     *        compute_stats().
+     */
+    template <typename E>
+    void compute_histogram(const E *data, std::size_t count, double low,
+                           double high, std::uint64_t *bins,
+                           std::size_t bin_count);
+
+} // end namespace worker
+
+#endif // WORKER_REDUCE_KERNELS_H
@@ -0,0 +1,104 @@
+#ifndef WORKER_RESULT_BUFFER_H
+#define WORKER_RESULT_BUFFER_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace worker
+{
+    ///
+    /// \brief Fixed-size, append-only result storage shared with Python.
+    ///
+    /// The runnable appends values from its worker thread and then
+    /// publishes the new length.  Python sees the published prefix
+    /// through the buffer protocol without a copy.  The storage never
+    /// moves and published values never change, so a view taken while
+    /// the job is WORKING stays valid (it just doesn't grow).
+    ///
+    template <typename T> class result_buffer
+    {
+    public:
+        /**
+         * @param capacity The most values that can be appended.
+         */
+        explicit result_buffer(std::size_t capacity = 0)
+            : m_capacity(capacity),
+              m_data(capacity ? new T[capacity] : nullptr)
+        {
+        }
+
+        /**
+         * @brief Append a value and publish it.  Producer thread only.
+         * @return False if the buffer is full.
+         */
+        bool append(const T &value)
+        {
+            const auto size = m_size.load(std::memory_order_relaxed);
+            if (m_capacity <= size)
+            {
+                return false;
+            }
+            m_data[size] = value;
+            m_size.store(size + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief The number of published values.
+        std::size_t size() const
+        {
+            return m_size.load(std::memory_order_acquire);
+        }
+
+        std::size_t capacity() const { return m_capacity; }
+        const T *data() const { return m_data.get(); }
+
+        /// @brief A read-only buffer over the published values.
+        pybind11::buffer_info view() const
+        {
+            const auto size = static_cast<pybind11::ssize_t>(this->size());
+            return pybind11::buffer_info(
+                static_cast<const void *>(m_data.get()), sizeof(T),
+                pybind11::format_descriptor<T>::format(), 1, {size},
+                {static_cast<pybind11::ssize_t>(sizeof(T))}, true);
+        }
+
+        // The storage is shared by address with Python views.
+        result_buffer(const result_buffer &) = delete;
+        result_buffer(result_buffer &&) = delete;
+        result_buffer &operator=(const result_buffer &) = delete;
+        result_buffer &operator=(result_buffer &&) = delete;
+
+    private:
+        const std::size_t m_capacity;
+        std::unique_ptr<T[]> m_data;
+        std::atomic<std::size_t> m_size = {0};
+    };
+
+} // end namespace worker
+
+#endif // WORKER_RESULT_BUFFER_H
@@ -0,0 +1,290 @@
+#ifndef WORKER_RING_BUFFER_H
+#define WORKER_RING_BUFFER_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./pool_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+namespace worker
+{
+    ///
+    /// \brief What a full ring_buffer does with a new item.
+    ///
+    enum class overflow_policy
+    {
+        block,       ///< Wait for the consumer to make room
+        drop_oldest, ///< Overwrite the oldest unread item
+        drop_newest  ///< Discard the new item
+    };
+
+    ///
+    /// \brief Bounded single-producer, single-consumer ring buffer.
+    ///
+    /// The producer (a runnable on its worker thread) pushes items one
+    /// at a time or in batches and the consumer drains them in
+    /// batches, without locks on either side.  Slots are atomics so
+    /// that drop_oldest can overwrite a slot the consumer might be
+    /// reading; the consumer notices and retries, because the
+    /// producer moved the read index first.  T should be small and
+    /// trivially copyable.
+    ///
+    template <typename T> class ring_buffer
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "ring_buffer items must be trivially copyable");
+
+    public:
+        typedef std::atomic<T> slot_t;
+
+        /**
+         * @param capacity The number of items (rounded up to a power
+         *        of two, at least 1).
+         * @param policy What push() does when the buffer is full.
+         */
+        explicit ring_buffer(std::size_t capacity = 1024,
+                             overflow_policy policy =
+                                 overflow_policy::drop_oldest)
+            : m_capacity(round_up(capacity)), m_mask(m_capacity - 1),
+              m_policy(policy),
+              m_slots(static_cast<slot_t *>(
+                  pool_allocate(m_capacity * sizeof(slot_t))))
+        {
+            for (std::size_t i = 0; i < m_capacity; ++i)
+            {
+                new (&m_slots[i]) slot_t();
+            }
+        }
+
+        ~ring_buffer()
+        {
+            pool_deallocate(m_slots, m_capacity * sizeof(slot_t));
+        }
+
+        /**
+         * @brief Add an item.  Producer thread only.
+         * @param item The item to add.
+         * @param keep_waiting With overflow_policy::block, called
+         *        while the buffer is full, yielding in between.
+         *        Return false to give up (for example, because the
+         *        job was aborted).  Callers that may wait long pass
+         *        one that returns false and sleep themselves (see
+         *        stream_output).
+         * @return True if the item was added.
+         */
+        template <typename Predicate>
+        bool push(const T &item, Predicate keep_waiting)
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            auto head = m_head.load(std::memory_order_acquire);
+            while (m_capacity <= tail - head)
+            {
+                switch (m_policy)
+                {
+                case overflow_policy::drop_newest:
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case overflow_policy::drop_oldest:
+                    if (m_head.compare_exchange_weak(head, head + 1,
+                                                     std::memory_order_acq_rel))
+                    {
+                        m_dropped.fetch_add(1, std::memory_order_relaxed);
+                        head += 1;
+                    }
+                    break;
+                case overflow_policy::block:
+                    if (!keep_waiting())
+                    {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                    head = m_head.load(std::memory_order_acquire);
+                    break;
+                }
+            }
+
+            m_slots[tail & m_mask].store(item, std::memory_order_relaxed);
+            m_tail.store(tail + 1, std::memory_order_release);
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * @brief Add an item, never giving up with overflow_policy::block.
+         */
+        bool push(const T &item)
+        {
+            return push(item, [] { return true; });
+        }
+
+        /**
+         * @brief Add a batch of items with a single update of the
+         *        write index.  Producer thread only.
+         *
+         *        Never waits.  With overflow_policy::block, only the
+         *        items that fit are added and the caller retries
+         *        with the rest.  With drop_newest, those are dropped.
+         *        With drop_oldest, unread items (and, if 'count' is
+         *        over the capacity, the first of the new ones) are
+         *        dropped to make room.
+         *
+         * @return The number of items dealt with (added or dropped),
+         *        from the front of 'items'.  Less than 'count' only
+         *        with overflow_policy::block.
+         */
+        std::size_t push_many(const T *items, std::size_t count)
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            auto head = m_head.load(std::memory_order_acquire);
+            auto room = static_cast<std::size_t>(m_capacity - (tail - head));
+            auto skipped = std::size_t{0};
+            if (overflow_policy::drop_oldest == m_policy && room < count)
+            {
+                if (m_capacity < count)
+                {
+                    skipped = count - m_capacity;
+                    m_dropped.fetch_add(skipped, std::memory_order_relaxed);
+                }
+                while (room < count - skipped)
+                {
+                    const auto needed = count - skipped - room;
+                    if (m_head.compare_exchange_weak(head, head + needed,
+                                                     std::memory_order_acq_rel))
+                    {
+                        m_dropped.fetch_add(needed, std::memory_order_relaxed);
+                        head += needed;
+                    }
+                    room = static_cast<std::size_t>(m_capacity -
+                                                    (tail - head));
+                }
+            }
+
+            const auto added = std::min(room, count - skipped);
+            for (std::size_t i = 0; i < added; ++i)
+            {
+                m_slots[(tail + i) & m_mask].store(items[skipped + i],
+                                                   std::memory_order_relaxed);
+            }
+            m_tail.store(tail + added, std::memory_order_release);
+            m_pushed.fetch_add(added, std::memory_order_relaxed);
+            if (overflow_policy::drop_newest == m_policy && added < count)
+            {
+                m_dropped.fetch_add(count - added, std::memory_order_relaxed);
+                return count;
+            }
+            return skipped + added;
+        }
+
+        /**
+         * @brief Remove up to 'count' of the oldest items.  Consumer
+         *        only (one at a time).
+         * @param out Receives the items.
+         * @param count The most items to remove.
+         * @return The number of items removed.
+         */
+        std::size_t drain(T *out, std::size_t count)
+        {
+            while (true)
+            {
+                auto head = m_head.load(std::memory_order_acquire);
+                const auto tail = m_tail.load(std::memory_order_acquire);
+                const auto available = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(tail - head, count));
+                if (0 == available)
+                {
+                    return 0;
+                }
+                for (std::size_t i = 0; i < available; ++i)
+                {
+                    out[i] = m_slots[(head + i) & m_mask].load(
+                        std::memory_order_relaxed);
+                }
+                // Fails only if drop_oldest moved head under us, in
+                // which case what we copied may be overwritten.
+                if (m_head.compare_exchange_strong(head, head + available,
+                                                   std::memory_order_acq_rel))
+                {
+                    m_drained.fetch_add(available, std::memory_order_relaxed);
+                    return available;
+                }
+            }
+        }
+
+        /// @brief The number of unread items (may be stale).
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(
+                m_tail.load(std::memory_order_acquire) -
+                m_head.load(std::memory_order_acquire));
+        }
+
+        std::size_t capacity() const { return m_capacity; }
+        overflow_policy policy() const { return m_policy; }
+
+        /// @brief Items added by push().
+        std::uint64_t pushed() const { return m_pushed; }
+        /// @brief Items discarded because the buffer was full.
+        std::uint64_t dropped() const { return m_dropped; }
+        /// @brief Items removed by drain().
+        std::uint64_t drained() const { return m_drained; }
+
+        // Shared by address between the producer and consumer.
+        ring_buffer(const ring_buffer &) = delete;
+        ring_buffer(ring_buffer &&) = delete;
+        ring_buffer &operator=(const ring_buffer &) = delete;
+        ring_buffer &operator=(ring_buffer &&) = delete;
+
+    private:
+        static std::size_t round_up(std::size_t capacity)
+        {
+            std::size_t result = 1;
+            while (result < capacity)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        const std::size_t m_capacity;
+        const std::size_t m_mask;
+        const overflow_policy m_policy;
+        slot_t *const m_slots;
+
+        // Consumer-written (and drop_oldest producer) on one line,
+        // producer-written on another.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_head = {0};
+        std::atomic<std::uint64_t> m_drained = {0};
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_tail = {0};
+        std::atomic<std::uint64_t> m_pushed = {0};
+        std::atomic<std::uint64_t> m_dropped = {0};
+    };
+
+} // end namespace worker
+
+#endif // WORKER_RING_BUFFER_H
@@ -27,6 +27,12 @@
 // warnings at runtime until I moved a method out of the header so the
 // compiler could figure out it needed RTTI stuff.  Annoying.
 
-bool worker::runnable::on_setup() { return true; }
+bool worker::runnable::on_setup(const cancellation_token &)
+{
+    return true;
+}
 
-bool worker::runnable::on_teardown() { return true; }
+bool worker::runnable::on_teardown(const cancellation_token &)
+{
+    return true;
+}
@@ -23,13 +23,19 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 // SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // ------------------------------------------------------------------
+#include "cancellation.h"
+#include "pool_allocator.h"
 #include "state.h"
 
-#include <atomic>
-
 namespace worker
 {
-    class runnable
+    ///
+    /// \brief Base class for the work done by a job.
+    ///
+    /// Runnables are created for every launch and destroyed by the
+    /// worker thread, so they are allocated from the pools.
+    ///
+    class runnable : public pooled
     {
     protected:
         runnable() = default;
@@ -44,12 +50,15 @@ namespace worker
          *        handled as if false (setup failed) was returned
          *        from this method.
          *
+         * @param cancellation  Set if the job is aborted.  Use its
+         *        sleep_for() and wait_for() to wait interruptibly.
+         *
          * @return True if setup was successful.  If setup was successful
          *        then on_working() will be called.  If not, on_working()
          *        will be skipped, on_teardown() will be called, and
          *        then the worker will stop.
          */
-        virtual bool on_setup();
+        virtual bool on_setup(const cancellation_token &cancellation);
 
         /**
          * @brief This method is a 'hook' for derived classes.  When
@@ -60,15 +69,15 @@ namespace worker
          *        handled as if false (working failed) was returned
          *        from this method.
          *
-         * @param keep_working  If cleared at any point, on_working
-         *        should detect this value and exit as soon as is
-         *        convenient.
+         * @param cancellation  If a stop is requested at any point,
+         *        on_working should detect this and exit as soon as
+         *        is convenient.  stop_requested() is cheap to poll.
          *
          * @return True if the task was completed successfully.
          *        Regardless of the outcome, on_teardown() will be
          *        called to clean up the worker state before exit.
          */
-        virtual bool on_working(std::atomic_flag &keep_working) = 0;
+        virtual bool on_working(const cancellation_token &cancellation) = 0;
 
         /**
          * @brief This method is a 'hook' for derived classes.  When
@@ -79,11 +88,14 @@ namespace worker
          *        handled as if false (working failed) was returned
          *        from this method.
          *
+         * @param cancellation  Set if the job was aborted.  Teardown
+         *        still runs, but may skip anything slow.
+         *
          * @return True if teardown was completed successfully.
          *        Regardless of the outcome, the worker will finish
          *        shortly after this step.
          */
-        virtual bool on_teardown();
+        virtual bool on_teardown(const cancellation_token &cancellation);
 
         // because of the "rule of 5", and I need a virtual destructor
         // for derivation, I have to define all of the below.  By
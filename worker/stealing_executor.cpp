@@ -0,0 +1,302 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "stealing_executor.h"
+#include "metrics.h"
+
+#include <stdexcept>
+
+namespace
+{
+    /// @brief The executor and deque owned by the calling thread.
+    struct current_worker_t
+    {
+        const worker::stealing_executor *owner;
+        std::size_t index;
+    };
+    thread_local current_worker_t current_worker = {nullptr, 0};
+}
+
+worker::stealing_executor::stealing_executor(std::size_t worker_count)
+    : m_deques(new std::atomic<deque_t *>[MAX_WORKERS]())
+{
+    set_worker_count(worker_count);
+}
+
+worker::stealing_executor::~stealing_executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    std::lock_guard<std::mutex> resize_lock(m_resize_mutex);
+    for (auto &thread : m_threads)
+    {
+        thread.join();
+    }
+
+    // Anything left over never runs.  Deleting the task breaks its
+    // promise, so nobody waits on it forever.
+    for (auto i = std::size_t{0}; i < m_deque_count; ++i)
+    {
+        while (auto task = m_deques[i].load()->take())
+        {
+            delete task;
+        }
+    }
+    for (auto task : m_inject)
+    {
+        delete task;
+    }
+}
+
+bool worker::stealing_executor::submit(task_t task, const task_schedule &)
+{
+    auto item = new task_t(std::move(task));
+    if (this == current_worker.owner)
+    {
+        m_deques[current_worker.index].load()->push(item);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_inject_mutex);
+        m_inject.push_back(item);
+        ++m_inject_size;
+    }
+
+    // Pairs with the fence in worker_main(), so either we see the
+    // sleeper or the sleeper sees the new task.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return wake_one();
+}
+
+void worker::stealing_executor::submit_many(std::vector<task_t> &tasks,
+                                            const task_schedule &)
+{
+    if (this == current_worker.owner)
+    {
+        auto &own = *m_deques[current_worker.index].load();
+        for (auto &task : tasks)
+        {
+            own.push(new task_t(std::move(task)));
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_inject_mutex);
+        for (auto &task : tasks)
+        {
+            m_inject.push_back(new task_t(std::move(task)));
+        }
+        m_inject_size += tasks.size();
+    }
+
+    // See submit().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (auto i = std::size_t{0}; i < tasks.size() && wake_one(); ++i)
+    {
+    }
+}
+
+std::size_t worker::stealing_executor::worker_count() const
+{
+    return m_target;
+}
+
+void worker::stealing_executor::set_worker_count(std::size_t count)
+{
+    if (0 == count || MAX_WORKERS < count)
+    {
+        throw std::invalid_argument("worker count must be between 1 and " +
+                                    std::to_string(MAX_WORKERS));
+    }
+
+    std::lock_guard<std::mutex> resize_lock(m_resize_mutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_target = count;
+    }
+
+    if (count < m_threads.size())
+    {
+        // Retired workers notice the new target and exit once they
+        // are done with whatever they are running now.
+        m_wake.notify_all();
+        for (auto i = count; i < m_threads.size(); ++i)
+        {
+            m_threads[i].join();
+        }
+        m_threads.resize(count);
+    }
+    else
+    {
+        for (auto i = m_threads.size(); i < count; ++i)
+        {
+            if (m_deque_count <= i)
+            {
+                m_deque_storage.emplace_back(new deque_t());
+                m_deques[i] = m_deque_storage.back().get();
+                m_deque_count = i + 1;
+            }
+            m_threads.emplace_back(&stealing_executor::worker_main, this, i);
+            place_thread(m_threads.back(), get_placement(i));
+        }
+    }
+}
+
+void worker::stealing_executor::place_workers()
+{
+    std::lock_guard<std::mutex> resize_lock(m_resize_mutex);
+    for (std::size_t i = 0; i < m_threads.size(); ++i)
+    {
+        place_thread(m_threads[i], get_placement(i));
+    }
+}
+
+void worker::stealing_executor::worker_main(std::size_t index)
+{
+    count_thread_at_scope counted;
+    current_worker = {this, index};
+    auto &own = *m_deques[index].load();
+
+    while (true)
+    {
+        auto task = find_task(index);
+        if (nullptr != task)
+        {
+            (*task)();
+            delete task;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stop || index >= m_target)
+        {
+            break;
+        }
+
+        ++m_sleeping;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (has_work())
+        {
+            // Something arrived while we were giving up.
+            --m_sleeping;
+            continue;
+        }
+
+        m_wake.wait(lock, [&] {
+            return 0 < m_tokens || m_stop || index >= m_target;
+        });
+        if (0 < m_tokens)
+        {
+            // submit() already took us off the sleeping count.
+            --m_tokens;
+        }
+        else
+        {
+            --m_sleeping;
+        }
+    }
+
+    // Retiring (or stopping), so hand our leftovers to the others.
+    current_worker = {nullptr, 0};
+    while (auto task = own.take())
+    {
+        std::lock_guard<std::mutex> lock(m_inject_mutex);
+        m_inject.push_back(task);
+        ++m_inject_size;
+    }
+    if (has_work())
+    {
+        wake_one();
+    }
+}
+
+worker::executor::task_t *
+worker::stealing_executor::find_task(std::size_t index)
+{
+    if (auto task = m_deques[index].load()->take())
+    {
+        return task;
+    }
+
+    if (0 < m_inject_size)
+    {
+        std::lock_guard<std::mutex> lock(m_inject_mutex);
+        if (!m_inject.empty())
+        {
+            auto task = m_inject.front();
+            m_inject.pop_front();
+            --m_inject_size;
+            return task;
+        }
+    }
+
+    const auto count = m_deque_count.load();
+    for (auto i = std::size_t{1}; i < count; ++i)
+    {
+        if (auto task = m_deques[(index + i) % count].load()->steal())
+        {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+bool worker::stealing_executor::has_work() const
+{
+    if (0 < m_inject_size)
+    {
+        return true;
+    }
+    const auto count = m_deque_count.load();
+    for (auto i = std::size_t{0}; i < count; ++i)
+    {
+        if (!m_deques[i].load()->empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool worker::stealing_executor::wake_one()
+{
+    if (0 == m_sleeping)
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (0 == m_sleeping)
+        {
+            return false;
+        }
+        --m_sleeping;
+        ++m_tokens;
+    }
+    m_wake.notify_one();
+    return true;
+}
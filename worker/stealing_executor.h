@@ -0,0 +1,104 @@
+#ifndef WORKER_STEALING_EXECUTOR_H
+#define WORKER_STEALING_EXECUTOR_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./executor.h"
+#include "./work_stealing_deque.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Executor where each worker has its own task deque.
+    ///
+    /// Tasks submitted from outside the executor go to a shared
+    /// injection queue.  Tasks submitted by a worker thread (for
+    /// example, a runnable that launches more work) go to the bottom
+    /// of that worker's own deque, which needs no lock.  A worker
+    /// runs its own newest task first, then the injection queue,
+    /// then steals the oldest task from another worker.  Task
+    /// priorities, deadlines and NUMA nodes are ignored, but workers
+    /// are placed by the affinity like the pool executor's.
+    ///
+    class stealing_executor final : public executor
+    {
+    public:
+        enum
+        {
+            MAX_WORKERS = 256
+        };
+
+        explicit stealing_executor(std::size_t worker_count);
+        ~stealing_executor();
+
+        virtual bool submit(task_t task,
+                            const task_schedule &schedule) override;
+        virtual void submit_many(std::vector<task_t> &tasks,
+                                 const task_schedule &schedule) override;
+        virtual std::size_t worker_count() const override;
+        virtual void set_worker_count(std::size_t count) override;
+        virtual void place_workers() override;
+
+    private:
+        typedef work_stealing_deque<task_t> deque_t;
+
+        void worker_main(std::size_t index);
+        task_t *find_task(std::size_t index);
+        bool has_work() const;
+        bool wake_one();
+
+        /// @brief One deque per worker ever started.  Slots are never
+        ///        freed, so thieves can read them without a lock.
+        std::unique_ptr<std::atomic<deque_t *>[]> m_deques = {};
+        std::vector<std::unique_ptr<deque_t>> m_deque_storage = {};
+        std::atomic<std::size_t> m_deque_count = {0};
+
+        mutable std::mutex m_inject_mutex = {};
+        std::deque<task_t *> m_inject = {};
+        std::atomic<std::size_t> m_inject_size = {0};
+
+        /// @brief Guards the sleep/wake bookkeeping below.
+        std::mutex m_mutex = {};
+        std::condition_variable m_wake = {};
+        /// @brief Workers waiting on m_wake and not yet claimed.
+        std::atomic<std::size_t> m_sleeping = {0};
+        /// @brief Sleepers claimed by submit(), not yet awake.
+        std::size_t m_tokens = 0;
+        /// @brief Workers with an index >= m_target exit.
+        std::atomic<std::size_t> m_target = {0};
+        bool m_stop = false;
+
+        /// @brief Serializes set_worker_count() (guards m_threads).
+        std::mutex m_resize_mutex = {};
+        std::vector<std::thread> m_threads = {};
+    };
+
+} // end namespace worker
+
+#endif // WORKER_STEALING_EXECUTOR_H
@@ -0,0 +1,41 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "stream_output.h"
+
+pybind11::module &
+worker::bind_worker_stream_output(pybind11::module &module)
+{
+    pybind11::enum_<overflow_policy>(module, "OverflowPolicy", R"pbdoc(
+What a Job's output stream does with a value when it is full.
+)pbdoc")
+        .value("BLOCK", overflow_policy::block,
+               "Wait for drain() to make room (or for the Job to abort)")
+        .value("DROP_OLDEST", overflow_policy::drop_oldest,
+               "Discard the oldest value that has not been drained")
+        .value("DROP_NEWEST", overflow_policy::drop_newest,
+               "Discard the new value");
+
+    bind_stream_output<int>(module, "_IntStreamOutput");
+    return module;
+}
@@ -0,0 +1,263 @@
+#ifndef WORKER_STREAM_OUTPUT_H
+#define WORKER_STREAM_OUTPUT_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Job output that streams every value a runnable produces.
+    ///
+    /// The runnable calls push() from its worker thread; Python calls
+    /// drain() to collect the values in batches.  Derive an output
+    /// struct from this to give it a stream.
+    ///
+    /// With overflow_policy::block, a push into a full stream spins
+    /// briefly, then sleeps until drain() makes room (as stage_queue
+    /// does), so a slow consumer doesn't cost a worker a whole core.
+    ///
+    template <typename T> class stream_output
+    {
+    public:
+        explicit stream_output(std::size_t capacity = 1024,
+                               overflow_policy policy =
+                                   overflow_policy::drop_oldest)
+            : m_ring(capacity, policy)
+        {
+        }
+
+        virtual ~stream_output() = default;
+
+        /**
+         * @brief Add a value.  With overflow_policy::block, waits
+         *        (while keep_waiting() is true) for room.
+         * @return True if the value was added.
+         */
+        template <typename Predicate>
+        bool push(const T &item, Predicate keep_waiting)
+        {
+            if (overflow_policy::block != m_ring.policy())
+            {
+                return m_ring.push(item, keep_waiting);
+            }
+            while (!m_ring.push(item, [] { return false; }))
+            {
+                if (!wait_for_room(keep_waiting))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool push(const T &item)
+        {
+            return push(item, [] { return true; });
+        }
+
+        /**
+         * @brief Add a batch of values.  With overflow_policy::block,
+         *        waits (while keep_waiting() is true) for room.
+         * @return The number of values added or dropped.
+         */
+        template <typename Predicate>
+        std::size_t push_many(const T *items, std::size_t count,
+                              Predicate keep_waiting)
+        {
+            auto done = m_ring.push_many(items, count);
+            while (done < count && wait_for_room(keep_waiting))
+            {
+                done += m_ring.push_many(items + done, count - done);
+            }
+            return done;
+        }
+
+        ///
+        /// @brief Remove up to 'max_items' values as a Python list.
+        ///        Safe from any number of Python threads: drains take
+        ///        turns, and build their lists after their turn.
+        ///
+        pybind11::list drain(std::size_t max_items)
+        {
+            std::vector<T> items;
+            std::size_t count = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_drain_mutex);
+                items.resize(std::min(max_items, m_ring.size()));
+                count = m_ring.drain(items.data(), items.size());
+            }
+            if (0 < count)
+            {
+                wake();
+            }
+            pybind11::list result(count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                PyList_SET_ITEM(result.ptr(), static_cast<Py_ssize_t>(i),
+                                pybind11::cast(items[i]).release().ptr());
+            }
+            return result;
+        }
+
+        const ring_buffer<T> &stream() const { return m_ring; }
+
+        stream_output(const stream_output &) = delete;
+        stream_output(stream_output &&) = delete;
+        stream_output &operator=(const stream_output &) = delete;
+        stream_output &operator=(stream_output &&) = delete;
+
+    private:
+        enum
+        {
+            SPIN_COUNT = 64
+        };
+
+        /// @brief Wait for drain() to make room, unless keep_waiting()
+        ///        returns false first.  Producer only.
+        template <typename Predicate> bool wait_for_room(Predicate keep_waiting)
+        {
+            const auto room = [this] {
+                return m_ring.size() < m_ring.capacity();
+            };
+            // A consumer that keeps up is only a batch behind.
+            for (int i = 0; i < SPIN_COUNT; ++i)
+            {
+                if (!keep_waiting())
+                {
+                    return false;
+                }
+                if (room())
+                {
+                    return true;
+                }
+                std::this_thread::yield();
+            }
+
+            m_sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                // The timeout is only a backstop, and how an abort
+                // is noticed.
+                std::unique_lock<std::mutex> lock(m_room_mutex);
+                m_room.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                    return !keep_waiting() || room();
+                });
+            }
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return keep_waiting();
+        }
+
+        /// @brief Wake a producer waiting for room, if there is one.
+        void wake()
+        {
+            // Pairs with the fence in wait_for_room(): either the
+            // sleeper sees the room, or we see the sleeper.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (0 < m_sleepers.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(m_room_mutex);
+                m_room.notify_all();
+            }
+        }
+
+        ring_buffer<T> m_ring;
+        /// @brief Keeps the ring to one consumer at a time.
+        std::mutex m_drain_mutex = {};
+        std::atomic<int> m_sleepers = {0};
+        std::mutex m_room_mutex = {};
+        std::condition_variable m_room = {};
+    };
+
+    ///
+    /// @brief Bind stream_output<T> as a Python base class for outputs.
+    ///
+    template <typename T>
+    pybind11::module &bind_stream_output(pybind11::module &module,
+                                         const char *name)
+    {
+        typedef stream_output<T> stream_t;
+        pybind11::class_<stream_t, std::shared_ptr<stream_t>> obj(module,
+                                                                  name);
+        obj.def(
+            "drain",
+            [](stream_t &self, pybind11::object max_items) {
+                return self.drain(max_items.is_none()
+                                      ? self.stream().capacity()
+                                      : max_items.cast<std::size_t>());
+            },
+            pybind11::arg("max_items") = pybind11::none(),
+            R"pbdoc(
+Remove and return the oldest values the Job has produced.
+
+Parameters
+----------
+max_items: The most values to return (default: all available).
+
+Returns
+-------
+A list, oldest value first.  Empty if nothing is waiting.
+)pbdoc");
+        obj.def_property_readonly(
+            "capacity",
+            [](const stream_t &self) { return self.stream().capacity(); },
+            "The most values held before the overflow policy applies");
+        obj.def_property_readonly(
+            "overflow",
+            [](const stream_t &self) { return self.stream().policy(); },
+            "The OverflowPolicy used when the stream is full");
+        obj.def_property_readonly(
+            "pending",
+            [](const stream_t &self) { return self.stream().size(); },
+            "The number of values waiting to be drained");
+        obj.def_property_readonly(
+            "pushed",
+            [](const stream_t &self) { return self.stream().pushed(); },
+            "The number of values the Job has added");
+        obj.def_property_readonly(
+            "dropped",
+            [](const stream_t &self) { return self.stream().dropped(); },
+            "The number of values lost because the stream was full");
+        obj.def_property_readonly(
+            "drained",
+            [](const stream_t &self) { return self.stream().drained(); },
+            "The number of values returned by drain()");
+        return module;
+    }
+
+    pybind11::module &bind_worker_stream_output(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_STREAM_OUTPUT_H
@@ -0,0 +1,101 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "task_queue.h"
+
+#include <algorithm>
+
+namespace
+{
+    /// @brief Heap order: the earliest deadline (then the oldest) on top.
+    template <typename Entry> bool later(const Entry &lhs, const Entry &rhs)
+    {
+        return lhs.deadline != rhs.deadline ? lhs.deadline > rhs.deadline
+                                            : lhs.sequence > rhs.sequence;
+    }
+}
+
+void worker::task_queue::push(task_t task, const task_schedule &schedule)
+{
+    auto &level = m_levels[static_cast<int>(schedule.level)];
+    if (std::chrono::steady_clock::time_point::max() == schedule.deadline)
+    {
+        level.fifo.push_back(std::move(task));
+    }
+    else
+    {
+        level.deadlines.push_back(
+            deadline_entry{schedule.deadline, m_sequence++, std::move(task)});
+        std::push_heap(level.deadlines.begin(), level.deadlines.end(),
+                       later<deadline_entry>);
+    }
+    ++m_size;
+}
+
+worker::task_queue::task_t worker::task_queue::pop()
+{
+    // The lowest starving level, or else the highest with work.
+    auto chosen = -1;
+    for (auto i = 0; i < PRIORITY_COUNT; ++i)
+    {
+        const auto &level = m_levels[i];
+        if (!level.empty())
+        {
+            chosen = i;
+            if (STARVATION_LIMIT <= level.passed_over)
+            {
+                break;
+            }
+        }
+    }
+
+    for (auto i = 0; i < PRIORITY_COUNT; ++i)
+    {
+        auto &level = m_levels[i];
+        if (i == chosen)
+        {
+            level.passed_over = 0;
+        }
+        else if (!level.empty())
+        {
+            ++level.passed_over;
+        }
+    }
+
+    auto &level = m_levels[chosen];
+    task_t result;
+    if (!level.deadlines.empty())
+    {
+        std::pop_heap(level.deadlines.begin(), level.deadlines.end(),
+                      later<deadline_entry>);
+        result = std::move(level.deadlines.back().task);
+        level.deadlines.pop_back();
+    }
+    else
+    {
+        result = std::move(level.fifo.front());
+        level.fifo.pop_front();
+    }
+    --m_size;
+    return result;
+}
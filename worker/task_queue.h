@@ -0,0 +1,98 @@
+#ifndef WORKER_TASK_QUEUE_H
+#define WORKER_TASK_QUEUE_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "./executor.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Queue of tasks ordered by priority, then deadline.
+    ///
+    /// Higher priorities are served first, but a priority that has
+    /// been passed over STARVATION_LIMIT times in a row (while it had
+    /// tasks waiting) is served next, so low-priority work always
+    /// makes progress.  Within a priority, tasks with deadlines go
+    /// earliest deadline first, then the rest in FIFO order.
+    ///
+    /// Not thread-safe; the executor guards it with its own mutex.
+    ///
+    class task_queue
+    {
+    public:
+        typedef executor::task_t task_t;
+
+        enum
+        {
+            STARVATION_LIMIT = 16
+        };
+
+        task_queue() = default;
+
+        void push(task_t task, const task_schedule &schedule);
+
+        /// @brief Remove the task to run next.  Must not be empty.
+        task_t pop();
+
+        bool empty() const { return 0 == m_size; }
+        std::size_t size() const { return m_size; }
+
+        task_queue(const task_queue &) = delete;
+        task_queue(task_queue &&) = delete;
+        task_queue &operator=(const task_queue &) = delete;
+        task_queue &operator=(task_queue &&) = delete;
+
+    private:
+        struct deadline_entry
+        {
+            std::chrono::steady_clock::time_point deadline;
+            std::uint64_t sequence;
+            task_t task;
+        };
+
+        struct level_t
+        {
+            /// @brief Tasks without a deadline, oldest first.
+            std::deque<task_t> fifo = {};
+            /// @brief Tasks with a deadline, as a heap.
+            std::vector<deadline_entry> deadlines = {};
+            /// @brief Times another level was served while this one
+            ///        had tasks waiting.
+            std::size_t passed_over = 0;
+
+            bool empty() const { return fifo.empty() && deadlines.empty(); }
+        };
+
+        level_t m_levels[PRIORITY_COUNT];
+        std::uint64_t m_sequence = 0;
+        std::size_t m_size = 0;
+    };
+
+} // end namespace worker
+
+#endif // WORKER_TASK_QUEUE_H
@@ -0,0 +1,124 @@
+#ifndef WORKER_THREAD_SHARDS_H
+#define WORKER_THREAD_SHARDS_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include <mutex>
+
+namespace worker
+{
+    ///
+    /// \brief One Shard per thread, for statistics each thread writes
+    ///        without contention and readers merge.
+    ///
+    /// local() returns the calling thread's shard; for_each() visits
+    /// every shard.  Shard should be a struct of atomics that its
+    /// owner updates with relaxed (or release) load/store pairs.
+    /// Shards are never freed: when a thread exits, its shard (and
+    /// what it counted) passes to the next new thread, so the number
+    /// of shards is the most threads ever alive at once.
+    ///
+    template <typename Shard> class thread_shards
+    {
+    public:
+        static Shard &local()
+        {
+            thread_local owner_t owner;
+            return owner.shard();
+        }
+
+        template <typename Function> static void for_each(Function function)
+        {
+            auto &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (auto node = reg.nodes; node; node = node->next)
+            {
+                function(node->shard);
+            }
+        }
+
+    private:
+        struct node_t
+        {
+            Shard shard;
+            node_t *next;
+            node_t *next_free;
+        };
+
+        struct registry_t
+        {
+            std::mutex mutex = {};
+            node_t *nodes = {nullptr};
+            node_t *free_nodes = {nullptr};
+        };
+
+        static registry_t &registry()
+        {
+            static auto result = new registry_t;
+            return *result;
+        }
+
+        class owner_t
+        {
+        public:
+            owner_t() : m_node(nullptr)
+            {
+                auto &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                if (reg.free_nodes)
+                {
+                    m_node = reg.free_nodes;
+                    reg.free_nodes = m_node->next_free;
+                }
+                else
+                {
+                    // Value-initialized, so the shard starts zeroed.
+                    m_node = new node_t();
+                    m_node->next = reg.nodes;
+                    reg.nodes = m_node;
+                }
+            }
+
+            ~owner_t()
+            {
+                auto &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                m_node->next_free = reg.free_nodes;
+                reg.free_nodes = m_node;
+            }
+
+            Shard &shard() { return m_node->shard; }
+
+            owner_t(const owner_t &) = delete;
+            owner_t(owner_t &&) = delete;
+            owner_t &operator=(const owner_t &) = delete;
+            owner_t &operator=(owner_t &&) = delete;
+
+        private:
+            node_t *m_node;
+        };
+    };
+
+} // end namespace worker
+
+#endif // WORKER_THREAD_SHARDS_H
@@ -0,0 +1,458 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "topology.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    struct cpu_t
+    {
+        int cpu;
+        int node;
+        /// @brief CPUs with the same core share it.
+        int core;
+    };
+
+    /**
+     * @brief Parse a Linux CPU (or node) list such as "0-3,8,10-11".
+     */
+    std::vector<int> parse_list(const std::string &text)
+    {
+        std::vector<int> result;
+        std::stringstream items(text);
+        std::string item;
+        while (std::getline(items, item, ','))
+        {
+            const auto dash = item.find('-');
+            try
+            {
+                const auto first = std::stoi(item.substr(0, dash));
+                const auto last = std::string::npos == dash
+                                      ? first
+                                      : std::stoi(item.substr(dash + 1));
+                for (auto cpu = first; cpu <= last; ++cpu)
+                {
+                    result.push_back(cpu);
+                }
+            }
+            catch (const std::exception &)
+            {
+                // Blank (a node without CPUs) or garbled: skip it.
+            }
+        }
+        return result;
+    }
+
+    std::string read_line(const std::string &path)
+    {
+        std::ifstream file(path);
+        std::string result;
+        std::getline(file, result);
+        return result;
+    }
+
+    ///
+    /// \brief The CPUs the process may use, found once.
+    ///
+    struct topology_t
+    {
+        /// @brief Spread order: alternating nodes, and every core
+        ///        once before the second hardware thread of any.
+        std::vector<cpu_t> cpus = {};
+        /// @brief Nodes with usable CPUs, in order.
+        std::vector<int> nodes = {};
+
+        topology_t()
+        {
+            std::vector<int> usable;
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (0 == sched_getaffinity(0, sizeof(set), &set))
+            {
+                for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                {
+                    if (CPU_ISSET(cpu, &set))
+                    {
+                        usable.push_back(cpu);
+                    }
+                }
+            }
+#endif
+            if (usable.empty())
+            {
+                const auto count =
+                    std::max(1u, std::thread::hardware_concurrency());
+                for (auto cpu = 0; cpu < static_cast<int>(count); ++cpu)
+                {
+                    usable.push_back(cpu);
+                }
+            }
+
+            std::map<int, int> node_of;
+            const std::string nodes_path = "/sys/devices/system/node/";
+            for (auto node : parse_list(read_line(nodes_path + "online")))
+            {
+                const auto list = read_line(
+                    nodes_path + "node" + std::to_string(node) + "/cpulist");
+                for (auto cpu : parse_list(list))
+                {
+                    node_of[cpu] = node;
+                }
+            }
+
+            // Cores are numbered per package, so key on both.
+            std::map<std::pair<int, int>, int> core_ids;
+            std::vector<cpu_t> found;
+            const std::string cpus_path = "/sys/devices/system/cpu/cpu";
+            for (auto cpu : usable)
+            {
+                const auto topology =
+                    cpus_path + std::to_string(cpu) + "/topology/";
+                const auto package =
+                    read_line(topology + "physical_package_id");
+                const auto core = read_line(topology + "core_id");
+                auto key = std::make_pair(-1, -1 - cpu);
+                if (!package.empty() && !core.empty())
+                {
+                    key = std::make_pair(std::atoi(package.c_str()),
+                                         std::atoi(core.c_str()));
+                }
+                const auto id = static_cast<int>(core_ids.size());
+                const auto node = node_of.find(cpu);
+                found.push_back(
+                    {cpu, node_of.end() == node ? 0 : node->second,
+                     core_ids.emplace(key, id).first->second});
+            }
+
+            for (const auto &cpu : found)
+            {
+                if (nodes.end() == std::find(nodes.begin(), nodes.end(),
+                                             cpu.node))
+                {
+                    nodes.push_back(cpu.node);
+                }
+            }
+            std::sort(nodes.begin(), nodes.end());
+
+            // Rank each CPU among the others on its core (0 for the
+            // first hardware thread) and on its node, then sort by
+            // (core rank, node rank, node).
+            std::map<int, int> core_seen;
+            std::map<std::pair<int, int>, int> node_seen;
+            std::vector<std::pair<std::pair<int, int>, cpu_t>> ranked;
+            for (const auto &cpu : found)
+            {
+                const auto core_rank = core_seen[cpu.core]++;
+                const auto node_rank = node_seen[{cpu.node, core_rank}]++;
+                ranked.push_back({{core_rank, node_rank}, cpu});
+            }
+            std::stable_sort(
+                ranked.begin(), ranked.end(),
+                [](const std::pair<std::pair<int, int>, cpu_t> &left,
+                   const std::pair<std::pair<int, int>, cpu_t> &right) {
+                    return std::make_pair(left.first, left.second.node) <
+                           std::make_pair(right.first, right.second.node);
+                });
+            for (const auto &item : ranked)
+            {
+                cpus.push_back(item.second);
+            }
+        }
+    };
+
+    const topology_t &topology()
+    {
+        static const topology_t result;
+        return result;
+    }
+
+    struct settings_t
+    {
+        std::mutex mutex = {};
+        worker::affinity kind = worker::affinity::none;
+        /// @brief The CPUs to use, in spread order.
+        std::vector<cpu_t> cpus = topology().cpus;
+        /// @brief True if the CPUs were chosen by set_affinity().
+        bool restricted = false;
+    };
+
+    settings_t &settings()
+    {
+        // Leaked, like the executor registry that uses it.
+        static auto result = new settings_t();
+        return *result;
+    }
+
+#ifdef __linux__
+    bool pin(pthread_t thread, const worker::placement &where)
+    {
+        auto cpus = where.cpus;
+        if (cpus.empty())
+        {
+            for (const auto &cpu : topology().cpus)
+            {
+                cpus.push_back(cpu.cpu);
+            }
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : cpus)
+        {
+            CPU_SET(cpu, &set);
+        }
+        return 0 == pthread_setaffinity_np(thread, sizeof(set), &set);
+    }
+#endif
+}
+
+std::size_t worker::numa_node_count()
+{
+    return topology().nodes.size();
+}
+
+std::vector<int> worker::numa_node_cpus(int node)
+{
+    std::vector<int> result;
+    for (const auto &cpu : topology().cpus)
+    {
+        if (-1 == node || node == cpu.node)
+        {
+            result.push_back(cpu.cpu);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+int worker::current_numa_node()
+{
+#ifdef __linux__
+    const auto current = sched_getcpu();
+    for (const auto &cpu : topology().cpus)
+    {
+        if (current == cpu.cpu)
+        {
+            return cpu.node;
+        }
+    }
+#endif
+    return -1;
+}
+
+worker::placement worker::get_placement(std::size_t index)
+{
+    auto &config = settings();
+    std::lock_guard<std::mutex> lock(config.mutex);
+    const auto &cpus = config.cpus;
+    placement result;
+    switch (config.kind)
+    {
+    case affinity::none:
+        if (config.restricted)
+        {
+            for (const auto &cpu : cpus)
+            {
+                result.cpus.push_back(cpu.cpu);
+            }
+        }
+        break;
+    case affinity::cpu:
+    {
+        const auto &cpu = cpus[index % cpus.size()];
+        result.cpus.push_back(cpu.cpu);
+        result.node = cpu.node;
+        break;
+    }
+    case affinity::core:
+    {
+        // The index-th distinct core, in spread order.
+        std::vector<int> cores;
+        for (const auto &cpu : cpus)
+        {
+            if (cores.end() == std::find(cores.begin(), cores.end(), cpu.core))
+            {
+                cores.push_back(cpu.core);
+            }
+        }
+        const auto core = cores[index % cores.size()];
+        for (const auto &cpu : cpus)
+        {
+            if (core == cpu.core)
+            {
+                result.cpus.push_back(cpu.cpu);
+                result.node = cpu.node;
+            }
+        }
+        break;
+    }
+    case affinity::node:
+    {
+        std::vector<int> nodes;
+        for (const auto &cpu : cpus)
+        {
+            if (nodes.end() == std::find(nodes.begin(), nodes.end(), cpu.node))
+            {
+                nodes.push_back(cpu.node);
+            }
+        }
+        std::sort(nodes.begin(), nodes.end());
+        result.node = nodes[index % nodes.size()];
+        for (const auto &cpu : cpus)
+        {
+            if (result.node == cpu.node)
+            {
+                result.cpus.push_back(cpu.cpu);
+            }
+        }
+        break;
+    }
+    }
+    return result;
+}
+
+worker::placement worker::get_node_placement(int node)
+{
+    placement result;
+    for (const auto &cpu : topology().cpus)
+    {
+        if (node == cpu.node)
+        {
+            result.cpus.push_back(cpu.cpu);
+            result.node = node;
+        }
+    }
+    return result;
+}
+
+bool worker::place_thread(std::thread &thread, const placement &where)
+{
+#ifdef __linux__
+    return pin(thread.native_handle(), where);
+#else
+    (void)thread;
+    (void)where;
+    return false;
+#endif
+}
+
+bool worker::place_this_thread(const placement &where)
+{
+#ifdef __linux__
+    return pin(pthread_self(), where);
+#else
+    (void)where;
+    return false;
+#endif
+}
+
+worker::affinity worker::get_affinity()
+{
+    auto &config = settings();
+    std::lock_guard<std::mutex> lock(config.mutex);
+    return config.kind;
+}
+
+void worker::set_affinity(affinity kind, const std::vector<int> &cpus)
+{
+    auto chosen = topology().cpus;
+    if (!cpus.empty())
+    {
+        chosen.clear();
+        for (auto wanted : cpus)
+        {
+            for (const auto &cpu : topology().cpus)
+            {
+                if (wanted == cpu.cpu)
+                {
+                    chosen.push_back(cpu);
+                }
+            }
+        }
+        if (chosen.empty())
+        {
+            throw std::invalid_argument(
+                "none of the CPUs given may be used by this process");
+        }
+    }
+
+    auto &config = settings();
+    std::lock_guard<std::mutex> lock(config.mutex);
+    config.kind = kind;
+    config.cpus = std::move(chosen);
+    config.restricted = !cpus.empty();
+}
+
+pybind11::module &worker::bind_worker_topology(pybind11::module &module)
+{
+    pybind11::enum_<affinity>(module, "Affinity", R"pbdoc(
+Where Executor.POOL and Executor.STEALING put their threads.
+)pbdoc")
+        .value("NONE", affinity::none, "Wherever the OS likes (the default)")
+        .value("CPU", affinity::cpu, "Pin each thread to one CPU")
+        .value("CORE", affinity::core,
+               "Pin each thread to one core, with all its hardware threads")
+        .value("NODE", affinity::node,
+               "Spread threads over the NUMA nodes, free within their own");
+
+    module.def("numa_node_count", &numa_node_count, R"pbdoc(
+Return the number of NUMA nodes with CPUs this process may use: 1 on
+machines without NUMA.
+)pbdoc");
+    module.def(
+        "numa_node_cpus",
+        [](pybind11::object node) {
+            pybind11::list result;
+            for (auto cpu :
+                 numa_node_cpus(node.is_none() ? -1 : node.cast<int>()))
+            {
+                result.append(pybind11::int_(cpu));
+            }
+            return result;
+        },
+        R"pbdoc(
+Return the CPUs of a NUMA node (or, for None, every CPU) that this
+process may use, as a sorted list.
+)pbdoc",
+        pybind11::arg("node") = pybind11::none());
+    module.def("current_numa_node", &current_numa_node, R"pbdoc(
+Return the NUMA node the calling thread is running on, or -1 if that
+can't be told.
+)pbdoc");
+    return module;
+}
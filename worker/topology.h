@@ -0,0 +1,113 @@
+#ifndef WORKER_TOPOLOGY_H
+#define WORKER_TOPOLOGY_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Where pooled executors put their worker threads.
+    ///
+    enum class affinity
+    {
+        none, ///< Wherever the OS likes
+        cpu,  ///< Each worker pinned to one CPU
+        core, ///< Each worker pinned to one core (all its hardware threads)
+        node  ///< Workers spread over the NUMA nodes, free within theirs
+    };
+
+    ///
+    /// \brief The CPUs a worker may run on, and its NUMA node.
+    ///
+    struct placement
+    {
+        /// @brief Empty for every CPU the process may use.
+        std::vector<int> cpus = {};
+        /// @brief The node every CPU is on, or -1 if they aren't on one.
+        int node = -1;
+    };
+
+    /**
+     * @brief Return the number of NUMA nodes with CPUs the process
+     *        may use.  1 where there is no NUMA information.
+     */
+    std::size_t numa_node_count();
+
+    /**
+     * @brief Return the CPUs of a NUMA node that the process may use,
+     *        or every usable CPU for node -1.
+     */
+    std::vector<int> numa_node_cpus(int node);
+
+    /**
+     * @brief Return the NUMA node the calling thread is running on
+     *        (which may change unless it is pinned), or -1.
+     */
+    int current_numa_node();
+
+    /**
+     * @brief Return the placement of worker 'index' of a pooled
+     *        executor under the current affinity.
+     */
+    placement get_placement(std::size_t index);
+
+    /**
+     * @brief Return the placement of a thread asked to run on a NUMA
+     *        node, whatever the affinity.  Not on a node (node -1)
+     *        unless 'node' has usable CPUs.
+     */
+    placement get_node_placement(int node);
+
+    /**
+     * @brief Restrict a thread to the CPUs of a placement.
+     * @return False if the OS refused (or can't pin threads).
+     */
+    bool place_thread(std::thread &thread, const placement &where);
+
+    /// @brief Restrict the calling thread to the CPUs of a placement.
+    bool place_this_thread(const placement &where);
+
+    affinity get_affinity();
+
+    /**
+     * @brief Set the affinity used to place workers from now on.
+     * @param kind How to place them.
+     * @param cpus If not empty, the only CPUs to use, in this order
+     *        (CPUs the process may not use are left out).
+     * @throws std::invalid_argument if none of 'cpus' may be used.
+     *
+     *         Doesn't move running workers: see set_worker_affinity().
+     */
+    void set_affinity(affinity kind, const std::vector<int> &cpus);
+
+    pybind11::module &bind_worker_topology(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_TOPOLOGY_H
@@ -0,0 +1,342 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "trace.h"
+#include "thread_shards.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> worker::trace_enabled = {false};
+
+namespace
+{
+    enum
+    {
+        /// @brief Events kept per thread; later ones are dropped.
+        TRACE_BUFFER_EVENTS = 1 << 14
+    };
+
+    struct event_t
+    {
+        std::uint64_t ns;
+        const void *id;
+        worker::trace_kind kind;
+        std::uint32_t detail;
+    };
+
+    ///
+    /// \brief One thread's events.  The owner writes an event past
+    ///        'size' and then publishes it; readers copy [0, size).
+    ///
+    struct trace_shard
+    {
+        std::atomic<std::uint64_t> size;
+        std::atomic<std::uint64_t> dropped;
+        std::atomic<std::uint32_t> slot;
+        event_t events[TRACE_BUFFER_EVENTS];
+    };
+    typedef worker::thread_shards<trace_shard> shards_t;
+
+    std::atomic<std::uint32_t> next_slot = {1};
+
+    std::uint64_t now_ns()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    struct recorded_t
+    {
+        event_t event;
+        std::uint32_t tid;
+    };
+
+    const char *state_name(std::uint32_t state)
+    {
+        switch (static_cast<worker::state>(state))
+        {
+        case worker::state::not_started:
+            return "not_started";
+        case worker::state::setup:
+            return "setup";
+        case worker::state::working:
+            return "working";
+        case worker::state::teardown:
+            return "teardown";
+        case worker::state::complete:
+            return "complete";
+        case worker::state::incomplete:
+            break;
+        }
+        return "incomplete";
+    }
+
+    ///
+    /// \brief Writes trace-event JSON objects, comma-separated.
+    ///
+    class trace_writer
+    {
+    public:
+        trace_writer(std::ostream &out, std::uint64_t origin)
+            : m_out(out), m_origin(origin)
+        {
+        }
+
+        /// @brief Start an event: phase, name, timestamp and thread.
+        std::ostream &begin(char phase, const char *name, std::uint64_t ns,
+                            std::uint32_t tid)
+        {
+            m_out << (m_count++ ? ",\n" : "\n") << "{\"ph\": \"" << phase
+                  << "\", \"name\": \"" << name
+                  << "\", \"pid\": 1, \"tid\": " << tid
+                  << ", \"ts\": " << (ns - m_origin) / 1000.0;
+            return m_out;
+        }
+
+        std::ostream &id(const void *id)
+        {
+            return m_out << ", \"id\": \"" << id << "\"";
+        }
+
+        std::size_t count() const { return m_count; }
+
+        trace_writer(const trace_writer &) = delete;
+        trace_writer(trace_writer &&) = delete;
+        trace_writer &operator=(const trace_writer &) = delete;
+        trace_writer &operator=(trace_writer &&) = delete;
+
+    private:
+        std::ostream &m_out;
+        std::uint64_t m_origin;
+        std::size_t m_count = {0};
+    };
+}
+
+void worker::trace_event(trace_kind kind, const void *id,
+                         std::uint32_t detail)
+{
+    auto &shard = shards_t::local();
+    if (0 == shard.slot.load(std::memory_order_relaxed))
+    {
+        shard.slot.store(next_slot.fetch_add(1), std::memory_order_relaxed);
+    }
+    const auto size = shard.size.load(std::memory_order_relaxed);
+    if (TRACE_BUFFER_EVENTS <= size)
+    {
+        shard.dropped.store(shard.dropped.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        return;
+    }
+    shard.events[size] = {now_ns(), id, kind, detail};
+    shard.size.store(size + 1, std::memory_order_release);
+}
+
+void worker::start_tracing() { trace_enabled = true; }
+
+void worker::stop_tracing() { trace_enabled = false; }
+
+void worker::clear_trace()
+{
+    shards_t::for_each([](trace_shard &shard) {
+        shard.size.store(0, std::memory_order_relaxed);
+        shard.dropped.store(0, std::memory_order_relaxed);
+    });
+}
+
+std::size_t worker::dump_trace(const std::string &path)
+{
+    std::vector<recorded_t> recorded;
+    std::vector<std::uint32_t> tids;
+    std::uint64_t dropped = 0;
+    shards_t::for_each([&](const trace_shard &shard) {
+        const auto size = shard.size.load(std::memory_order_acquire);
+        const auto tid = shard.slot.load(std::memory_order_relaxed);
+        for (std::uint64_t i = 0; i < size; ++i)
+        {
+            recorded.push_back({shard.events[i], tid});
+        }
+        if (0 < size)
+        {
+            tids.push_back(tid);
+        }
+        dropped += shard.dropped.load(std::memory_order_relaxed);
+    });
+    std::stable_sort(recorded.begin(), recorded.end(),
+                     [](const recorded_t &lhs, const recorded_t &rhs) {
+                         return lhs.event.ns < rhs.event.ns;
+                     });
+
+    std::ofstream out(path);
+    if (!out)
+    {
+        throw std::runtime_error("Unable to open trace file: " + path);
+    }
+    const auto origin = recorded.empty() ? 0 : recorded.front().event.ns;
+    trace_writer writer(out, origin);
+    out << "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped\": "
+        << dropped << "}, \"traceEvents\": [";
+
+    for (auto tid : tids)
+    {
+        writer.begin('M', "thread_name", origin, tid)
+            << ", \"args\": {\"name\": \"gild thread " << tid << "\"}}";
+    }
+
+    // Each job is an async span from launch to finish (with its
+    // queued time nested in it), and each phase that ran on a thread
+    // is a complete event on that thread.
+    struct open_phase_t
+    {
+        std::uint64_t ns;
+        std::uint32_t tid;
+        std::uint32_t state;
+    };
+    std::map<const void *, open_phase_t> phases;
+    std::map<const void *, bool> queued;
+    std::map<std::uint32_t, std::vector<std::uint64_t>> waits;
+
+    for (const auto &item : recorded)
+    {
+        const auto &event = item.event;
+        switch (event.kind)
+        {
+        case trace_kind::launch:
+            writer.begin('b', "job", event.ns, item.tid)
+                << ", \"cat\": \"job\"";
+            writer.id(event.id) << "}";
+            writer.begin('b', "queued", event.ns, item.tid)
+                << ", \"cat\": \"job\"";
+            writer.id(event.id) << "}";
+            queued[event.id] = true;
+            break;
+
+        case trace_kind::state:
+        {
+            auto found = queued.find(event.id);
+            if (queued.end() != found && found->second)
+            {
+                writer.begin('e', "queued", event.ns, item.tid)
+                    << ", \"cat\": \"job\"";
+                writer.id(event.id) << "}";
+                found->second = false;
+            }
+            auto open = phases.find(event.id);
+            if (phases.end() != open)
+            {
+                writer.begin('X', state_name(open->second.state),
+                             open->second.ns, open->second.tid)
+                    << ", \"cat\": \"phase\", \"dur\": "
+                    << (event.ns - open->second.ns) / 1000.0
+                    << ", \"args\": {\"job\": \"" << event.id << "\"}}";
+                phases.erase(open);
+            }
+            switch (static_cast<worker::state>(event.detail))
+            {
+            case worker::state::setup:
+            case worker::state::working:
+            case worker::state::teardown:
+                phases[event.id] = {event.ns, item.tid, event.detail};
+                break;
+            case worker::state::not_started:
+                break;
+            case worker::state::complete:
+            case worker::state::incomplete:
+                if (queued.end() != found)
+                {
+                    writer.begin('e', "job", event.ns, item.tid)
+                        << ", \"cat\": \"job\"";
+                    writer.id(event.id)
+                        << ", \"args\": {\"state\": \""
+                        << state_name(event.detail) << "\"}}";
+                    queued.erase(found);
+                }
+                break;
+            }
+            break;
+        }
+
+        case trace_kind::abort:
+            writer.begin('i', "abort", event.ns, item.tid)
+                << ", \"s\": \"t\", \"args\": {\"job\": \"" << event.id
+                << "\"}}";
+            break;
+
+        case trace_kind::wait_begin:
+            waits[item.tid].push_back(event.ns);
+            break;
+
+        case trace_kind::wait_end:
+        {
+            auto &stack = waits[item.tid];
+            if (!stack.empty())
+            {
+                writer.begin('X', "wait", stack.back(), item.tid)
+                    << ", \"cat\": \"wait\", \"dur\": "
+                    << (event.ns - stack.back()) / 1000.0 << "}";
+                stack.pop_back();
+            }
+            break;
+        }
+        }
+    }
+    out << "\n]}\n";
+    if (!out)
+    {
+        throw std::runtime_error("Unable to write trace file: " + path);
+    }
+    return writer.count();
+}
+
+pybind11::module &worker::bind_worker_trace(pybind11::module &module)
+{
+    auto trace = module.def_submodule("trace", R"pbdoc(
+Opt-in tracing of Job lifecycles, for chrome://tracing or Perfetto.
+
+    gild.trace.start()
+    ...launch and wait for Jobs...
+    gild.trace.stop()
+    gild.trace.dump('jobs.json')
+
+Launches, state changes, aborts and waits are recorded into
+per-thread buffers.  Each thread keeps its first 16384 events; later
+ones are counted as dropped.
+)pbdoc");
+    trace.def("start", &worker::start_tracing, "Start recording events");
+    trace.def("stop", &worker::stop_tracing, "Stop recording events");
+    trace.def("enabled", &worker::tracing, "True if recording events");
+    trace.def("clear", &worker::clear_trace,
+              "Forget recorded events (call after stop())");
+    trace.def("dump", &worker::dump_trace, pybind11::arg("path"), R"pbdoc(
+Write the recorded events to 'path' as trace-event JSON.
+
+Returns the number of trace events written.
+)pbdoc");
+    return module;
+}
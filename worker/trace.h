@@ -0,0 +1,120 @@
+#ifndef WORKER_TRACE_H
+#define WORKER_TRACE_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+#include "state.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace worker
+{
+    ///
+    /// \brief What a trace event records.
+    ///
+    enum class trace_kind : std::uint32_t
+    {
+        launch,     ///< A job was launched (id is the job)
+        state,      ///< A job entered 'detail' (a worker::state)
+        abort,      ///< Somebody asked a job to abort
+        wait_begin, ///< A thread started waiting for jobs
+        wait_end    ///< ...and stopped
+    };
+
+    /// @brief Set while tracing.  Read through tracing().
+    extern std::atomic<bool> trace_enabled;
+
+    /**
+     * @brief True if trace events should be recorded.  On the hot
+     *        path, this relaxed load and its branch are the whole
+     *        cost of tracing when it is off.
+     */
+    inline bool tracing()
+    {
+        return trace_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Append an event to this thread's buffer, timestamped now.
+     *        Lock-free.  Call only if tracing() is true.
+     * @param kind What happened.
+     * @param id The job it happened to (any unique address), or null.
+     * @param detail Kind-specific (the state for trace_kind::state).
+     */
+    void trace_event(trace_kind kind, const void *id,
+                     std::uint32_t detail = 0);
+
+    /// @brief Start recording (keeps anything already recorded).
+    void start_tracing();
+    /// @brief Stop recording.
+    void stop_tracing();
+    /// @brief Forget recorded events.  Call after stop_tracing().
+    void clear_trace();
+
+    /**
+     * @brief Write recorded events as Chrome trace-event JSON, for
+     *        chrome://tracing or https://ui.perfetto.dev.
+     * @return The number of events written.
+     */
+    std::size_t dump_trace(const std::string &path);
+
+    ///
+    /// \brief Traces a wait from construction to destruction.
+    ///
+    class trace_wait_scope
+    {
+    public:
+        explicit trace_wait_scope(const void *id = nullptr)
+            : m_id(id), m_traced(tracing())
+        {
+            if (m_traced)
+            {
+                trace_event(trace_kind::wait_begin, m_id);
+            }
+        }
+        ~trace_wait_scope()
+        {
+            if (m_traced)
+            {
+                trace_event(trace_kind::wait_end, m_id);
+            }
+        }
+
+        trace_wait_scope(const trace_wait_scope &) = delete;
+        trace_wait_scope(trace_wait_scope &&) = delete;
+        trace_wait_scope &operator=(const trace_wait_scope &) = delete;
+        trace_wait_scope &operator=(trace_wait_scope &&) = delete;
+
+    private:
+        const void *m_id;
+        bool m_traced;
+    };
+
+    pybind11::module &bind_worker_trace(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_TRACE_H
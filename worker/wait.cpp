@@ -0,0 +1,352 @@
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "wait.h"
+#include "completion.h"
+#include "job.h"
+#include "trace.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct waited_job
+    {
+        pybind11::object object;
+        worker::job::control_ptr_t control;
+    };
+    typedef std::vector<waited_job> waited_jobs_t;
+
+    waited_jobs_t collect_jobs(pybind11::iterable jobs)
+    {
+        waited_jobs_t result;
+        for (auto item : jobs)
+        {
+            auto &job = item.cast<worker::job &>();
+            result.push_back(
+                {pybind11::reinterpret_borrow<pybind11::object>(item),
+                 job.control});
+        }
+        return result;
+    }
+
+    bool is_finished(const waited_job &job)
+    {
+        switch (job.control->state.load())
+        {
+        case worker::state::not_started:
+        case worker::state::setup:
+        case worker::state::working:
+        case worker::state::teardown:
+            break;
+        case worker::state::complete:
+        case worker::state::incomplete:
+            return true;
+        }
+        return false;
+    }
+
+    struct deadline_t
+    {
+        explicit deadline_t(double timeout_in_seconds)
+            : forever(worker::waits_forever(timeout_in_seconds)),
+              at(worker::completion_signal::clock_t::now())
+        {
+            if (!forever)
+            {
+                at += std::chrono::duration_cast<
+                    worker::completion_signal::clock_t::duration>(
+                    std::chrono::duration<double>(timeout_in_seconds));
+            }
+        }
+
+        bool forever;
+        worker::completion_signal::clock_t::time_point at;
+    };
+
+    /**
+     * @brief Wait for done() to return true, or for the deadline.
+     *
+     *        done() is checked once up front and then once each time
+     *        any job finishes.  The caller must release the GIL.
+     *
+     * @return The last result of done().
+     */
+    template <typename Predicate>
+    bool wait_until(Predicate done, const deadline_t &deadline)
+    {
+        worker::trace_wait_scope traced;
+        auto &signal = worker::job_completions();
+        while (true)
+        {
+            const auto seen = signal.generation();
+            if (done())
+            {
+                return true;
+            }
+            if (deadline.forever)
+            {
+                signal.wait(seen);
+            }
+            else if (!signal.wait_until(seen, deadline.at))
+            {
+                return done();
+            }
+        }
+    }
+
+    bool wait_all(pybind11::iterable jobs, pybind11::object timeout)
+    {
+        const auto waited = collect_jobs(jobs);
+        const deadline_t deadline(worker::to_timeout_in_seconds(timeout));
+
+        pybind11::gil_scoped_release release;
+        // Jobs never become unfinished again, so skip past the
+        // finished ones rather than checking them every time.
+        std::size_t next = 0;
+        return wait_until(
+            [&] {
+                while (next < waited.size() && is_finished(waited[next]))
+                {
+                    ++next;
+                }
+                return next == waited.size();
+            },
+            deadline);
+    }
+
+    pybind11::object wait_any(pybind11::iterable jobs,
+                              pybind11::object timeout)
+    {
+        const auto waited = collect_jobs(jobs);
+        const deadline_t deadline(worker::to_timeout_in_seconds(timeout));
+
+        auto found = waited.size();
+        {
+            pybind11::gil_scoped_release release;
+            wait_until(
+                [&] {
+                    for (auto i = std::size_t{0}; i < waited.size(); ++i)
+                    {
+                        if (is_finished(waited[i]))
+                        {
+                            found = i;
+                            return true;
+                        }
+                    }
+                    return false;
+                },
+                deadline);
+        }
+
+        if (found == waited.size())
+        {
+            return pybind11::none();
+        }
+        return waited[found].object;
+    }
+
+    ///
+    /// \brief Python iterator returned by as_completed().
+    ///
+    class completion_iterator
+    {
+    public:
+        completion_iterator(waited_jobs_t jobs, double timeout_in_seconds)
+            : m_pending(std::move(jobs)), m_deadline(timeout_in_seconds)
+        {
+        }
+
+        pybind11::object next()
+        {
+            // One caller at a time.  The holder may be waiting for jobs
+            // without the GIL, so wait for it without the GIL too.
+            std::unique_lock<std::mutex> lock(*m_mutex, std::try_to_lock);
+            if (!lock.owns_lock())
+            {
+                pybind11::gil_scoped_release release;
+                lock.lock();
+            }
+            if (m_ready.empty())
+            {
+                if (m_pending.empty())
+                {
+                    throw pybind11::stop_iteration();
+                }
+                collect_ready();
+            }
+            if (m_ready.empty())
+            {
+                PyErr_SetString(PyExc_TimeoutError,
+                                "as_completed() timed out");
+                throw pybind11::error_already_set();
+            }
+
+            auto result = std::move(m_ready.front());
+            m_ready.pop_front();
+            return result;
+        }
+
+    private:
+        void collect_ready()
+        {
+            std::vector<std::size_t> finished;
+            {
+                pybind11::gil_scoped_release release;
+                wait_until(
+                    [&] {
+                        for (auto i = std::size_t{0}; i < m_pending.size();
+                             ++i)
+                        {
+                            if (is_finished(m_pending[i]))
+                            {
+                                finished.push_back(i);
+                            }
+                        }
+                        return !finished.empty();
+                    },
+                    m_deadline);
+            }
+
+            // Remove from the back so the indexes stay valid.
+            for (auto i = finished.rbegin(); i != finished.rend(); ++i)
+            {
+                m_ready.push_back(std::move(m_pending[*i].object));
+                m_pending[*i] = std::move(m_pending.back());
+                m_pending.pop_back();
+            }
+        }
+
+        waited_jobs_t m_pending;
+        std::deque<pybind11::object> m_ready = {};
+        deadline_t m_deadline;
+        /// @brief Held by next().  A pointer, so that the iterator can
+        ///        be returned by value.
+        std::unique_ptr<std::mutex> m_mutex = std::make_unique<std::mutex>();
+    };
+
+    completion_iterator as_completed(pybind11::iterable jobs,
+                                     pybind11::object timeout)
+    {
+        return completion_iterator(collect_jobs(jobs),
+                                   worker::to_timeout_in_seconds(timeout));
+    }
+}
+
+worker::completion_signal &worker::job_completions()
+{
+    static completion_signal result;
+    return result;
+}
+
+bool worker::waits_forever(double timeout_in_seconds)
+{
+    // About 30 years.  Longer timeouts overflow the clocks' durations
+    // (and time points) when converted.
+    const auto longest = 1e9;
+    return !(0.0 <= timeout_in_seconds && timeout_in_seconds <= longest);
+}
+
+double worker::to_timeout_in_seconds(pybind11::handle timeout)
+{
+    if (timeout.is_none())
+    {
+        return -1.0;
+    }
+    if (pybind11::hasattr(timeout, "total_seconds"))
+    {
+        // datetime.timedelta
+        return timeout.attr("total_seconds")().cast<double>();
+    }
+    return timeout.cast<double>();
+}
+
+pybind11::module &worker::bind_worker_wait(pybind11::module &module)
+{
+    pybind11::class_<completion_iterator>(module, "_CompletionIterator")
+        .def("__iter__", [](pybind11::object self) { return self; })
+        .def("__next__", &completion_iterator::next);
+
+    module.def("wait_all", &wait_all, R"pbdoc(
+Wait for every Job in an iterable to finish.
+
+The GIL is released while waiting, so other Python threads keep
+running.
+
+Parameters
+----------
+jobs: Iterable of Job objects.
+timeout: None (the default) to wait forever, a number of seconds
+  (fractions allowed), or a datetime.timedelta.
+
+Returns
+----------
+True if all the Jobs finished before the timeout.
+)pbdoc",
+               pybind11::arg("jobs"),
+               pybind11::arg("timeout") = pybind11::none());
+
+    module.def("wait_any", &wait_any, R"pbdoc(
+Wait for any Job in an iterable to finish.
+
+The GIL is released while waiting, so other Python threads keep
+running.
+
+Parameters
+----------
+jobs: Iterable of Job objects.
+timeout: None (the default) to wait forever, a number of seconds
+  (fractions allowed), or a datetime.timedelta.
+
+Returns
+----------
+A finished Job, or None if none finished before the timeout.
+)pbdoc",
+               pybind11::arg("jobs"),
+               pybind11::arg("timeout") = pybind11::none());
+
+    module.def("as_completed", &as_completed, R"pbdoc(
+Iterate over Jobs as they finish, like concurrent.futures.as_completed.
+
+The GIL is released while waiting for the next Job.
+
+Parameters
+----------
+jobs: Iterable of Job objects.
+timeout: None (the default) to wait forever, a number of seconds
+  (fractions allowed), or a datetime.timedelta.  This limits the
+  whole iteration, measured from the call to as_completed().
+
+Returns
+----------
+An iterator that yields each Job once it has finished.  It raises
+TimeoutError if the timeout expires with Jobs still running.
+)pbdoc",
+               pybind11::arg("jobs"),
+               pybind11::arg("timeout") = pybind11::none());
+
+    return module;
+}
@@ -0,0 +1,49 @@
+#ifndef WORKER_WAIT_H
+#define WORKER_WAIT_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include "include_pybind11.h"
+
+namespace worker
+{
+    /**
+     * @brief Convert a Python timeout value to seconds.
+     * @param timeout None (wait forever), a number of seconds
+     *        (fractions allowed), or a datetime.timedelta.
+     * @return The timeout in seconds.  Negative means forever.
+     */
+    double to_timeout_in_seconds(pybind11::handle timeout);
+
+    /**
+     * @brief Return true if a timeout in seconds means waiting
+     *        forever: negative, infinite, not a number, or too long
+     *        for the clocks to represent.
+     */
+    bool waits_forever(double timeout_in_seconds);
+
+    pybind11::module &bind_worker_wait(pybind11::module &module);
+
+} // end namespace worker
+
+#endif // WORKER_WAIT_H
@@ -0,0 +1,206 @@
+#ifndef WORKER_WORK_STEALING_DEQUE_H
+#define WORKER_WORK_STEALING_DEQUE_H
+// ------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2018 after5cst
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ------------------------------------------------------------------
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace worker
+{
+    ///
+    /// \brief Lock-free work-stealing deque of pointers.
+    ///
+    /// This is the Chase-Lev deque, using the C11 memory orderings
+    /// from "Correct and Efficient Work-Stealing for Weak Memory
+    /// Models" (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+    ///
+    /// Only the owning thread may call push() and take(), which work
+    /// on the bottom of the deque (LIFO).  Any thread may call
+    /// steal(), which takes from the top (FIFO).  The deque grows as
+    /// needed.  Old buffers are kept until the deque is destroyed,
+    /// because a thief may still be reading from one.
+    ///
+    template <typename T> class work_stealing_deque
+    {
+    public:
+        explicit work_stealing_deque(std::size_t capacity = 256)
+        {
+            m_buffers.emplace_back(new buffer(capacity));
+            m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Add an item to the bottom.  Owner thread only.
+         */
+        void push(T *item)
+        {
+            auto b = m_bottom.load(std::memory_order_relaxed);
+            auto t = m_top.load(std::memory_order_acquire);
+            auto a = m_buffer.load(std::memory_order_relaxed);
+            if (b - t > static_cast<std::int64_t>(a->capacity) - 1)
+            {
+                a = grow(a, t, b);
+            }
+            a->put(b, item);
+            // A release store rather than the paper's release fence
+            // plus relaxed store; same cost, and ThreadSanitizer
+            // understands it.
+            m_bottom.store(b + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Remove an item from the bottom.  Owner thread only.
+         * @return The item, or nullptr if the deque was empty.
+         */
+        T *take()
+        {
+            auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+            auto a = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = m_top.load(std::memory_order_relaxed);
+
+            T *result = nullptr;
+            if (t <= b)
+            {
+                result = a->get(b);
+                if (t == b)
+                {
+                    // Last item, race any thieves for it.
+                    if (!m_top.compare_exchange_strong(
+                            t, t + 1, std::memory_order_seq_cst,
+                            std::memory_order_relaxed))
+                    {
+                        result = nullptr;
+                    }
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        /**
+         * @brief Remove an item from the top.  Any thread.
+         * @return The item, or nullptr if the deque was empty or
+         *        another thread won the race for the item.
+         */
+        T *steal()
+        {
+            auto t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto b = m_bottom.load(std::memory_order_acquire);
+
+            T *result = nullptr;
+            if (t < b)
+            {
+                auto a = m_buffer.load(std::memory_order_acquire);
+                result = a->get(t);
+                if (!m_top.compare_exchange_strong(t, t + 1,
+                                                   std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed))
+                {
+                    result = nullptr;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief Return true if the deque looks empty.  Any thread.
+         *
+         *        The answer may be stale by the time it is used.
+         */
+        bool empty() const
+        {
+            auto b = m_bottom.load(std::memory_order_relaxed);
+            auto t = m_top.load(std::memory_order_relaxed);
+            return b <= t;
+        }
+
+        // The deque is shared by address between threads.
+        work_stealing_deque(const work_stealing_deque &) = delete;
+        work_stealing_deque(work_stealing_deque &&) = delete;
+        work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+        work_stealing_deque &operator=(work_stealing_deque &&) = delete;
+        ~work_stealing_deque() = default;
+
+    private:
+        struct buffer
+        {
+            explicit buffer(std::size_t capacity_)
+                : capacity(capacity_),
+                  items(new std::atomic<T *>[capacity_]())
+            {
+            }
+
+            T *get(std::int64_t index) const
+            {
+                return items[static_cast<std::size_t>(index) % capacity].load(
+                    std::memory_order_relaxed);
+            }
+
+            void put(std::int64_t index, T *item)
+            {
+                items[static_cast<std::size_t>(index) % capacity].store(
+                    item, std::memory_order_relaxed);
+            }
+
+            const std::size_t capacity;
+            std::unique_ptr<std::atomic<T *>[]> items;
+        };
+
+        buffer *grow(buffer *old, std::int64_t top, std::int64_t bottom)
+        {
+            m_buffers.emplace_back(new buffer(old->capacity * 2));
+            auto result = m_buffers.back().get();
+            for (auto i = top; i < bottom; ++i)
+            {
+                result->put(i, old->get(i));
+            }
+            m_buffer.store(result, std::memory_order_release);
+            return result;
+        }
+
+        // Thieves hammer m_top while the owner works on m_bottom, so
+        // keep them on separate cache lines.  (Padding rather than
+        // alignas, since C++14 operator new ignores over-alignment.)
+        std::atomic<std::int64_t> m_top = {0};
+        char m_padding[64] = {};
+        std::atomic<std::int64_t> m_bottom = {0};
+        std::atomic<buffer *> m_buffer = {nullptr};
+
+        /// @brief Every buffer ever used.  Owner thread only.
+        std::vector<std::unique_ptr<buffer>> m_buffers = {};
+    };
+
+} // end namespace worker
+
+#endif // WORKER_WORK_STEALING_DEQUE_H
@@ -1,16 +1,73 @@
 # Set current directory for adding sources
 set (HERE ${CMAKE_CURRENT_LIST_DIR})
 
-target_sources("${PROJECT_NAME}"
-    PRIVATE
+# The worker code is a static library so that native programs (like
+# the gild_bench harness) can link it as well as the Python module.
+add_library(${PROJECT_NAME}_worker STATIC
+    "${HERE}/admission.cpp"
+    "${HERE}/admission.h"
+    "${HERE}/async_channel.cpp"
+    "${HERE}/async_channel.h"
+    "${HERE}/cancellation.h"
+    "${HERE}/completion.h"
+    "${HERE}/dependencies.cpp"
+    "${HERE}/dependencies.h"
+    "${HERE}/dispatcher.cpp"
+    "${HERE}/dispatcher.h"
+    "${HERE}/executor.cpp"
+    "${HERE}/executor.h"
+    "${HERE}/file_scan.cpp"
+    "${HERE}/file_scan.h"
     "${HERE}/init_worker.cpp"
     "${HERE}/init_worker.h"
     "${HERE}/input.h"
     "${HERE}/job.cpp"
     "${HERE}/job.h"
+    "${HERE}/job_group.cpp"
+    "${HERE}/job_group.h"
+    "${HERE}/latch.h"
+    "${HERE}/latency_histogram.cpp"
+    "${HERE}/latency_histogram.h"
     "${HERE}/launch.cpp"
     "${HERE}/launch.h"
+    "${HERE}/metrics.cpp"
+    "${HERE}/metrics.h"
+    "${HERE}/parallel_range.h"
+    "${HERE}/pipeline.cpp"
+    "${HERE}/pipeline.h"
+    "${HERE}/pool_allocator.cpp"
+    "${HERE}/pool_allocator.h"
+    "${HERE}/pool_executor.cpp"
+    "${HERE}/pool_executor.h"
+    "${HERE}/python_job.cpp"
+    "${HERE}/python_job.h"
+    "${HERE}/reduce.cpp"
+    "${HERE}/reduce.h"
+    "${HERE}/reduce_kernels.cpp"
+    "${HERE}/reduce_kernels.h"
+    "${HERE}/result_buffer.h"
+    "${HERE}/ring_buffer.h"
     "${HERE}/runnable.cpp"
     "${HERE}/runnable.h"
     "${HERE}/state.h"
+    "${HERE}/stealing_executor.cpp"
+    "${HERE}/stealing_executor.h"
+    "${HERE}/stream_output.cpp"
+    "${HERE}/stream_output.h"
+    "${HERE}/task_queue.cpp"
+    "${HERE}/task_queue.h"
+    "${HERE}/thread_shards.h"
+    "${HERE}/topology.cpp"
+    "${HERE}/topology.h"
+    "${HERE}/trace.cpp"
+    "${HERE}/trace.h"
+    "${HERE}/wait.cpp"
+    "${HERE}/wait.h"
+    "${HERE}/work_stealing_deque.h"
     )
+
+set_target_properties(${PROJECT_NAME}_worker PROPERTIES
+    CXX_VISIBILITY_PRESET hidden)
+target_link_libraries(${PROJECT_NAME}_worker PUBLIC pybind11::pybind11)
+target_link_libraries("${PROJECT_NAME}" PRIVATE ${PROJECT_NAME}_worker)
+AddClangFormat(${PROJECT_NAME}_worker)